@@ -11,13 +11,14 @@
  ***************************************************************************/
 
 #include "Monitor.h"
+#include <boost/bind.hpp>
 using namespace nrEngine;
 
 //if we are using linux system, then include inotify interface
 
 
 //----------------------------------------------------------------------------------
-Monitor::Monitor(Engine* root) : mRoot(root)
+Monitor::Monitor(Engine* root) : mRoot(root), mDebounceTime(0.25), mResourceGeneration(0), mStopThread(false)
 {
 	setTaskName("DynamicResourceMonitor");
 }
@@ -26,7 +27,7 @@ Monitor::Monitor(Engine* root) : mRoot(root)
 //----------------------------------------------------------------------------------
 Monitor::~Monitor()
 {
-
+	stopThread();
 }
 
 //----------------------------------------------------------------------------------
@@ -39,6 +40,10 @@ Result Monitor::onStartTask()
 		res = initInotify();
 	#endif
 
+	// start the thread loading the changed resources
+	mStopThread = false;
+	mThread.reset(new boost::thread(boost::bind(&Monitor::loadThread, this)));
+
 	init();
 	
 	// nothing supported, so return an error
@@ -48,9 +53,22 @@ Result Monitor::onStartTask()
 //----------------------------------------------------------------------------------
 Result Monitor::stopTask()
 {
+	stopThread();
+
 	// if we support inotify, then do
 	#ifdef USE_INOTIFY
-		mInotify->Close();
+		if (mInotify)
+		{
+			mInotify->Close();
+			mInotify.reset();
+		}
+
+		// release the watches
+		WatcherMap::iterator it = mWatchMap.begin();
+		for (; it != mWatchMap.end(); it++)
+			delete it->second;
+		mWatchMap.clear();
+
 		NR_Log(Log::LOG_PLUGIN, "dynamicResources: Close inotify subsystem");
 	#endif
 	
@@ -58,6 +76,23 @@ Result Monitor::stopTask()
 	return OK;
 }
 
+//----------------------------------------------------------------------------------
+void Monitor::stopThread()
+{
+	if (!mThread) return;
+
+	// wake up the thread and wait until it finishs
+	{
+		boost::mutex::scoped_lock lock(mQueueMutex);
+		mStopThread = true;
+		mQueueCond.notify_all();
+	}
+	mThread->join();
+	mThread.reset();
+
+	mLoadQueue.clear();
+	mLoaded.clear();
+}
 
 //----------------------------------------------------------------------------------
 #ifdef USE_INOTIFY
@@ -84,8 +119,14 @@ Result Monitor::initInotify()
 //----------------------------------------------------------------------------------
 void Monitor::init()
 {
+	// scan only if resources were added or removed since the last scan
+	if (mRoot->sResourceManager()->getResourceMapGeneration() == mResourceGeneration) return;
+
+	// the loader threads change the map, so a copy of it is scanned
+	ResourceManager::ResourceGroupMap res;
+	mRoot->sResourceManager()->getResourceMap(res, mResourceGeneration);
+
 	// now scan through all resources, which are already loaded
-	const ResourceManager::ResourceGroupMap& res = mRoot->sResourceManager()->getResourceMap();
 	ResourceManager::ResourceGroupMap::const_iterator it = res.begin();
 	for (; it != res.end(); it++)
 	{
@@ -96,7 +137,7 @@ void Monitor::init()
 			// get resource according to the handle
 			IResourcePtr pr = mRoot->sResourceManager()->getByHandle(*jt);
 			
-			// resource is valid, so do
+			// resource is valid, so do (resources removed after the map was copied are skipped)
 			if (pr.valid())
 			{
 				// now get the file name associated with the resource 
@@ -110,10 +151,7 @@ void Monitor::init()
 						addMonitor(pr, *kt);
 					}
 				pr.unlockResource();
-			}else{
-				NR_Log(Log::LOG_PLUGIN, Log::LL_WARNING, "dynamicResources: Resource %s seems to be NULL", pr.getBase()->getResourceName().c_str());
 			}
-			
 		}
 	}
 }
@@ -125,38 +163,45 @@ void Monitor::addMonitor(IResourcePtr res, const std::string& file)
 	// do only add a watcher if inotify already initialized
 	if (!mInotify || !res.valid() || file.length() < 1) return;
 	
+	// split the file name into directory and name, files are identified by "directory/name"
+	std::string::size_type pos = file.rfind('/');
+	std::string dir = (pos == std::string::npos) ? std::string(".") : file.substr(0, pos);
+	if (dir.length() == 0) dir = "/";
+	std::string key = dir + "/" + file.substr(pos == std::string::npos ? 0 : pos + 1);
+
 	// we monitor only non-empty resources
 	res.lockResource();
 	{
-		// create a watch descriptor
-		try
+		const std::string& name = res.getBase()->getResourceName();
+
+		// check if the resource is already monitored
+		std::list<std::string>& names = mFiles[key];
+		if (std::find(names.begin(), names.end(), name) == names.end())
 		{
-			// first check if such a watcher already exists
-			InotifyWatch* watch = mInotify->FindWatch(file);
-			
-			if (watch == NULL)
+			// create a watch descriptor
+			try
 			{
-				watch = new InotifyWatch(file, IN_MODIFY);
-				mInotify->Add(watch);
+				// the directory is watched only once for all files in it
+				if (mInotify->FindWatch(dir) == NULL)
+				{
+					InotifyWatch* watch = new InotifyWatch(dir, IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+					mInotify->Add(watch);
+					mWatchMap[watch->GetDescriptor()] = watch;
+
+					NR_LogDebug(Log::LOG_PLUGIN, "dynamicResources: Watch directory %s", dir.c_str());
+				}
+
+				// add new watcher
+				NR_LogDebug(Log::LOG_PLUGIN, "dynamicResources: Monitor %s --> %s", name.c_str(), file.c_str());
+				names.push_back(name);
+
+			}catch(InotifyException& e)
+			{
+				NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: Cannot add a monitor %s --> %s", name.c_str(), file.c_str());
+				NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
+				if (names.size() == 0) mFiles.erase(key);
 			}
-			
-			// add new watcher
-			NR_Log(Log::LOG_PLUGIN, Log::LL_DEBUG, "dynamicResources: Monitor %s --> %s", res.getBase()->getResourceName().c_str(), file.c_str());
-			
-			// add the watcher into the map
-			WatchData data;
-			data.resource = res;
-			data.watcher = watch;
-			data.resourceName = res.getBase()->getResourceName();
-			mWatchMap[watch->GetDescriptor()].push_back(data);
-			
-		}catch(InotifyException& e)
-		{
-			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: Cannot add a monitor %s --> %s", res.getBase()->getResourceName().c_str(), file.c_str());
-			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
-			return;
 		}
-		
 	}
 	res.unlockResource();
 }
@@ -172,75 +217,165 @@ void Monitor::addMonitor(IResourcePtr res, const std::string& file)
 #endif
 
 
-
-#ifdef USE_INOTIFY
 //----------------------------------------------------------------------------------
 Result Monitor::update()
 {
-	if (!mInotify) return OK;
-	
-	//printf("update\n");
-	// wait for inotify events
-	try{
-		mInotify->WaitForEvents(true);
-	}catch(InotifyException& e)
-	{
-		NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: INotify Monitor cannot get events!");
-		NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
-		return OK;
-	}
-	//printf("ok\n");
-	
-	// now extract events until there are no more of them 
-	InotifyEvent event;
-	while(mInotify->GetEventCount() > 0)
+	// monitor resources loaded since last update
+	init();
+
+	float64 now = mRoot->sClock()->getTime();
+
+	#ifdef USE_INOTIFY
+	if (mInotify)
 	{
-		// get event
-		try
+		// read available events, does not block
+		try{
+			mInotify->WaitForEvents(true);
+		}catch(InotifyException& e)
 		{
-			// get event
-			mInotify->GetEvent(&event);
-			std::list<WatchData>& data = mWatchMap[event.GetDescriptor()];
-			
-			// go through a list and update all resource combined with them
-			std::list<WatchData>::iterator it = data.begin();
-			for (; it != data.end(); it++)
+			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: INotify Monitor cannot get events!");
+			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
+			return OK;
+		}
+
+		// now extract events until there are no more of them, only remember the changed files
+		InotifyEvent event;
+		while(mInotify->GetEventCount() > 0)
+		{
+			try
 			{
-				if (it->resource.valid())
-				{
-					// do only reloading on non-empty resources
-					it->resource.lockResource();
-						NR_Log(Log::LOG_PLUGIN, Log::LL_DEBUG, "dynamicResources: Monitored %s resource was modified!", it->resourceName.c_str());
-						//it->resource.getBase()->reload();
-						it->resource.getBase()->setResourceDirty(true);
-					it->resource.unlockResource();
-				}else{
-					NR_Log(Log::LOG_PLUGIN, Log::LL_WARNING, "dynamicResources: Monitored %s resource is not valid!", it->resourceName.c_str());
-				}
-			
+				mInotify->GetEvent(&event);
+			}
+			catch(InotifyException& e)
+			{
+				NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: Cannot retrieve INotify-Event !");
+				NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
+				break;
 			}
+
+			WatcherMap::const_iterator it = mWatchMap.find(event.GetDescriptor());
+			if (it == mWatchMap.end()) continue;
+
+			std::string key = it->second->GetPath() + "/" + event.GetName();
+			if (mFiles.find(key) != mFiles.end()) mChanged[key] = now;
 		}
-		catch(InotifyException& e)
+	}
+	#endif
+
+	// reload files which did not change for the debounce time
+	std::list<std::string> files;
+	ChangeMap::iterator it = mChanged.begin();
+	while (it != mChanged.end())
+	{
+		if (now - it->second >= mDebounceTime)
 		{
-			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: Cannot retrieve INotify-Event !");
-			NR_Log(Log::LOG_PLUGIN, Log::LL_ERROR, "dynamicResources: %s", e.GetMessage().c_str());
-			return OK;
-		}
-		
+			files.push_back(it->first);
+			mChanged.erase(it++);
+		}else
+			it++;
 	}
+	if (files.size()) reloadFiles(files);
+
+	// use resources loaded in the background
+	swapReloaded();
 
-	
 	return OK;
 }
 
+//----------------------------------------------------------------------------------
+void Monitor::reloadFiles(const std::list<std::string>& files)
+{
+	// collect the resources, so each of them is reloaded only once
+	std::set<std::string> names;
+	std::list<std::string>::const_iterator it = files.begin();
+	for (; it != files.end(); it++)
+	{
+		FileMap::const_iterator jt = mFiles.find(*it);
+		if (jt != mFiles.end()) names.insert(jt->second.begin(), jt->second.end());
+	}
+
+	NR_LogDebug(Log::LOG_PLUGIN, "dynamicResources: %d files changed, reload %d resources", (int32)files.size(), (int32)names.size());
+
+	std::set<std::string>::const_iterator kt = names.begin();
+	for (; kt != names.end(); kt++)
+	{
+		IResourcePtr ptr = mRoot->sResourceManager()->getByName(*kt);
+		if (ptr.isNull())
+		{
+			NR_Log(Log::LOG_PLUGIN, Log::LL_WARNING, "dynamicResources: Monitored %s resource is not valid!", kt->c_str());
+			continue;
+		}
+
+		// unloaded resources will read the new files as soon as they are reloaded
+		ptr.lockResource();
+			bool loaded = ptr.getBase()->isResourceLoaded();
+		ptr.unlockResource();
+		if (!loaded) continue;
+
+		// create new instance, current one stays in use until the new one is loaded
+		SharedPtr<IResource> res = mRoot->sResourceManager()->createReloadInstance(*kt);
+		if (!res)
+		{
+			NR_Log(Log::LOG_PLUGIN, Log::LL_WARNING, "dynamicResources: Cannot reload monitored %s resource", kt->c_str());
+			continue;
+		}
+
+		NR_LogDebug(Log::LOG_PLUGIN, "dynamicResources: Monitored %s resource was modified!", kt->c_str());
+
+		if (mRoot->sResourceManager()->supportParallelLoading(res))
+		{
+			boost::mutex::scoped_lock lock(mQueueMutex);
+			mLoadQueue.push_back(res);
+			mQueueCond.notify_one();
+		}else if (mRoot->sResourceManager()->loadReloadInstance(res) == OK)
+		{
+			mRoot->sResourceManager()->swapReloadInstance(res);
+		}
+	}
+}
 
-#else
 //----------------------------------------------------------------------------------
-Result Monitor::update()
+void Monitor::swapReloaded()
 {
-	return OK;
+	// get the loaded instances
+	std::list< SharedPtr<IResource> > loaded;
+	{
+		boost::mutex::scoped_lock lock(mQueueMutex);
+		loaded.swap(mLoaded);
+	}
+
+	// replace the resources, all pointers will use the new instance now
+	std::list< SharedPtr<IResource> >::iterator it = loaded.begin();
+	for (; it != loaded.end(); it++)
+	{
+		if (mRoot->sResourceManager()->swapReloadInstance(*it) != OK)
+			NR_Log(Log::LOG_PLUGIN, Log::LL_WARNING, "dynamicResources: Reloaded %s resource was removed in the meanwhile", (*it)->getResourceName().c_str());
+	}
 }
 
-#endif
+//----------------------------------------------------------------------------------
+void Monitor::loadThread()
+{
+	boost::mutex::scoped_lock lock(mQueueMutex);
 
+	while (!mStopThread)
+	{
+		// wait for new instances to load
+		if (mLoadQueue.size() == 0)
+		{
+			mQueueCond.wait(lock);
+			continue;
+		}
+
+		SharedPtr<IResource> res = mLoadQueue.front();
+		mLoadQueue.pop_front();
+
+		// load the instance through the resource's loader
+		lock.unlock();
+		Result ret = mRoot->sResourceManager()->loadReloadInstance(res);
+		lock.lock();
+
+		if (ret == OK) mLoaded.push_back(res);
+	}
+}
 
@@ -28,9 +28,27 @@ using namespace nrEngine;
 #endif
 
 
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 /**
- * This class does monitor all loaded resources and will notify the 
- * resource loader if file has changed, so that the file could be reloaded.
+ * This class does monitor all loaded resources and reload them if their
+ * files has changed.
+ *
+ * Instead of one watch per file, the directories containing the files are
+ * watched, so thousands of resources do not exceed the system's watch limit.
+ * Changes are not handled at once. Editors fire several events for one save,
+ * so a file is reloaded only if no further change was reported for the
+ * debounce time. All changes collected so far are handled as one batch,
+ * so each resource is reloaded only once.
+ *
+ * Reloading does not block the main thread: a new instance of the resource
+ * is loaded by a background thread through the resource's loader, while the
+ * current instance is still in use. As soon as it is loaded, the task swaps
+ * the new instance into the resource holder, so all resource pointers see
+ * the new data at once. Resources of loaders not supporting parallel loading
+ * are loaded by the task itself.
  **/
 class Monitor : public ITask
 {
@@ -51,6 +69,11 @@ class Monitor : public ITask
 		//! Update the task
 		Result updateTask() { return update();}
 
+		/**
+		 * Set the time in seconds a file must stay unchanged before it is reloaded.
+		 * Default is 0.25 seconds.
+		 **/
+		void setDebounceTime(float64 time) { mDebounceTime = time; }
 
 	private:
 	
@@ -66,24 +89,60 @@ class Monitor : public ITask
 		//! Add new file and associated resource to watch on
 		void addMonitor (IResourcePtr res, const std::string& file);
 
+		//! Reload all resources associated with the changed files
+		void reloadFiles(const std::list<std::string>& files);
+
+		//! Replace resources by the instances loaded in the background
+		void swapReloaded();
+
+		//! Loading thread
+		void loadThread();
+
+		//! Stop the loading thread
+		void stopThread();
+
+		//! Time a file must stay unchanged before it is reloaded
+		float64 mDebounceTime;
+
+		//! Generation of the resource map when the resources were scanned last time
+		uint32 mResourceGeneration;
+
+		//! Monitored files and names of the associated resources
+		typedef std::map<std::string, std::list<std::string> > FileMap;
+		FileMap mFiles;
+
+		//! Changed files and the time of the last change
+		typedef std::map<std::string, float64> ChangeMap;
+		ChangeMap mChanged;
+
+		//! Resource instances to be loaded by the loading thread
+		std::list< SharedPtr<IResource> > mLoadQueue;
+
+		//! Instances loaded by the loading thread
+		std::list< SharedPtr<IResource> > mLoaded;
+
+		//! Mutex to protect the queues
+		boost::mutex mQueueMutex;
+
+		//! Notify the loading thread about new instances
+		boost::condition_variable mQueueCond;
+
+		//! Loading thread
+		SharedPtr<boost::thread> mThread;
+
+		//! True if the loading thread should stop
+		bool mStopThread;
+
 		// We are using inotify interface
 		#ifdef USE_INOTIFY
 		
 			//! file descriptor
 			SharedPtr<Inotify> mInotify;
+
+			//! Map of watch descriptors to the watches of the directories
+			typedef std::map<int, InotifyWatch*> WatcherMap;
 			
-			//! To watch we use this structures
-			typedef struct _WatchData
-			{
-				IResourcePtr resource;
-				InotifyWatch* watcher;
-				std::string resourceName;
-			} WatchData;
-			
-			//! Define map type for appropriate storing of watch descriptors
-			typedef std::map<int, std::list<WatchData> > WatcherMap;
-			
-			//! Here we store the watching descriptors for the files
+			//! Here we store the watching descriptors for the directories
 			WatcherMap mWatchMap;
 			
 			//! Initialize inotify interface
@@ -15,7 +15,6 @@ using namespace nrEngine;
 // Some globals
 //---------------------------------------------------------
 Engine*  mRoot = NULL;
-bool     mThreaded = true;
 SharedPtr<Monitor>  mTask;
 TaskId   mTaskId = 0;
 
@@ -24,7 +23,7 @@ TaskId   mTaskId = 0;
 //---------------------------------------------------------
 extern "C" _PluginExport char* plgVersionString( void )
 {
-	return "Dynamic Resources v0.1 for nrEngine";
+	return "Dynamic Resources v0.2 for nrEngine";
 }
 
 //---------------------------------------------------------
@@ -34,36 +33,33 @@ extern "C" _PluginExport int plgInitialize(Engine* root, PropertyList* args)
 {
 	NR_Log(Log::LOG_PLUGIN, "dynamicResources: %s", plgVersionString());
 
-	// check if we user watn to start the monitor in a thread
+	mRoot = root;
+	mTask.reset(new Monitor(root));
+
+	// check if the user want to change the debounce time
 	if (args)
 	{
-		if (args->exists("isThreade"))
+		if (args->exists("debounceTime"))
 		{
-			Property& prop = (*args)["isThreaded"];
-			NR_Log(Log::LOG_PLUGIN, "dynamicResources: Parameter 'isThreaded' is given, use it!");
+			Property& prop = (*args)["debounceTime"];
+			NR_Log(Log::LOG_PLUGIN, "dynamicResources: Parameter 'debounceTime' is given, use it!");
 			try{
-				mThreaded = prop.get<bool>();
+				mTask->setDebounceTime(prop.get<float64>());
 			}catch(boost::bad_any_cast& err)
 			{
 				if (!prop.hasUserData())
 				{
-					NR_Log(Log::LOG_PLUGIN, "dynamicResources: Parameter 'isThreaded' does not contain valid value nor user data!");
+					NR_Log(Log::LOG_PLUGIN, "dynamicResources: Parameter 'debounceTime' does not contain valid value nor user data!");
 				}else
-					mThreaded = *(static_cast<bool*>(prop.getUserData()));
+					mTask->setDebounceTime(*(static_cast<float64*>(prop.getUserData())));
 			}
 		}
 	
 	}
 		
-	// initilize monitoring task and add it to the kernel
-	mTask.reset(new Monitor(root));
-	if (mThreaded)
-		mTaskId = mRoot->sKernel()->AddTask(mTask, ORDER_LOW, TASK_IS_THREAD);
-	else
-		mTaskId = mRoot->sKernel()->AddTask(mTask, ORDER_LOW);
-	
-	// initialize the new kind of loader
-	mRoot = root;
+	// add monitoring task to the kernel. The task must run in the main thread,
+	// because it swaps the reloaded resources, loading is done in its own thread.
+	mTaskId = mRoot->sKernel()->AddTask(mTask, ORDER_LOW);
 	
 	return 0;	
 }
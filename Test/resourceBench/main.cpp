@@ -0,0 +1,493 @@
+
+#include <nrEngine/nrEngine.h>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace nrEngine;
+
+//----------------------------------------------------------------------------------
+// Benchmark of the resource management. Synthetic resources are written into
+// a directory, loaded through a test loader and the throughput and latency of
+// the ResourceManager operations are measured. The results are written as CSV,
+// one line per phase, so runs can be compared by scripts. Phases timed only as
+// a whole leave the latency columns empty. The console messages of the engine
+// are written to stderr, so the results on stdout contain only the CSV.
+//
+// Usage: resourceBench [-n count] [-s size] [-l lookups] [-t readers] [-d seconds]
+//                      [-a] [-o file]
+//----------------------------------------------------------------------------------
+
+//! Options of the benchmark
+struct Options {
+	int count;
+	int size;
+	int lookups;
+	int readers;
+	double duration;
+	bool arena;
+	const char* output;
+	const char* directory;
+};
+
+static Options opt;
+
+//----------------------------------------------------------------------------------
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+//----------------------------------------------------------------------------------
+// Deterministic random numbers, so all runs do the same work
+//----------------------------------------------------------------------------------
+static uint32 nextRandom(uint32& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+//----------------------------------------------------------------------------------
+static std::string resourceName(int i)
+{
+	char name[32];
+	sprintf(name, "bench%d", i);
+	return name;
+}
+
+//----------------------------------------------------------------------------------
+static std::string fileName(int i)
+{
+	char name[256];
+	sprintf(name, "%s/bench%d.bres", opt.directory, i);
+	return name;
+}
+
+//----------------------------------------------------------------------------------
+// Synthetic resource holding the content of its file
+//----------------------------------------------------------------------------------
+class BenchResource : public IResource
+{
+	public:
+		BenchResource() : IResource("BenchResource"), mData(NULL), mSize(0), mChecksum(0) {}
+		~BenchResource() { unloadResource(); }
+
+		uint32 getChecksum() const { return mChecksum; }
+
+		//! Read the file of the resource into the memory
+		Result read(const std::string& file)
+		{
+			SharedPtr<FileStream> stream = Engine::sFileSystemManager()->open(file);
+			if (stream == NULL) return FILE_NOT_FOUND;
+
+			mSize = stream->size();
+			mData = (byte*)allocateResourceData(mSize);
+			if (mData == NULL) return OUT_OF_MEMORY;
+			stream->read(mData, 1, mSize);
+
+			uint32 sum = 0;
+			for (size_t i = 0; i < mSize; i += 64) sum += mData[i];
+			mChecksum = sum;
+
+			setResourceDataSize(mSize);
+			return OK;
+		}
+
+		Result unloadResource()
+		{
+			freeResourceData(mData);
+			mData = NULL;
+			mSize = 0;
+			markResourceUnloaded();
+			return OK;
+		}
+
+		Result reloadResource(PropertyList* params)
+		{
+			if (getResourceFilenameList().size() == 0) return RES_ERROR;
+			Result ret = read(getResourceFilenameList().front());
+			if (ret == OK) markResourceLoaded();
+			return ret;
+		}
+
+	private:
+		byte* mData;
+		size_t mSize;
+		uint32 mChecksum;
+};
+
+//----------------------------------------------------------------------------------
+// Loader of the synthetic resources
+//----------------------------------------------------------------------------------
+class BenchLoader : public IResourceLoader
+{
+	public:
+		BenchLoader() : IResourceLoader("BenchLoader") { initializeResourceLoader(); }
+
+		Result initializeResourceLoader()
+		{
+			declareSupportedResourceType("BenchResource");
+			declareSupportedFileType("bres");
+			declareTypeMap("bres", "BenchResource");
+			return OK;
+		}
+
+		bool supportParallelLoading() const { return true; }
+
+	protected:
+		IResource* createResource(const std::string& resourceType, PropertyList* params)
+		{
+			return new BenchResource();
+		}
+
+		IResource* createEmptyResource(const std::string& resourceType)
+		{
+			return new BenchResource();
+		}
+
+		Result loadResource(IResource* res, const std::string& file, PropertyList* params)
+		{
+			return ((BenchResource*)res)->read(file);
+		}
+};
+
+//----------------------------------------------------------------------------------
+// Latencies of one phase
+//----------------------------------------------------------------------------------
+struct Phase {
+	std::string name;
+	std::vector<double> latency;
+	double seconds;
+
+	//! Count of operations of a phase without latencies
+	size_t ops;
+
+	Phase(const std::string& n) : name(n), seconds(0), ops(0) {}
+};
+
+static FILE* out = stdout;
+
+//----------------------------------------------------------------------------------
+static double percentile(const std::vector<double>& sorted, double part)
+{
+	if (sorted.size() == 0) return 0;
+	size_t i = (size_t)(part * (double)(sorted.size() - 1) + 0.5);
+	return sorted[i];
+}
+
+//----------------------------------------------------------------------------------
+static void report(Phase& p)
+{
+	std::sort(p.latency.begin(), p.latency.end());
+
+	double sum = 0;
+	for (size_t i = 0; i < p.latency.size(); i++) sum += p.latency[i];
+
+	size_t ops = p.latency.size();
+	if (ops == 0)
+	{
+		fprintf(out, "%s,%d,%.6f,%.1f,,,,,\n",
+			p.name.c_str(), (int)p.ops, p.seconds,
+			p.seconds > 0 ? (double)p.ops / p.seconds : 0.0);
+		fflush(out);
+		return;
+	}
+
+	fprintf(out, "%s,%d,%.6f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+		p.name.c_str(), (int)ops, p.seconds,
+		p.seconds > 0 ? (double)ops / p.seconds : 0.0,
+		ops ? sum / (double)ops * 1e6 : 0.0,
+		percentile(p.latency, 0.5) * 1e6,
+		percentile(p.latency, 0.95) * 1e6,
+		percentile(p.latency, 0.99) * 1e6,
+		ops ? p.latency.back() * 1e6 : 0.0);
+	fflush(out);
+}
+
+//----------------------------------------------------------------------------------
+static bool createFiles()
+{
+	mkdir(opt.directory, 0755);
+
+	std::vector<char> data(opt.size);
+	uint32 state = 1;
+	for (int i = 0; i < opt.count; i++)
+	{
+		for (int j = 0; j < opt.size; j++) data[j] = (char)nextRandom(state);
+
+		FILE* file = fopen(fileName(i).c_str(), "wb");
+		if (file == NULL) return false;
+		fwrite(&data[0], 1, data.size(), file);
+		fclose(file);
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------
+static void removeFiles()
+{
+	for (int i = 0; i < opt.count; i++) remove(fileName(i).c_str());
+	rmdir(opt.directory);
+}
+
+//----------------------------------------------------------------------------------
+// Reader of the mixed workload, looks up random resources and touches them
+//----------------------------------------------------------------------------------
+static volatile bool running = false;
+
+static void reader(int id, std::vector<double>* latency)
+{
+	ResourceManager* rm = Engine::sResourceManager();
+	uint32 state = 100 + id;
+	uint32 sum = 0;
+
+	while (running)
+	{
+		std::string name = resourceName(nextRandom(state) % opt.count);
+		double start = now();
+		ResourcePtr<BenchResource> res = rm->getByName(name);
+		sum += res->getChecksum();
+		latency->push_back(now() - start);
+	}
+
+	// keep the compiler from dropping the accesses
+	if (sum == 1) printf(" ");
+}
+
+//----------------------------------------------------------------------------------
+static void usage()
+{
+	printf("Usage: resourceBench [options]\n");
+	printf("  -n count    count of resources (default 1000)\n");
+	printf("  -s size     size of a resource in bytes (default 4096)\n");
+	printf("  -l lookups  count of lookups by name (default 100000)\n");
+	printf("  -t readers  count of reader threads of the mixed workload (default 4)\n");
+	printf("  -d seconds  duration of the mixed workload (default 2)\n");
+	printf("  -a          allocate the resource data from a group arena\n");
+	printf("  -o file     write the results into the file instead of stdout\n");
+}
+
+//----------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	opt.count = 1000;
+	opt.size = 4096;
+	opt.lookups = 100000;
+	opt.readers = 4;
+	opt.duration = 2.0;
+	opt.arena = false;
+	opt.output = NULL;
+	opt.directory = "benchData";
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-a") { opt.arena = true; continue; }
+		if (i + 1 >= argc) { usage(); return 1; }
+
+		if (arg == "-n") opt.count = atoi(argv[++i]);
+		else if (arg == "-s") opt.size = atoi(argv[++i]);
+		else if (arg == "-l") opt.lookups = atoi(argv[++i]);
+		else if (arg == "-t") opt.readers = atoi(argv[++i]);
+		else if (arg == "-d") opt.duration = atof(argv[++i]);
+		else if (arg == "-o") opt.output = argv[++i];
+		else { usage(); return 1; }
+	}
+	if (opt.count <= 0 || opt.size <= 0) { usage(); return 1; }
+
+	if (opt.output){
+		out = fopen(opt.output, "w");
+		if (out == NULL) { printf("Can not open %s\n", opt.output); return 1; }
+	}
+
+	if (!createFiles()) { printf("Can not create the resource files in %s\n", opt.directory); return 1; }
+
+	// the engine writes its console messages to stdout, so the results get
+	// the original stdout and the messages are moved to stderr
+	if (out == stdout){
+		out = fdopen(dup(fileno(stdout)), "w");
+		if (out == NULL) { printf("Can not duplicate stdout\n"); return 1; }
+	}
+	fflush(stdout);
+	dup2(fileno(stderr), fileno(stdout));
+
+	Engine::sEngine()->initializeLog("./");
+	Engine::sEngine()->initializeEngine();
+
+	ResourceManager* rm = Engine::sResourceManager();
+	rm->registerLoader("BenchLoader", ResourceLoader(new BenchLoader()));
+	if (opt.arena) rm->enableGroupArena("bench");
+
+	fprintf(out, "# count=%d size=%d lookups=%d readers=%d duration=%.1f arena=%d\n",
+		opt.count, opt.size, opt.lookups, opt.readers, opt.duration, (int)opt.arena);
+	fprintf(out, "phase,ops,seconds,ops_per_sec,mean_us,p50_us,p95_us,p99_us,max_us\n");
+
+	// load all resources
+	{
+		Phase p("loadResource");
+		double begin = now();
+		for (int i = 0; i < opt.count; i++)
+		{
+			double start = now();
+			rm->loadResource(resourceName(i), "bench", fileName(i));
+			p.latency.push_back(now() - start);
+		}
+		p.seconds = now() - begin;
+		report(p);
+	}
+
+	// look them up by name
+	{
+		Phase p("getByName");
+		p.latency.reserve(opt.lookups);
+		uint32 state = 7;
+		double begin = now();
+		for (int i = 0; i < opt.lookups; i++)
+		{
+			std::string name = resourceName(nextRandom(state) % opt.count);
+			double start = now();
+			rm->getByName(name);
+			p.latency.push_back(now() - start);
+		}
+		p.seconds = now() - begin;
+		report(p);
+	}
+
+	// access resources through pointers resolved once, the way the application
+	// holds them, first with the plain pointers then with the cached ones
+	{
+		std::vector< ResourcePtr<BenchResource> > plain;
+		std::vector< CachedResourcePtr<BenchResource> > cached;
+		for (int i = 0; i < opt.count; i++)
+		{
+			IResourcePtr res = rm->getByName(resourceName(i));
+			plain.push_back(res);
+			cached.push_back(res);
+		}
+
+		uint32 sum = 0;
+		Phase p("ptrAccess");
+		p.latency.reserve(opt.lookups);
+		uint32 state = 11;
+		double begin = now();
+		for (int i = 0; i < opt.lookups; i++)
+		{
+			ResourcePtr<BenchResource>& res = plain[nextRandom(state) % opt.count];
+			double start = now();
+			sum += res->getChecksum();
+			p.latency.push_back(now() - start);
+		}
+		p.seconds = now() - begin;
+		report(p);
+
+		Phase c("cachedAccess");
+		c.latency.reserve(opt.lookups);
+		state = 11;
+		begin = now();
+		for (int i = 0; i < opt.lookups; i++)
+		{
+			CachedResourcePtr<BenchResource>& res = cached[nextRandom(state) % opt.count];
+			double start = now();
+			sum += res->getChecksum();
+			c.latency.push_back(now() - start);
+		}
+		c.seconds = now() - begin;
+		report(c);
+
+		// keep the compiler from dropping the accesses
+		if (sum == 1) printf(" ");
+	}
+
+	// lock and unlock each resource
+	{
+		Phase p("lockUnlock");
+		double begin = now();
+		for (int i = 0; i < opt.count; i++)
+		{
+			std::string name = resourceName(i);
+			double start = now();
+			rm->lockResource(name);
+			rm->unlockResource(name);
+			p.latency.push_back(now() - start);
+		}
+		p.seconds = now() - begin;
+		report(p);
+	}
+
+	// reload each resource
+	{
+		Phase p("reload");
+		double begin = now();
+		for (int i = 0; i < opt.count; i++)
+		{
+			double start = now();
+			rm->reload(resourceName(i));
+			p.latency.push_back(now() - start);
+		}
+		p.seconds = now() - begin;
+		report(p);
+	}
+
+	// readers look up resources, while new resources are loaded and removed
+	{
+		Phase p("mixedRead");
+		Phase w("mixedLoad");
+
+		std::vector< std::vector<double> > latency(opt.readers);
+		boost::thread_group threads;
+		running = true;
+		for (int i = 0; i < opt.readers; i++)
+			threads.create_thread(boost::bind(reader, i, &latency[i]));
+
+		double begin = now();
+		int round = 0;
+		while (now() - begin < opt.duration)
+		{
+			int i = round % opt.count;
+			char name[32];
+			sprintf(name, "mixed%d", round++);
+
+			double start = now();
+			rm->loadResource(name, "mixed", fileName(i));
+			w.latency.push_back(now() - start);
+
+			// keep the count of the mixed resources small
+			if (round % 64 == 0) rm->removeGroup("mixed");
+		}
+		running = false;
+		threads.join_all();
+		p.seconds = w.seconds = now() - begin;
+		rm->removeGroup("mixed");
+
+		for (int i = 0; i < opt.readers; i++)
+			p.latency.insert(p.latency.end(), latency[i].begin(), latency[i].end());
+
+		report(p);
+		report(w);
+	}
+
+	// remove all resources at once
+	{
+		Phase p("removeGroup");
+		double start = now();
+		rm->removeGroup("bench");
+		p.seconds = now() - start;
+
+		// the resources are removed by one call, so only the time of all is known
+		p.ops = opt.count;
+		report(p);
+	}
+
+	Engine::release();
+	removeFiles();
+
+	fclose(out);
+
+	return 0;
+}
+
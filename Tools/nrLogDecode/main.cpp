@@ -0,0 +1,174 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * nrLogDecode - decode a binary log stream written by Log::setBinary().
+ *
+ * Usage: nrLogDecode [-j] stream.nrlog [output]
+ *	-j		Write one JSON object per message instead of text lines
+ *
+ * The messages are written to the output file or to the standard output.
+ **/
+
+#include <nrEngine/nrEngine.h>
+#include <nrEngine/BinaryLog.h>
+#include <time.h>
+
+using namespace nrEngine;
+
+//----------------------------------------------------------------------------------
+const char* levelName(int32 level)
+{
+	switch (level){
+		case Log::LL_FATAL_ERROR: return "FatalError";
+		case Log::LL_ERROR: return "Error";
+		case Log::LL_WARNING: return "Warning";
+		case Log::LL_NORMAL: return "Log";
+		case Log::LL_DEBUG: return "Debug";
+		case Log::LL_CHATTY: return "Info";
+		default: return "";
+	}
+}
+
+//----------------------------------------------------------------------------------
+std::string targetNames(uint32 target)
+{
+	static const char* names[] = {"client", "server", "app", "kernel", "engine", "console", "plugin"};
+
+	std::string res;
+	for (uint32 i=0; i < sizeof(names) / sizeof(names[0]); i++){
+		if (!(target & (1 << i))) continue;
+		if (res.length()) res += ",";
+		res += names[i];
+	}
+	return res;
+}
+
+//----------------------------------------------------------------------------------
+std::string jsonString(const std::string& str)
+{
+	std::string res = "\"";
+	for (size_t i=0; i < str.length(); i++){
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\'){
+			res += '\\';
+			res += c;
+		}else if (c < 0x20){
+			char buf[8];
+			sprintf(buf, "\\u%04x", c);
+			res += buf;
+		}else{
+			res += c;
+		}
+	}
+	return res + "\"";
+}
+
+//----------------------------------------------------------------------------------
+void writeText(FILE* out, const BinaryLogSite& site, const BinaryLogRecord& record)
+{
+	time_t sec = (time_t)(record.time / 1000000);
+	struct tm timeBuf;
+	tm* t = localtime_r(&sec, &timeBuf);
+
+	fprintf(out, "%02d:%02d:%02d.%06d [%d] %s (%s): %s\n",
+		t ? t->tm_hour : 0, t ? t->tm_min : 0, t ? t->tm_sec : 0, (int)(record.time % 1000000),
+		record.thread, levelName(record.level), targetNames(record.target).c_str(),
+		BinaryLog::format(site, record).c_str());
+}
+
+//----------------------------------------------------------------------------------
+void writeJson(FILE* out, const BinaryLogSite& site, const BinaryLogRecord& record)
+{
+	fprintf(out, "{\"time\":%lld,\"thread\":%d,\"level\":\"%s\",\"targets\":\"%s\",\"site\":%d,\"format\":%s,\"args\":[",
+		(long long)record.time, record.thread, levelName(record.level), targetNames(record.target).c_str(),
+		site.id, jsonString(site.format).c_str());
+
+	// the arguments are written with their stored values
+	std::vector<BinaryLogValue> values;
+	BinaryLog::decode(site, record, values);
+	for (size_t i=0; i < values.size(); i++){
+		if (i) fputc(',', out);
+		const BinaryLogValue& v = values[i];
+		if (v.type == 's')
+			fputs(jsonString(v.s).c_str(), out);
+		else if (v.type == 'd' || v.type == 'D')
+			fprintf(out, "%.17g", v.d);
+		else
+			fprintf(out, "%lld", (long long)v.i);
+	}
+
+	fprintf(out, "],\"message\":%s}\n", jsonString(BinaryLog::format(site, record)).c_str());
+}
+
+//----------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	bool json = false;
+
+	// parse options
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++){
+		std::string opt = argv[arg];
+		if (opt == "-j") json = true;
+		else{
+			fprintf(stderr, "nrLogDecode: Unknown option %s\n", opt.c_str());
+			return 1;
+		}
+	}
+
+	if (argc - arg < 1 || argc - arg > 2){
+		fprintf(stderr, "Usage: %s [-j] stream.nrlog [output]\n", argv[0]);
+		return 1;
+	}
+
+	BinaryLogReader reader;
+	Result ret = reader.open(argv[arg]);
+	if (ret != OK){
+		fprintf(stderr, "nrLogDecode: %s is %s\n", argv[arg], ret == FILE_NOT_FOUND ? "not found" : "not a binary log stream");
+		return 1;
+	}
+
+	FILE* out = stdout;
+	if (argc - arg == 2){
+		out = fopen(argv[arg + 1], "w");
+		if (out == NULL){
+			fprintf(stderr, "nrLogDecode: Can not create %s\n", argv[arg + 1]);
+			return 1;
+		}
+	}
+
+	// decode all messages, records of unknown sites are counted only
+	BinaryLogRecord record;
+	uint32 count = 0, unknown = 0;
+	while (reader.next(record)){
+		const BinaryLogSite* site = reader.getSite(record.site);
+		if (site == NULL){
+			unknown++;
+			continue;
+		}
+
+		if (json)
+			writeJson(out, *site, record);
+		else
+			writeText(out, *site, record);
+		count++;
+	}
+
+	if (out != stdout) fclose(out);
+
+	fprintf(stderr, "nrLogDecode: %d messages decoded", count);
+	if (unknown) fprintf(stderr, ", %d messages of unknown sites skipped", unknown);
+	fprintf(stderr, "\n");
+
+	return 0;
+}
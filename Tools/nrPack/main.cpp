@@ -0,0 +1,200 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * nrPack - pack files into an archive readable by ArchiveFileSystem.
+ *
+ * Usage: nrPack [-a alignment] [-z] [-m minsize] archive.pak directory [directory ...]
+ *	-a alignment	Align entry data to this number of bytes (power of two, default 16)
+ *	-z				Compress the entries with zlib if it makes them smaller
+ *	-m minsize		Do not compress files smaller than minsize bytes (default 512)
+ *
+ * Files are stored with their path relative to the given directory.
+ **/
+
+#include <nrEngine/nrEngine.h>
+#include <nrEngine/ArchiveFileSystem.h>
+#include <zlib.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+using namespace nrEngine;
+
+//! File which should be packed into the archive
+struct PackFile {
+	std::string name;
+	std::string path;
+	ArchiveEntry entry;
+};
+
+//----------------------------------------------------------------------------------
+bool compareByHash(const PackFile& a, const PackFile& b)
+{
+	if (a.entry.hash != b.entry.hash) return a.entry.hash < b.entry.hash;
+	return a.name < b.name;
+}
+
+//----------------------------------------------------------------------------------
+void collectFiles(const std::string& root, const std::string& relPath, std::vector<PackFile>& files)
+{
+	std::string dirName = relPath.length() ? root + "/" + relPath : root;
+	DIR* dir = opendir(dirName.c_str());
+	if (dir == NULL){
+		fprintf(stderr, "nrPack: Can not open directory %s\n", dirName.c_str());
+		return;
+	}
+
+	struct dirent* ent;
+	while ((ent = readdir(dir)) != NULL){
+		std::string name = ent->d_name;
+		if (name == "." || name == "..") continue;
+
+		std::string rel = relPath.length() ? relPath + "/" + name : name;
+		std::string full = root + "/" + rel;
+
+		struct stat st;
+		if (stat(full.c_str(), &st) != 0) continue;
+
+		if (S_ISDIR(st.st_mode)){
+			collectFiles(root, rel, files);
+		}else if (S_ISREG(st.st_mode)){
+			PackFile file;
+			file.name = rel;
+			file.path = full;
+			files.push_back(file);
+		}
+	}
+	closedir(dir);
+}
+
+//----------------------------------------------------------------------------------
+void writePadding(FILE* out, uint32 alignment)
+{
+	long pos = ftell(out);
+	long pad = (alignment - (pos % alignment)) % alignment;
+	for (long i=0; i < pad; i++) fputc(0, out);
+}
+
+//----------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	uint32 alignment = NR_ARCHIVE_DEFAULT_ALIGNMENT;
+	bool compress = false;
+	size_t minCompressSize = 512;
+
+	// parse options
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++){
+		std::string opt = argv[arg];
+		if (opt == "-a" && arg + 1 < argc) alignment = atoi(argv[++arg]);
+		else if (opt == "-m" && arg + 1 < argc) minCompressSize = atoi(argv[++arg]);
+		else if (opt == "-z") compress = true;
+		else{
+			fprintf(stderr, "nrPack: Unknown option %s\n", opt.c_str());
+			return 1;
+		}
+	}
+
+	if (argc - arg < 2 || alignment == 0 || (alignment & (alignment - 1))){
+		fprintf(stderr, "Usage: %s [-a alignment] [-z] [-m minsize] archive.pak directory [directory ...]\n", argv[0]);
+		return 1;
+	}
+
+	// collect all files to pack
+	std::string archiveName = argv[arg++];
+	std::vector<PackFile> files;
+	for (; arg < argc; arg++){
+		collectFiles(argv[arg], "", files);
+	}
+
+	// compute name hashes and sort the table of contents
+	for (size_t i=0; i < files.size(); i++){
+		memset(&files[i].entry, 0, sizeof(ArchiveEntry));
+		files[i].entry.hash = ArchiveFileSystem::hashName(files[i].name);
+	}
+	std::sort(files.begin(), files.end(), compareByHash);
+
+	FILE* out = fopen(archiveName.c_str(), "wb");
+	if (out == NULL){
+		fprintf(stderr, "nrPack: Can not create %s\n", archiveName.c_str());
+		return 1;
+	}
+
+	// reserve space for the header, it is written at the end
+	ArchiveHeader header;
+	memset(&header, 0, sizeof(header));
+	fwrite(&header, sizeof(header), 1, out);
+
+	// write the data of each file
+	std::string names;
+	uint64 totalSize = 0, storedSize = 0;
+	for (size_t i=0; i < files.size(); i++){
+		ArchiveEntry& entry = files[i].entry;
+
+		std::ifstream file(files[i].path.c_str(), std::ios::in | std::ios::binary);
+		std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		entry.nameOffset = names.length();
+		entry.nameLength = files[i].name.length();
+		entry.size = data.size();
+		names += files[i].name;
+
+		// compress data if this is requested and makes sense
+		std::vector<Bytef> packed;
+		if (compress && data.size() >= minCompressSize){
+			uLongf len = compressBound(data.size());
+			packed.resize(len);
+			if (compress2(&packed[0], &len, (const Bytef*)&data[0], data.size(), Z_BEST_COMPRESSION) == Z_OK && len < data.size()){
+				packed.resize(len);
+				entry.flags |= ArchiveEntry::COMPRESSED;
+			}
+		}
+
+		writePadding(out, alignment);
+		entry.offset = ftell(out);
+		if (entry.flags & ArchiveEntry::COMPRESSED){
+			entry.storedSize = packed.size();
+			fwrite(&packed[0], 1, packed.size(), out);
+		}else{
+			entry.storedSize = data.size();
+			if (data.size()) fwrite(&data[0], 1, data.size(), out);
+		}
+
+		totalSize += entry.size;
+		storedSize += entry.storedSize;
+	}
+
+	// write table of contents and the names
+	writePadding(out, 8);
+	header.tocOffset = ftell(out);
+	for (size_t i=0; i < files.size(); i++){
+		fwrite(&files[i].entry, sizeof(ArchiveEntry), 1, out);
+	}
+	header.namesOffset = ftell(out);
+	header.namesSize = names.length();
+	fwrite(names.data(), 1, names.length(), out);
+
+	// finally write the header
+	header.magic = NR_ARCHIVE_MAGIC;
+	header.version = NR_ARCHIVE_VERSION;
+	header.entryCount = files.size();
+	header.alignment = alignment;
+	fseek(out, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, out);
+	fclose(out);
+
+	printf("nrPack: %d files packed into %s (%llu bytes, %llu stored)\n",
+		(int)files.size(), archiveName.c_str(), (unsigned long long)totalSize, (unsigned long long)storedSize);
+
+	return 0;
+}
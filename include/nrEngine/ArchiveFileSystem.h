@@ -0,0 +1,200 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_ARCHIVE_FILESYSTEM_H_
+#define _NR_ARCHIVE_FILESYSTEM_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "IFileSystem.h"
+
+namespace nrEngine{
+
+	//! Magic number at the beginning of each archive ("NRPK")
+	const uint32 NR_ARCHIVE_MAGIC = 0x4B50524E;
+
+	//! Version of the archive format
+	const uint32 NR_ARCHIVE_VERSION = 1;
+
+	//! Default alignment of the entries in the archive
+	const uint32 NR_ARCHIVE_DEFAULT_ALIGNMENT = 16;
+
+	//! Header of a packed archive file
+	/**
+	 * The archive file has following layout:
+	 *	- header
+	 *	- data of each entry, aligned to the archive alignment
+	 *	- table of contents (array of ArchiveEntry sorted by the name hash)
+	 *	- string table with the names of the entries (not null terminated)
+	 *
+	 * All values are stored in little endian byte order.
+	 * \ingroup vfs
+	 **/
+	struct ArchiveHeader {
+		//! Must be NR_ARCHIVE_MAGIC
+		uint32 magic;
+
+		//! Format version, must be NR_ARCHIVE_VERSION
+		uint32 version;
+
+		//! Number of entries in the table of contents
+		uint32 entryCount;
+
+		//! Alignment in bytes used for the entry data
+		uint32 alignment;
+
+		//! Offset of the table of contents from the beginning of the file
+		uint64 tocOffset;
+
+		//! Offset of the string table
+		uint64 namesOffset;
+
+		//! Size of the string table in bytes
+		uint64 namesSize;
+	};
+
+	//! Entry in the table of contents of a packed archive
+	/**
+	 * \ingroup vfs
+	 **/
+	struct ArchiveEntry {
+
+		//! Entry flags
+		enum {
+			//! Data of the entry is compressed with zlib
+			COMPRESSED = 1 << 0
+		};
+
+		//! Hash value of the entry name computed by ArchiveFileSystem::hashName()
+		uint32 hash;
+
+		//! Combination of entry flags
+		uint32 flags;
+
+		//! Offset of the name in the string table
+		uint32 nameOffset;
+
+		//! Length of the name in bytes
+		uint32 nameLength;
+
+		//! Offset of the data from the beginning of the file
+		uint64 offset;
+
+		//! Size of the file content (uncompressed)
+		uint64 size;
+
+		//! Size of the data stored in the archive
+		uint64 storedSize;
+	};
+
+
+	//! File system working on packed archive files
+	/**
+	 * This file system provides access to files packed together into one
+	 * archive file (see nrPack tool). The archive is mapped into the memory
+	 * on initialization. Files are looked up through the hashed table of
+	 * contents, so no disk access is needed to find a file. Opening a file
+	 * returns a MemoryStream pointing directly into the mapped archive, so
+	 * uncompressed files are never copied. Compressed files are inflated
+	 * into a new buffer on each open() call.
+	 *
+	 * Names of the files inside the archive are relative paths with '/'
+	 * as separator (e.g. "scripts/init.nrs").
+	 *
+	 * \ingroup vfs
+	 **/
+	class _NRExport ArchiveFileSystem : public IFileSystem{
+		public:
+
+			/**
+			 * Create the file system for the given archive.
+			 * The archive is opened in initialize().
+			 * @param archiveName Path to the archive file on the disk
+			 **/
+			ArchiveFileSystem(const std::string& archiveName);
+
+			//! Release the archive
+			~ArchiveFileSystem();
+
+			//! @copydoc IFileSystem::exists()
+			bool exists(const std::string& fileName);
+
+			//! Names in the archive are case sensitive
+			bool isCaseSensitive() const { return true; }
+
+			//! @copydoc IFileSystem::listFiles()
+			FileInfoListPtr listFiles(bool recursive = true);
+
+			//! @copydoc IFileSystem::findFiles()
+			FileInfoListPtr findFiles(const std::string& pattern, bool recursive = true);
+
+			/**
+			 * Map the archive into the memory and check the table of contents.
+			 * @return either OK or VFS_CANNOT_OPEN if archive is not valid
+			 **/
+			Result initialize();
+
+			/**
+			 * Unmap the archive. Streams which are still opened stay valid
+			 * until they are released.
+			 **/
+			Result deinitialize();
+
+			/**
+			 * Open a file in the archive. Returned stream is of type MemoryStream.
+			 * @copydoc IFileSystem::open()
+			 **/
+			SharedPtr<FileStream> open(const std::string& filename, PropertyList* params = NULL);
+
+			/**
+			 * Compute hash value of a name as used in the table of contents
+			 * (32 bit FNV-1a). The name should be normalized before.
+			 **/
+			static uint32 hashName(const std::string& name);
+
+		private:
+
+			//! Find an entry by its name, returns NULL if not found
+			const ArchiveEntry* findEntry(const std::string& name) const;
+
+			//! Get the name of the given entry
+			std::string getEntryName(const ArchiveEntry& entry) const;
+
+			//! Fill file info of the given entry
+			void fillFileInfo(const ArchiveEntry& entry, FileInfo& info);
+
+			//! Path to the archive
+			std::string mArchiveName;
+
+			//! Mapped archive data, released as soon as no stream use it
+			SharedPtr<byte> mArchive;
+
+			//! Size of the mapped archive
+			size_t mArchiveSize;
+
+			//! Table of contents inside the mapped archive
+			const ArchiveEntry* mEntries;
+
+			//! Number of entries
+			uint32 mEntryCount;
+
+			//! String table inside the mapped archive
+			const char* mNames;
+	};
+
+};
+
+#endif
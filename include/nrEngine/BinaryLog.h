@@ -0,0 +1,228 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_BINARY_LOG_H_
+#define _NR_BINARY_LOG_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include <stdarg.h>
+
+//----------------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------------
+
+//! Magic bytes at the beginning of a binary log stream
+#define NR_BINARY_LOG_MAGIC "nrBinLog"
+
+//! Version of the binary log stream
+#define NR_BINARY_LOG_VERSION 1
+
+namespace nrEngine{
+
+	//! Call site of the binary logging
+	/**
+	 * A call site is registered by the first message logged with its format
+	 * string. The types of the arguments are taken from the conversions of
+	 * the format string, one character per argument:
+	 *		- 'i' int, stored as 32 bit integer
+	 *		- 'l' long, 'q' long long, 'z' size_t, all stored as 64 bit integer
+	 *		- 'd' double, 'D' long double, both stored as 64 bit float
+	 *		- 'p' pointer, stored as 64 bit integer
+	 *		- 's' string, stored as 32 bit length followed by the characters
+	 *
+	 * Format strings with conversions which can not be stored (e.g. a '*'
+	 * width) are marked as text sites. Their messages are formatted at
+	 * the call and stored as string.
+	 *
+	 * \ingroup engine
+	 **/
+	struct BinaryLogSite {
+
+		//! Id of the site in the stream, starting with 1
+		uint32 id;
+
+		//! True if the messages are stored as formatted text
+		bool text;
+
+		//! Types of the arguments
+		std::string args;
+
+		//! Format string of the site
+		std::string format;
+	};
+
+	//! Message of the binary logging
+	/**
+	 * \ingroup engine
+	 **/
+	struct BinaryLogRecord {
+
+		//! Id of the call site
+		uint32 site;
+
+		//! Index of the logging thread, starting with 1
+		uint32 thread;
+
+		//! Log targets of the message
+		uint32 target;
+
+		//! Log level of the message
+		int32 level;
+
+		//! Microseconds since the epoch
+		int64 time;
+
+		//! Stored arguments
+		std::string data;
+	};
+
+	//! Argument decoded from a binary log record
+	/**
+	 * \ingroup engine
+	 **/
+	struct BinaryLogValue {
+
+		//! Type of the argument, see BinaryLogSite
+		char type;
+
+		//! Value of integer and pointer arguments
+		int64 i;
+
+		//! Value of floating point arguments
+		float64 d;
+
+		//! Value of string arguments
+		std::string s;
+	};
+
+	//! Binary logging format, used by the log to write and by tools to read it
+	/**
+	 * The binary stream starts with the magic bytes and the version as 32 bit
+	 * integer. It is followed by chunks, each of them starts with its kind
+	 * (8 bit) and the size of the rest of the chunk (32 bit). The site
+	 * chunks contain the id, the text flag (8 bit), the argument types and the
+	 * format string (both as string). The record chunks contain the site, the
+	 * thread, the target, the level, the time and the stored arguments. A site
+	 * chunk is always written before the first record of the site.
+	 *
+	 * All values are written in the byte order of the logging machine.
+	 *
+	 * \ingroup engine
+	 **/
+	class _NRExport BinaryLog {
+		public:
+
+			//! Kinds of the chunks in the stream
+			enum {
+				CHUNK_SITE = 1,
+				CHUNK_RECORD = 2
+			};
+
+			/**
+			 * Get types of the arguments of a format string.
+			 *
+			 * \param format Format string of the printf family
+			 * \param args Receives one type character per argument
+			 * \return false if the format can not be stored binary
+			 **/
+			static bool parseFormat(const char* format, std::string& args);
+
+			/**
+			 * Store the arguments of a message. Strings are cut, if the arguments
+			 * do not fit into the buffer.
+			 *
+			 * \param args Types of the arguments as returned by parseFormat()
+			 * \param list Arguments of the message
+			 * \param buffer Buffer receiving the stored arguments
+			 * \param size Size of the buffer
+			 * \return count of bytes written into the buffer
+			 **/
+			static uint32 encode(const std::string& args, va_list list, char* buffer, uint32 size);
+
+			/**
+			 * Get the arguments stored by a record.
+			 *
+			 * \return false if the record does not match its site
+			 **/
+			static bool decode(const BinaryLogSite& site, const BinaryLogRecord& record, std::vector<BinaryLogValue>& values);
+
+			/**
+			 * Get the message of a record as text
+			 **/
+			static std::string format(const BinaryLogSite& site, const BinaryLogRecord& record);
+
+			/**
+			 * Write the magic bytes and the version at the beginning of a stream
+			 **/
+			static void writeHeader(std::ostream& stream);
+
+			/**
+			 * Write the chunk of a site
+			 **/
+			static void writeSite(std::ostream& stream, const BinaryLogSite& site);
+
+			/**
+			 * Write the chunk of a record
+			 **/
+			static void writeRecord(std::ostream& stream, const BinaryLogRecord& record);
+
+	};
+
+	//! Reader of binary log streams
+	/**
+	 * \ingroup engine
+	 **/
+	class _NRExport BinaryLogReader {
+		public:
+
+			BinaryLogReader();
+			~BinaryLogReader();
+
+			/**
+			 * Open a binary log stream.
+			 *
+			 * \return either OK or:
+			 *		- FILE_NOT_FOUND if the file can not be opened
+			 *		- FILE_ERROR if the file is not a binary log stream
+			 **/
+			Result open(const std::string& fileName);
+
+			/**
+			 * Read the next record. The sites are read on the way.
+			 *
+			 * \return false at the end of the stream
+			 **/
+			bool next(BinaryLogRecord& record);
+
+			/**
+			 * Get a site read before, NULL if the stream does not contain the site
+			 **/
+			const BinaryLogSite* getSite(uint32 id) const;
+
+		private:
+
+			//! The stream
+			std::ifstream mFile;
+
+			//! Sites read before
+			std::map<uint32, BinaryLogSite> mSites;
+
+	};
+
+}; // end namespace
+
+#endif
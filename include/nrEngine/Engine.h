@@ -135,6 +135,13 @@ namespace nrEngine{
 			* is used to mess the time of execution
 			**/
 			static Profiler* sProfiler();
+
+			/**
+			* Returns a pointer to the registry of the runtime metrics.
+			* The pointer is valid as soon as the engine is created.
+			* @see Metrics
+			**/
+			static Metrics* sMetrics();
 			
 			/**
 			* Returns a pointer to the ressource manager object.
@@ -155,6 +162,11 @@ namespace nrEngine{
 			 * Get instance to the property manager of the engine.
 			 **/
 			static PropertyManager* sPropertyManager();
+
+			/**
+			 * Get the virtual file system manager
+			 **/
+			static FileSystemManager* sFileSystemManager();
 			
 			/**
 			 * Get the singleton instance. Passing the parameter specify
@@ -195,10 +207,12 @@ namespace nrEngine{
 			static Kernel*		_kernel;
 			static Clock*		_clock;
 			static Profiler*	_profiler;
+			static Metrics*		_metrics;
 			static ResourceManager* _resmgr;
 			static ScriptEngine* _script;
 			static EventManager* _event;
 			static PropertyManager* _propmgr;
+			static FileSystemManager* _fsmgr;
 			
 			//! Store pointer to the engine's core singleton object
 			static SharedPtr<Engine> sSingleton;
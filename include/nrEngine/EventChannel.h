@@ -161,6 +161,10 @@ namespace nrEngine{
 			//! Disconnect all actors from the channel
 			void _disconnectAll();
 
+			//! Count of events emitted into the channel and delivered to the actors
+			MetricCounter* mEmitted;
+			MetricCounter* mDelivered;
+
 	};
 	
 }; // end namespace
@@ -19,12 +19,12 @@
 //----------------------------------------------------------------------------------
 #include "Prerequisities.h"
 #include "IFileSystem.h"
+#include <boost/unordered_map.hpp>
+#include <boost/thread/recursive_mutex.hpp>
 
 /**
 * @defgroup vfs Engine's filesystem
 *
-* NOT IMPLEMENTED AT NOW !!!!
-*
 * Files are storing the data needed for apropriate working of the engine and the
 * underlying application. Files could be found on the disk but also on external media
 * like ftp servers or similar things. You can either implement your own file
@@ -113,7 +113,19 @@ namespace nrEngine{
   * you does not notice where the files are readed from.
   *
   * Each certain module should register by this manager so the user get access to the
-  * file sstem provided by the module.
+  * file sstem provided by the module. Each file system is registered with a priority.
+  * If the same file is provided by more than one file system, so the one with the
+  * highest priority wins. This allows to overlay packed archives with local files.
+  *
+  * The manager holds an index of all files provided by the registered file systems.
+  * The index is build on the first access and is stored in a hash map, so
+  * looking for files does not touch the disk. The index is rebuild after file
+  * systems were added or removed. Call rebuildIndex() if files on the disk changes.
+  * The manager can be used from any thread, e.g. by the loader threads of the
+  * resource manager.
+  *
+  * Files which are not known by any file system are opened directly from the disk,
+  * so the manager works also if no file system is registered.
   *
   * \ingroup vfs
   **/
@@ -127,12 +139,17 @@ namespace nrEngine{
 			~FileSystemManager();
 
 			/**
-			 * Register a new file system by the manager.
-			 * The file systems are used to access the files
-			 * 
+			 * Register a new file system by the manager. The file system
+			 * will be initialized by this method.
+			 *
 			 * @param fs Smart pointer on the file system object
+			 * @param priority File systems with higher priority are asked first
+			 * @param name Unique name of the file system. If empty, so the type of
+			 *			the file system is used as name.
+			 * @return either OK or VFS_FS_ALREADY_REGISTERED or an error code
+			 *			returned by IFileSystem::initialize()
 			 **/
-			Result addFilesystem(SharedPtr<IFileSystem> fs);
+			Result addFilesystem(SharedPtr<IFileSystem> fs, int32 priority = 0, const std::string& name = std::string());
 
 			
 			/**
@@ -146,25 +163,100 @@ namespace nrEngine{
 
 			
 			/**
-			 * Get the file system by it's type name.
+			 * Get the file system by it's name.
 			 *
 			 * @param name Name of the file system
 			 **/
 			SharedPtr<IFileSystem> getFilesystem(const std::string& name);
 
-			
 			/**
+			 * Check whenever a file exists in any of the file systems.
+			 * Files not known by the index are looked up on the disk,
+			 * so the method agrees with open().
+			 *
+			 * @param fileName Name of the file. Prefix "name:" can be used to
+			 *			ask only a certain file system
+			 **/
+			bool exists(const std::string& fileName);
+
+			/**
+			 * Get information about a file
+			 * @param fileName Name of the file
+			 * @param info Here the info will be stored
+			 * @return false if the file is not found
+			 **/
+			bool getFileInfo(const std::string& fileName, IFileSystem::FileInfo& info);
+
+			/**
+			 * Find files matching the given pattern in all file systems.
+			 * @see IFileSystem::findFiles()
+			 **/
+			IFileSystem::FileInfoListPtr findFiles(const std::string& pattern, bool recursive = true);
+
+			/**
+			 * List all files known by the file systems
+			 **/
+			IFileSystem::FileInfoListPtr listFiles(bool recursive = true);
+
+			/**
+			 * Open a file. The file is opened by the file system with
+			 * the highest priority containing the file. If no file system
+			 * knows the file, so it is opened directly from the disk.
+			 *
+			 * @param fileName Name of the file (see exists())
+			 * @param params Local parameters passed to the file system
+			 * @return smart pointer on the stream or NULL if file could not be opened
 			 **/
+			SharedPtr<FileStream> open(const std::string& fileName, PropertyList* params = NULL);
 
+			/**
+			 * Resolve a file name to the path on the local disk. If the file
+			 * is provided by a LocalFileSystem, so the path on the disk is
+			 * returned, otherwise the name is returned unchanged.
+			 **/
+			std::string resolve(const std::string& fileName);
+
+			/**
+			 * Rebuild the index of the files. Call this if files were added or
+			 * removed in any of the file systems.
+			 **/
+			void rebuildIndex();
 
 		private:
-			//! Map of registered file systems with their type names
-			typedef std::map< std::string, SharedPtr<IFileSystem> > FilesystemMap;
 
-			FilesystemMap mFilesystems;
+			//! Registered file system
+			struct Mount {
+				std::string name;
+				int32 priority;
+				SharedPtr<IFileSystem> fs;
+			};
+
+			//! List of registered file systems sorted by priority
+			typedef std::list<Mount> MountList;
+			MountList mMounts;
+
+			//! Index of all files
+			typedef boost::unordered_map<std::string, IFileSystem::FileInfo> FileIndex;
+			FileIndex mIndex;
+
+			//! Is the index up to date
+			bool mIndexValid;
+
+			//! Build the index if it is not valid
+			void updateIndex();
+
+			//! Find the file system by name
+			MountList::iterator findMount(const std::string& name);
+
+			//! Split "name:file" into file system and file name. Returns NULL if no prefix given
+			SharedPtr<IFileSystem> splitName(const std::string& fileName, std::string& name);
+
+			//! Find the file in the index. Returns the file system providing the file or NULL
+			SharedPtr<IFileSystem> lookup(const std::string& fileName, IFileSystem::FileInfo& info);
+
+			//! Protects the mounts and the index, files are opened by the loader threads too
+			boost::recursive_mutex mMutex;
 
-			
-			
 	};
 								 
 };
@@ -11,7 +11,7 @@
  ***************************************************************************/
 
 #ifndef __NR_GET_TIME_OF_DAY_H_
-#define __NR_GET_TIME_OF_DAY_H
+#define __NR_GET_TIME_OF_DAY_H_
 
 
 //----------------------------------------------------------------------------------
@@ -36,9 +36,50 @@
    _NRExport int gettimeofday(struct timeval* tv, void* placeholder);
 #else
    #include <sys/time.h>
+   #include <time.h>
 #endif 
 
 //}; // end namespace
 
+namespace nrEngine{
+
+	/**
+	 * Get the time of a monotonic clock in nanoseconds. The clock is not
+	 * changed by adjustments of the system time, so only the difference of two
+	 * values is meaningful. All durations measured by the engine (profiles,
+	 * metrics, resource statistics, task times) are taken from this clock.
+	 * \ingroup time
+	 **/
+	NR_FORCEINLINE uint64 getMonotonicTime()
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64)ts.tv_sec * 1000000000ULL + (uint64)ts.tv_nsec;
+	#else
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return (uint64)tv.tv_sec * 1000000000ULL + (uint64)tv.tv_usec * 1000ULL;
+	#endif
+	}
+
+	/**
+	 * Get the cpu time consumed by the calling thread in nanoseconds, or 0 if
+	 * the platform can not measure it.
+	 * \ingroup time
+	 **/
+	NR_FORCEINLINE uint64 getThreadCpuTime()
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return (uint64)ts.tv_sec * 1000000000ULL + (uint64)ts.tv_nsec;
+	#else
+		return 0;
+	#endif
+	}
+
+}; // end namespace
+
 
 #endif
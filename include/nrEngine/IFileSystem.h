@@ -153,7 +153,23 @@ namespace nrEngine{
 			 * @param value Value of the parameter
 			 **/
 			virtual Result set(const std::string& name, const std::string& value);
-			
+
+			/**
+			 * Check whenever a file name matches to the given pattern.
+			 * Wildcards '*' and '?' are allowed in the pattern.
+			 *
+			 * @param pattern Filename pattern
+			 * @param name Name of the file with '/' as path separator
+			 * @param recursive If false, so '*' does not match the path separator
+			 **/
+			static bool matchPattern(const std::string& pattern, const std::string& name, bool recursive = true);
+
+			/**
+			 * Normalize a file name to the form used by the file systems.
+			 * Backslashes are converted to '/' and leading "./" or '/' removed.
+			 **/
+			static std::string normalizeName(const std::string& name);
+
 		protected:
 
 			//! Unique type name for this file system
@@ -20,9 +20,43 @@
 #include "Prerequisities.h"
 #include "Priority.h"
 #include "IThread.h"
+#include <boost/thread/mutex.hpp>
+
+//! Weight of the last update in the moving averages of the task times
+#define NR_TASK_TIME_SMOOTHING 0.05
 
 namespace nrEngine{
 
+	//! Time consumed by the updates of a task
+	/**
+	 * The kernel measures each update of a task, either done sequentially
+	 * by the kernel or by the thread of a threaded task. The wall clock time
+	 * and the cpu time of the updating thread are measured, so the time a
+	 * task waits (e.g. for a lock or the disk) can be separated from the time it
+	 * computes. All times are given in seconds.
+	 * \ingroup kernel
+	 **/
+	struct _NRExport TaskTimes {
+
+		//! Count of updates
+		uint64 calls;
+
+		//! Moving averages, see NR_TASK_TIME_SMOOTHING
+		float64 wallAverage, cpuAverage;
+
+		//! Maximal times of an update
+		float64 wallMax, cpuMax;
+
+		//! Times of all updates
+		float64 wallTotal, cpuTotal;
+
+		//! Create empty times
+		TaskTimes();
+
+		//! Add the times of an update
+		void add(float64 wall, float64 cpu);
+	};
+
 	/**
 	* Each task is defined through it's unique ID-number. The numbers are used
 	* to access task through the kernel.<br>
@@ -324,6 +358,17 @@ namespace nrEngine{
 		*		-
 		**/
 		Result addTaskDependency(const std::string& name);
+
+		/**
+		 * Get the time consumed by the updates of this task. It can be called
+		 * from any thread.
+		 **/
+		TaskTimes getTaskTimes();
+
+		/**
+		 * Drop the measured times of the updates
+		 **/
+		void resetTaskTimes();
 		
 	protected:
 
@@ -365,6 +410,19 @@ namespace nrEngine{
 		//! Used by the kernel
 		int32	_taskGraphColor;
 
+		//! Profile zone of the task updates, registered on the first update
+		uint32	_taskProfileZone;
+
+		//! Get the profile zone of the task updates
+		uint32 getTaskProfileZone();
+
+		//! Time consumed by the updates, they are read by other threads
+		TaskTimes _taskTimes;
+		boost::mutex _taskTimesMutex;
+
+		//! Update the task and measure the consumed time
+		Result _updateTask();
+
 		//! This list does store all tasks on which one this depends
 		std::list< SharedPtr<ITask> >	_taskDependencies;
 
@@ -34,6 +34,7 @@
 //----------------------------------------------------------------------------------
 #include "Prerequisities.h"
 #include "ITask.h"
+#include "ScriptEngine.h"
 
 
 namespace nrEngine {
@@ -231,6 +232,31 @@ namespace nrEngine {
 		**/
 		SharedPtr<ITask> getTaskByName(const std::string& name);
 
+		/**
+		 * Get the time consumed by the updates of a task. The kernel measures
+		 * the wall clock and the cpu time of each update, also of the updates
+		 * done by the threads of the threaded tasks. The times of the system
+		 * tasks can be read too.
+		 *
+		 * \param id ID of the task
+		 * \param times Receives the times of the task
+		 * \return OK or KERNEL_NO_TASK_FOUND if no such task was found
+		 **/
+		Result getTaskTimes(TaskId id, TaskTimes& times);
+
+		/**
+		 * Drop the measured times of all tasks
+		 **/
+		void resetTaskTimes();
+
+		/**
+		 * Get the times of a task as one line of text, used by the scripts
+		 **/
+		static std::string formatTaskTimes(const std::string& name, const TaskTimes& times);
+
+		//! Print the times of all tasks from scripts, "reset" drops them
+		ScriptFunctionDef(scriptTaskTimes);
+
 	protected:
 
 		//! Here kernel does store all currently running tasks
@@ -397,6 +423,11 @@ namespace nrEngine {
 
 		//! Should kernel send events if states of tasks are changed
 		bool bSendEvents;
+
+		//! Metrics published by the kernel
+		MetricCounter* mTickCount;
+		MetricHistogram* mTickTime;
+		MetricGauge* mTaskCount;
 	};
 
 }; // end Namespace
@@ -0,0 +1,147 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_LINE_READER_H_
+#define _NR_LINE_READER_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include <cstring>
+
+namespace nrEngine{
+
+	//! Buffered reader to read text streams line by line
+	/**
+	 * LineReader reads the data from a stream in large blocks into its own
+	 * buffer and returns the lines as views into this buffer. Hence no
+	 * memory allocation and only one call to the stream per block is done.
+	 * If the stream is a MemoryStream (e.g. mapped file or archive file),
+	 * so the lines are returned directly from the stream memory without
+	 * any copy.
+	 *
+	 * The reader can also be used on a block of memory or on a string.
+	 *
+	 * Example:
+	 * <code>
+	 *	LineReader reader(stream);
+	 *	LineReader::Line line;
+	 *	while (reader.readLine(line))
+	 *		parseLine(line.data, line.length);
+	 * </code>
+	 *
+	 * \ingroup gp
+	 **/
+	class _NRExport LineReader {
+	public:
+
+		//! View on a line inside of the reader's buffer
+		/**
+		 * The view is only valid until the next call of LineReader::readLine()
+		 * or destruction of the reader. The data is not null terminated.
+		 **/
+		struct Line {
+			//! Pointer to the first character of the line
+			const char* data;
+
+			//! Length of the line without the delimiter
+			size_t length;
+
+			//! Create a string containing the line
+			std::string str() const { return std::string(data, length); }
+
+			//! Check whenever the line is empty
+			bool empty() const { return length == 0; }
+		};
+
+		//! Default size of the refill buffer
+		static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+		/**
+		 * Create a reader for the given stream.
+		 * @param stream Stream to read from, must be valid until the reader is released
+		 * @param bufferSize Size of the refill buffer. The buffer grows if a line
+		 *					does not fit into it.
+		 **/
+		LineReader(IStream* stream, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+		/**
+		 * Create a reader working directly on the given memory block.
+		 * @param data Pointer to the text, must be valid until the reader is released
+		 * @param length Length of the text in bytes
+		 **/
+		LineReader(const char* data, size_t length);
+
+		//! Release the buffer
+		~LineReader();
+
+		/**
+		 * Read the next line. If the delimiter is '\\n' so a '\\r' preceding
+		 * the delimiter is removed too (windows line endings).
+		 *
+		 * @param line Here the view on the line will be stored
+		 * @param delim Delimiter character separating the lines
+		 * @return false if there are no more lines
+		 **/
+		bool readLine(Line& line, char delim = '\n');
+
+		/**
+		 * Returns true if all the data was already returned. This can refill
+		 * the buffer, so the last returned line is not valid anymore.
+		 **/
+		bool eof();
+
+		/**
+		 * Get the number of lines readed so far
+		 **/
+		NR_FORCEINLINE uint32 getLineNumber() const { return mLineNumber; }
+
+		/**
+		 * Search for the delimiter character in the given range.
+		 * @return pointer to the delimiter or NULL if not found
+		 **/
+		static NR_FORCEINLINE const char* findDelim(const char* begin, const char* end, char delim)
+		{
+			return (const char*)memchr(begin, delim, end - begin);
+		}
+
+	private:
+
+		//! Refill the buffer from the stream, returns false if nothing was read
+		bool refill();
+
+		//! Stream from which we read, NULL if we work on the memory directly
+		IStream* mStream;
+
+		//! Own buffer used to store the data from the stream
+		char* mBuffer;
+
+		//! Capacity of the own buffer
+		size_t mBufferSize;
+
+		//! Current data window [mBegin, mEnd)
+		const char* mBegin;
+		const char* mEnd;
+
+		//! True if no more data can be read from the stream
+		bool mStreamEnd;
+
+		//! Count of readed lines
+		uint32 mLineNumber;
+	};
+
+}; // end namespace
+
+#endif
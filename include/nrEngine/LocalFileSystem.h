@@ -0,0 +1,88 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_LOCAL_FILESYSTEM_H_
+#define _NR_LOCAL_FILESYSTEM_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "IFileSystem.h"
+
+namespace nrEngine{
+
+	//! File system providing access to a directory on the local disk
+	/**
+	 * The local file system serves the files found under a root directory.
+	 * File names are relative to this directory and use '/' as separator.
+	 * Files are opened as MappedFileStream, so their content is not copied.
+	 *
+	 * The type of this file system is "file".
+	 *
+	 * \ingroup vfs
+	 **/
+	class _NRExport LocalFileSystem : public IFileSystem{
+		public:
+
+			/**
+			 * Create a file system for the given directory.
+			 * @param root Root directory, empty string means current working directory
+			 **/
+			LocalFileSystem(const std::string& root = std::string());
+
+			//! Release the file system
+			~LocalFileSystem();
+
+			//! @copydoc IFileSystem::exists()
+			bool exists(const std::string& fileName);
+
+			//! Local file names are case sensitive on unix systems
+			bool isCaseSensitive() const;
+
+			//! @copydoc IFileSystem::listFiles()
+			FileInfoListPtr listFiles(bool recursive = true);
+
+			//! @copydoc IFileSystem::findFiles()
+			FileInfoListPtr findFiles(const std::string& pattern, bool recursive = true);
+
+			//! Nothing to initialize
+			Result initialize();
+
+			//! Nothing to release
+			Result deinitialize();
+
+			/**
+			 * Open a file. Returned stream is of type MappedFileStream
+			 * @copydoc IFileSystem::open()
+			 **/
+			SharedPtr<FileStream> open(const std::string& filename, PropertyList* params = NULL);
+
+			/**
+			 * Get the path of the file on the disk
+			 **/
+			std::string getRealPath(const std::string& fileName) const;
+
+		private:
+
+			//! Scan the directory and add the files matching the pattern to the list
+			void scanDirectory(const std::string& path, const std::string& pattern, bool recursive, FileInfoList& list);
+
+			//! Root directory ending with '/' or empty
+			std::string mRoot;
+	};
+
+};
+
+#endif
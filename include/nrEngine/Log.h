@@ -25,6 +25,42 @@
 //----------------------------------------------------------------------------------
 #define NR_Log nrEngine::Engine::sLog()->log
 
+/**
+ * Messages with a level above this one are stripped by the compiler. Use the
+ * numbers of Log::LogLevel, i.e. compile with -DNR_LOG_MAX_LEVEL=3 to remove all
+ * debug and chatty messages. By default all levels are compiled.
+ **/
+#ifndef NR_LOG_MAX_LEVEL
+#	define NR_LOG_MAX_LEVEL 5
+#endif
+
+/**
+ * Log a message of the given level. In contrast to NR_Log the level and the
+ * target are checked before the arguments are evaluated and the message
+ * is formatted, so the disabled messages cost only a comparison.
+ **/
+#define NR_LogLevel(target, level, ...) \
+	do { \
+		if ((level) <= NR_LOG_MAX_LEVEL && nrEngine::Engine::sLog()->isLogged((target), (level))) \
+			nrEngine::Engine::sLog()->log((target), (level), __VA_ARGS__); \
+	} while(0)
+
+#define NR_LogError(target, ...) NR_LogLevel(target, nrEngine::Log::LL_ERROR, __VA_ARGS__)
+#define NR_LogWarning(target, ...) NR_LogLevel(target, nrEngine::Log::LL_WARNING, __VA_ARGS__)
+#define NR_LogNormal(target, ...) NR_LogLevel(target, nrEngine::Log::LL_NORMAL, __VA_ARGS__)
+
+#if NR_LOG_MAX_LEVEL >= 4
+#	define NR_LogDebug(target, ...) NR_LogLevel(target, nrEngine::Log::LL_DEBUG, __VA_ARGS__)
+#else
+#	define NR_LogDebug(target, ...) do {} while(0)
+#endif
+
+#if NR_LOG_MAX_LEVEL >= 5
+#	define NR_LogChatty(target, ...) NR_LogLevel(target, nrEngine::Log::LL_CHATTY, __VA_ARGS__)
+#else
+#	define NR_LogChatty(target, ...) do {} while(0)
+#endif
+
 
 namespace nrEngine{
 
@@ -36,6 +72,11 @@ namespace nrEngine{
 	* This guarantee to be log messages not hardcoded and they can also be localized (language). All used
 	* log messages should be stored in an extra file to allow logging by Msg-Id-Number.
 	*
+	* By default each message is written and flushed by the logging thread. With
+	* setAsync() the messages are only formatted by the logging thread and put
+	* into a ring buffer of the thread. A background thread writes them in batches,
+	* so the disk access does not stall the kernel.
+	*
 	* \ingroup engine
 	**/
 	class _NRExport Log{
@@ -136,6 +177,7 @@ namespace nrEngine{
 			**/
 			void setEcho(LogTarget from, LogTarget to){
 				_echoMap[(int32)from] = (int32)to;	
+				if (to) _activeTargets |= from;
 			}
 
 			/**
@@ -147,6 +189,61 @@ namespace nrEngine{
 				_logLevel = logLevel;
 			}
 
+			/**
+			* Enable or disable the asynchronous logging. Asynchronous messages are
+			* formatted into a ring buffer of the logging thread and written by a
+			* background thread. The log files are flushed each flush interval and
+			* as soon as an error is logged. If the buffer of a thread is full, the
+			* thread waits until the messages are written. Disabling the asynchronous
+			* logging writes all pending messages.
+			* \param async True to log asynchronously
+			* \param flushInterval Interval in seconds between two writes of the messages
+			**/
+			void setAsync(bool async, float32 flushInterval = 0.1f);
+
+			/**
+			* Enable or disable the binary logging. Binary messages are not
+			* formatted, only the site of the format string and the arguments
+			* are stored. Each format text is registered as a call site once, the
+			* address of the format is only used to find its site quickly. After
+			* 4096 sites, the messages of new formats are stored as text.
+			* The background thread of the asynchronous logging writes the sites
+			* and the messages into a binary stream, which can be decoded by
+			* BinaryLogReader or by the nrLogDecode tool. While the binary logging
+			* is enabled, all messages are written into the stream only.
+			* \param binary True to log binary
+			* \param fileName Name of the stream file in the log directory
+			* \return either OK or:
+			*			- FILE_ERROR if the stream can not be created
+			**/
+			Result setBinary(bool binary, const std::string& fileName = "binary.nrlog");
+
+			/**
+			* Check whenever the messages are logged binary
+			**/
+			bool isBinary() const;
+
+			/**
+			* Check whenever a message of the given level would be written to
+			* the target. The logging macros check it before the message is formatted.
+			* \param target Target of the message
+			* \param level Level of the message
+			**/
+			NR_FORCEINLINE bool isLogged(LogTarget target, LogLevel level) const {
+				return _bInitialized && level <= _logLevel && (target & _activeTargets);
+			}
+
+			/**
+			* Check whenever the messages are logged asynchronously
+			**/
+			bool isAsync() const;
+
+			/**
+			* Write all pending messages of the asynchronous logging and
+			* flush the log files.
+			**/
+			void flush();
+
 						
 		private:
 
@@ -179,10 +276,29 @@ namespace nrEngine{
 
 			// Log level information
 			LogLevel	_logLevel;
-			
+
+			// targets which are written or echoed
+			LogTarget	_activeTargets;
+
+			// state of the asynchronous logging, defined in the source file
+			struct AsyncLog;
+			SharedPtr<AsyncLog> _async;
+
+			// format the message and log it
+			void logV(LogTarget target, LogLevel level, const char* msg, va_list args);
+
 			// logging function
 			void logIt(int32 target, LogLevel level, const char *msg);
 
+			// write the message to the targets, optionally flush them
+			void writeIt(int32 target, LogLevel level, time_t logTime, const char *msg, bool flush);
+
+			// write the messages of the asynchronous logging
+			void writeAsync();
+
+			// background thread of the asynchronous logging
+			void asyncThread();
+
 			// get log level string
 			std::string getLevelStr(LogLevel level);
 
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_MAPPED_FILE_STREAM_H_
+#define _NR_MAPPED_FILE_STREAM_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "MemoryStream.h"
+
+namespace nrEngine{
+
+	//! File stream which maps the file into the memory
+	/**
+	 * MappedFileStream opens a file by mapping it into the address space
+	 * of the process (mmap). Reading from the stream is just a copy from
+	 * the mapped memory and getData() returns a pointer directly into the
+	 * mapping, so no copy of the file content is ever done by the stream.
+	 *
+	 * The mapping is released as soon as the stream is closed and no
+	 * other object holds a reference on it. On platforms without memory
+	 * mapping support the whole file is read into the memory instead.
+	 *
+	 * \ingroup vfs
+	 **/
+	class _NRExport MappedFileStream : public MemoryStream {
+	public:
+
+		//! Create an empty stream
+		MappedFileStream();
+
+		//! Unmap the file
+		virtual ~MappedFileStream();
+
+		/**
+		 * Open a file by mapping it into the memory.
+		 * @return either OK or FILE_NOT_FOUND
+		 **/
+		virtual Result open (const std::string& fileName);
+
+		/**
+		 * Map a whole file read-only into the memory. The returned pointer
+		 * unmaps the file, as soon as it is not referenced anymore.
+		 *
+		 * @param fileName Name of the file to map
+		 * @param size Here the size of the mapped file will be stored
+		 * @return pointer on the mapped data or empty pointer if error occurs
+		 *			or the file is empty
+		 **/
+		static SharedPtr<byte> map(const std::string& fileName, size_t& size);
+
+	};
+
+}; // end namespace
+
+#endif
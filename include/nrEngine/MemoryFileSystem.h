@@ -0,0 +1,151 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_MEMORY_FILESYSTEM_H_
+#define _NR_MEMORY_FILESYSTEM_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "IFileSystem.h"
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace nrEngine{
+
+	//! File system serving files from the main memory
+	/**
+	 * The memory file system holds the content of its files in the memory.
+	 * Files can be added as a copy of a data block, as a reference to an
+	 * already existing buffer or as a snapshot of a file from the disk.
+	 * Opening a file returns a MemoryStream on the data, so no system calls
+	 * are done by accessing the files.
+	 *
+	 * Use this file system for data which is read very often (e.g. reloaded
+	 * scripts) or to test loaders without any disk access.
+	 *
+	 * The type of this file system is "memory". If the file system is
+	 * registered by the FileSystemManager, so call FileSystemManager::rebuildIndex()
+	 * after adding or removing files.
+	 *
+	 * \ingroup vfs
+	 **/
+	class _NRExport MemoryFileSystem : public IFileSystem{
+		public:
+
+			//! Create an empty memory file system
+			MemoryFileSystem();
+
+			//! Release all files
+			~MemoryFileSystem();
+
+			/**
+			 * Add a file by copying the given data.
+			 *
+			 * @param fileName Name of the file
+			 * @param data Content of the file
+			 * @param size Size of the content in bytes
+			 **/
+			Result addFile(const std::string& fileName, const void* data, size_t size);
+
+			/**
+			 * Add a file working directly on the given buffer. No copy
+			 * of the data is done.
+			 *
+			 * @param fileName Name of the file
+			 * @param holder Owner of the buffer, will be kept alive as long as the file exists
+			 * @param data Pointer to the content of the file
+			 * @param size Size of the content in bytes
+			 **/
+			Result registerBuffer(const std::string& fileName, SharedPtr<byte> holder, const byte* data, size_t size);
+
+			/**
+			 * Read a file from the disk and store its content in the memory.
+			 *
+			 * @param diskFileName Name of the file on the disk
+			 * @param fileName Name of the file in this file system. If empty
+			 *			the name on the disk is used.
+			 * @return either OK or FILE_NOT_FOUND
+			 **/
+			Result snapshot(const std::string& diskFileName, const std::string& fileName = std::string());
+
+			/**
+			 * Read all files found in the directory on the disk into the memory.
+			 * The files are named relative to the directory.
+			 *
+			 * @param directory Directory on the disk
+			 * @param pattern Only files matching this pattern are read
+			 * @return either OK or FILE_NOT_FOUND if a file could not be read
+			 **/
+			Result snapshotDirectory(const std::string& directory, const std::string& pattern = std::string("*"));
+
+			/**
+			 * Remove a file from the file system. Opened streams on the file
+			 * stay valid.
+			 **/
+			Result removeFile(const std::string& fileName);
+
+			//! Remove all files
+			void clear();
+
+			/**
+			 * Get the amount of memory in bytes used by the files
+			 **/
+			size_t getDataSize() const;
+
+			//! @copydoc IFileSystem::exists()
+			bool exists(const std::string& fileName);
+
+			//! Names of the files are case sensitive
+			bool isCaseSensitive() const { return true; }
+
+			//! @copydoc IFileSystem::listFiles()
+			FileInfoListPtr listFiles(bool recursive = true);
+
+			//! @copydoc IFileSystem::findFiles()
+			FileInfoListPtr findFiles(const std::string& pattern, bool recursive = true);
+
+			//! Nothing to initialize
+			Result initialize();
+
+			//! Nothing to release, files stay in the memory until removed
+			Result deinitialize();
+
+			/**
+			 * Open a file. Returned stream is of type MemoryStream
+			 * @copydoc IFileSystem::open()
+			 **/
+			SharedPtr<FileStream> open(const std::string& filename, PropertyList* params = NULL);
+
+		private:
+
+			//! Content of a file
+			struct Blob {
+				SharedPtr<byte> holder;
+				const byte* data;
+				size_t size;
+			};
+
+			//! Map of all files
+			typedef boost::unordered_map<std::string, Blob> FileMap;
+			FileMap mFiles;
+
+			//! Protects the files, they are opened by the loader threads too
+			mutable boost::mutex mMutex;
+	};
+
+};
+
+#endif
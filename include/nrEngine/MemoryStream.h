@@ -0,0 +1,131 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_MEMORY_STREAM_H_
+#define _NR_MEMORY_STREAM_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "FileStream.h"
+
+namespace nrEngine{
+
+	//! File stream working on a block of memory instead of a file on the disk
+	/**
+	 * MemoryStream is a file stream which does not read the data from the disk
+	 * but provide a view on an already existing block of memory. The block
+	 * could be part of a memory mapped archive or a buffer holding decompressed
+	 * data. No data is copied by the stream, so getData() returns a pointer
+	 * directly into the memory block.
+	 *
+	 * The stream holds a shared pointer to the owner of the memory (holder).
+	 * So the memory stays valid as long as the stream is alive, even if the
+	 * file system which has created the stream is already released.
+	 *
+	 * \ingroup vfs
+	 **/
+	class _NRExport MemoryStream : public FileStream {
+	public:
+
+		//! Create an empty memory stream
+		MemoryStream();
+
+		/**
+		 * Create a stream on the given memory block.
+		 *
+		 * @param holder Owner of the memory, will be kept alive by the stream
+		 * @param data Pointer to the first byte of the view
+		 * @param size Size of the view in bytes
+		 **/
+		MemoryStream(SharedPtr<byte> holder, const byte* data, size_t size);
+
+		//! Release the view
+		virtual ~MemoryStream();
+
+		/**
+		 * Setup the memory block on which this stream should work.
+		 * The reading cursor is reset to the beginning of the block.
+		 * @see MemoryStream()
+		 **/
+		void setData(SharedPtr<byte> holder, const byte* data, size_t size);
+
+		/**
+		 * Open a file by reading its whole content into the memory.
+		 * Further access to the stream does not touch the disk anymore.
+		 **/
+		virtual Result open (const std::string& fileName);
+
+		//------------------------------------------------------------
+		//		IStream Interface
+		//------------------------------------------------------------
+
+		/**
+		* @copydoc IStream::read()
+		**/
+		virtual size_t read(void *buf, size_t size, size_t nmemb);
+
+		/**
+		* @copydoc IStream::readDelim()
+		**/
+		virtual size_t readDelim(void* buf, size_t count, const std::string& delim = std::string("\n"));
+
+		/**
+		* @copydoc IStream::tell()
+		**/
+		virtual size_t tell() const;
+
+		/**
+		* @copydoc IStream::eof()
+		**/
+		virtual bool eof() const;
+
+		/**
+		* Returns a pointer into the memory block starting at the current
+		* cursor position. The data is owned by the stream, so do not delete it.
+		* @copydoc IStream::getData()
+		**/
+		virtual byte* getData(size_t& count) const;
+
+		/**
+		* @copydoc IStream::seek()
+		**/
+		virtual bool seek(int32 offset, int32 whence = IStream::CURRENT);
+
+		/**
+		*  @copydoc IStream::close()
+		**/
+		virtual void close ();
+
+	protected:
+
+		//! Owner of the memory block
+		SharedPtr<byte> mHolder;
+
+		//! Start of the memory block
+		const byte* mData;
+
+		//! Current reading position
+		size_t mPos;
+
+	private:
+
+		Result unloadResource();
+		Result reloadResource(PropertyList* params);
+	};
+
+}; // end namespace
+
+#endif
@@ -0,0 +1,260 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_METRICS_H_
+#define _NR_METRICS_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "ITask.h"
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+
+//----------------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------------
+
+//! Each power of two of a histogram is divided into 2^NR_METRICS_SUB_BITS buckets
+#define NR_METRICS_SUB_BITS 4
+
+//! Values of a histogram are measured in nanoseconds up to 2^NR_METRICS_MAX_BITS (about 4.8 hours)
+#define NR_METRICS_MAX_BITS 44
+
+//! Count of buckets of a histogram
+#define NR_METRICS_BUCKETS ((NR_METRICS_MAX_BITS - NR_METRICS_SUB_BITS + 1) << NR_METRICS_SUB_BITS)
+
+namespace nrEngine{
+
+	//! Metric counting events, it is only increased
+	/**
+	 * \ingroup gp
+	 **/
+	class _NRExport MetricCounter {
+		public:
+
+			//! Increase the counter
+			NR_FORCEINLINE void inc(uint64 n = 1) { mValue.fetch_add(n, boost::memory_order_relaxed); }
+
+			//! Get the current value
+			NR_FORCEINLINE uint64 get() const { return mValue.load(boost::memory_order_relaxed); }
+
+		private:
+			friend class Metrics;
+			MetricCounter() : mValue(0) {}
+
+			boost::atomic<uint64> mValue;
+	};
+
+	//! Metric holding a current value
+	/**
+	 * \ingroup gp
+	 **/
+	class _NRExport MetricGauge {
+		public:
+
+			//! Set the value
+			void set(float64 value);
+
+			//! Add to the value, negative values decrease it
+			void add(float64 value);
+
+			//! Get the current value
+			float64 get() const;
+
+		private:
+			friend class Metrics;
+			MetricGauge();
+
+			//! Bits of the value, there is no atomic floating point type
+			boost::atomic<uint64> mBits;
+	};
+
+	//! Metric collecting the distribution of durations
+	/**
+	 * The histogram is built like the high dynamic range histograms: the values
+	 * are stored in nanoseconds and each power of two is divided into 16 linear
+	 * buckets. So the quantiles are exact to about 6% from a nanosecond up
+	 * to hours, while adding a value is only an increment of a bucket.
+	 *
+	 * \ingroup gp
+	 **/
+	class _NRExport MetricHistogram {
+		public:
+
+			//! Add a duration in seconds
+			void add(float64 seconds);
+
+			//! Add a duration in nanoseconds
+			void addNanoseconds(uint64 ns);
+
+			//! Get count of the added values
+			NR_FORCEINLINE uint64 getCount() const { return mCount.load(boost::memory_order_relaxed); }
+
+			//! Get sum of the added values in seconds
+			float64 getSum() const;
+
+			//! Get the maximal added value in seconds
+			float64 getMax() const;
+
+			/**
+			 * Get the value in seconds below which the given part of all values
+			 * lies (e.g. 0.99). The upper bound of the bucket is returned.
+			 **/
+			float64 getQuantile(float64 part) const;
+
+		private:
+			friend class Metrics;
+			MetricHistogram();
+
+			boost::atomic<uint64> mBuckets[NR_METRICS_BUCKETS];
+			boost::atomic<uint64> mCount;
+			boost::atomic<uint64> mSum;
+			boost::atomic<uint64> mMax;
+	};
+
+	//! Registry of numeric runtime metrics
+	/**
+	 * The subsystems of the engine and the application publish their counters,
+	 * gauges and histograms here. A metric is identified by its name and by
+	 * its labels, given in the Prometheus syntax (e.g. channel="default").
+	 * Getting a metric locks the registry, so the returned pointer should be
+	 * stored. It stays valid as long as the engine exists. Updating a metric is
+	 * lock free and can be done from any thread.
+	 *
+	 * The engine publishes:
+	 *		- nrengine_kernel_ticks_total, nrengine_kernel_tick_seconds, nrengine_kernel_tasks
+	 *		- nrengine_events_emitted_total and nrengine_events_delivered_total per channel
+	 *		- nrengine_resource_loads_total, nrengine_resource_load_failures_total
+	 *		  and nrengine_resource_load_seconds per loader
+	 *		- nrengine_script_calls_total and nrengine_script_call_seconds
+	 *
+	 * The metrics are written in the Prometheus text format. The engine runs
+	 * the registry as a system task, which writes them periodically into a file
+	 * (see setExport()), e.g. for the textfile collector of a local scraper.
+	 * Histograms are written as summaries with their quantiles and an additional
+	 * gauge with the maximum.
+	 *
+	 * \ingroup gp
+	 **/
+	class _NRExport Metrics : public ITask {
+		public:
+
+			/**
+			 * Get a counter, it is created on the first call.
+			 *
+			 * \param name Name of the metric
+			 * \param help Description written into the export
+			 * \param labels Labels of the metric, e.g. loader="Plugin"
+			 * \return the counter or NULL if the name is used by a metric of another type
+			 **/
+			MetricCounter* getCounter(const std::string& name, const std::string& help = "", const std::string& labels = "");
+
+			/**
+			 * Get a gauge, it is created on the first call.
+			 * @see getCounter()
+			 **/
+			MetricGauge* getGauge(const std::string& name, const std::string& help = "", const std::string& labels = "");
+
+			/**
+			 * Get a histogram, it is created on the first call.
+			 * @see getCounter()
+			 **/
+			MetricHistogram* getHistogram(const std::string& name, const std::string& help = "", const std::string& labels = "");
+
+			/**
+			 * Get all metrics in the Prometheus text format
+			 **/
+			std::string exportText();
+
+			/**
+			 * Write all metrics into a file. The file is replaced at once,
+			 * so a reader never gets a partially written file.
+			 *
+			 * \return either OK or FILE_ERROR if the file can not be written
+			 **/
+			Result exportFile(const std::string& fileName);
+
+			/**
+			 * Setup the periodical export.
+			 *
+			 * \param fileName File to write the metrics into
+			 * \param interval Interval in seconds, 0 disables the export
+			 **/
+			void setExport(const std::string& fileName, float32 interval);
+
+			/**
+			 * Write the metrics if the export interval is expired
+			 **/
+			Result updateTask();
+
+			/**
+			 * Get a label in the Prometheus syntax, the value is escaped
+			 **/
+			static std::string label(const std::string& name, const std::string& value);
+
+		private:
+
+			//! Only engine's core class is allowed to create the instance
+			friend class Engine;
+
+			Metrics();
+			~Metrics();
+
+			//! Kind of a metric
+			typedef enum _MetricType {
+				COUNTER,
+				GAUGE,
+				HISTOGRAM
+			} MetricType;
+
+			//! Registered metric
+			struct Metric {
+				MetricType type;
+				std::string name;
+				std::string labels;
+				void* metric;
+			};
+
+			//! Description of a metric name
+			struct Family {
+				MetricType type;
+				std::string help;
+			};
+
+			//! Get the metric or create it
+			void* get(MetricType type, const std::string& name, const std::string& help, const std::string& labels);
+
+			typedef std::map<std::string, Metric> MetricMap;
+			typedef std::map<std::string, Family> FamilyMap;
+
+			//! Metrics by name and labels, so the export is sorted by the name
+			MetricMap mMetrics;
+
+			//! Types and descriptions by name
+			FamilyMap mFamilies;
+
+			//! Protects the registry
+			boost::mutex mMutex;
+
+			//! Periodical export
+			std::string mExportFile;
+			float32 mExportInterval;
+			uint64 mLastExport;
+	};
+
+}; // end namespace
+
+#endif
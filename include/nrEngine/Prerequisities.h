@@ -93,14 +93,21 @@ namespace nrEngine{
 	template<class T> class 					CValueParser;
 	*/
 	
+	class										BinaryLog;
+	class										BinaryLogReader;
 	class										Clock;
 	class 										Engine;
 	class 										ExceptionManager;
 	class 										Exception;
 	class 										ITask;
 	class										ITimeObserver;
+	class										Metrics;
+	class										MetricCounter;
+	class										MetricGauge;
+	class										MetricHistogram;
 	class										Profiler;
 	class										Profile;
+	class										SampleProfiler;
 	class										TimeSource;
 		
 	class										EmptyPlugin;
@@ -112,7 +119,13 @@ namespace nrEngine{
 	class										ResourceManager;
 	class 										ResourceHolder;
 	template<class ResType> class 				ResourcePtr;
+	template<class ResType> class 				CachedResourcePtr;
 	class 										IResourceLoader;
+	class 										ResourceCache;
+	class 										ResourceArena;
+	class 										ResourceStatistics;
+	struct 										ResourceCounters;
+	class 										ResourceStreamer;
 	
 	class 										Kernel;
 	class 										Log;
@@ -120,9 +133,16 @@ namespace nrEngine{
 	class										Timer;	
 
 	class										IStream;
+	class										MemoryStream;
+	class										MappedFileStream;
+	class										LineReader;
 
 	class										IFileSystem;
 	class										FileSystem;
+	class										ArchiveFileSystem;
+	class										LocalFileSystem;
+	class										MemoryFileSystem;
+	class										FileSystemManager;
 
 	class										ScriptEngine;
 	class										IScript;
@@ -25,18 +25,29 @@
 //----------------------------------------------------------------------------------
 #include "Prerequisities.h"
 #include "Log.h"
+#include "GetTime.h"
+#include <time.h>
+#include <boost/thread/tss.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 
 //----------------------------------------------------------------------------------
 // Defines
 //
 // If you want to profile your application, so use these macros and define NR_PROFILING
+//
+// NR_Profile(name) registers the name once per call site, so the name must not change.
+// For names built at runtime register the zone by Profiler::registerZone() and use
+// NR_ProfileZone(zone) instead.
 //----------------------------------------------------------------------------------
 #ifdef NR_APP_PROFILING
-#   define NR_Profile( a )      ::nrEngine::Profile __nr_profile_instance( (a), false )
+#   define NR_Profile( a )      static const ::nrEngine::ProfileZone __nr_profile_zone = ::nrEngine::Profiler::registerZone( (a), false ); ::nrEngine::Profile __nr_profile_instance( __nr_profile_zone, false )
+#   define NR_ProfileZone( z )  ::nrEngine::Profile __nr_profile_instance( (z), false )
 #   define NR_ProfileBegin( a ) ::nrEngine::Engine::sProfiler()->beginProfile( (a), false )
 #   define NR_ProfileEnd( a )   ::nrEngine::Engine::sProfiler()->endProfile( (a), false )
 #else
 #   define NR_Profile( a )
+#   define NR_ProfileZone( z )
 #   define NR_ProfileBegin( a )
 #   define NR_ProfileEnd( a )
 #endif
@@ -49,11 +60,13 @@
 // application profiling, so the user can either enable or disable one of them
 //----------------------------------------------------------------------------------
 #ifdef NR_ENGINE_PROFILING
-#   define _nrEngineProfile( a )      Profile __nr_profile_instance( (a), true )
+#   define _nrEngineProfile( a )      static const ProfileZone __nr_profile_zone = Profiler::registerZone( (a), true ); Profile __nr_profile_instance( __nr_profile_zone, true )
+#   define _nrEngineProfileZone( z )  Profile __nr_profile_instance( (z), true )
 #   define _nrEngineProfileBegin( a ) Engine::sProfiler()->beginProfile( (a), true )
 #   define _nrEngineProfileEnd( a )   Engine::sProfiler()->endProfile( (a), true )
 #else
 #   define _nrEngineProfile( a )
+#   define _nrEngineProfileZone( z )
 #   define _nrEngineProfileBegin( a )
 #   define _nrEngineProfileEnd( a )
 #endif
@@ -61,6 +74,19 @@
 
 namespace nrEngine{
 
+	/**
+	 * Identifier of a profiled code zone. Zones are registered once by their
+	 * name through Profiler::registerZone(), afterwards only the identifier is used.
+	 * \ingroup gp
+	 **/
+	typedef uint32 ProfileZone;
+
+	/**
+	 * Identifier which does not belong to any zone
+	 * \ingroup gp
+	 **/
+	const ProfileZone NR_PROFILE_NO_ZONE = 0xFFFFFFFF;
+
 	//! Single profile processed by the profiler
 	/**
 	 * Our profiler does store such kind of profiles and manage them.
@@ -81,8 +107,14 @@ namespace nrEngine{
 			
 			/**
 			 * Create an instance of this class and start profiling for this profile.
+			 * The name is looked up on each call, so prefer the zone constructor.
 			 **/
 			Profile(const std::string& name, bool isSystemProfile = false);
+
+			/**
+			 * Start profiling of an already registered zone
+			 **/
+			Profile(ProfileZone zone, bool isSystemProfile = false);
 			
 			/**
 			 * Release used memory and stop the profiler for this profile.
@@ -91,11 +123,11 @@ namespace nrEngine{
 			
 		private:
 			
-			//! Name of the profile, must be unique
-			std::string mName;
+			//! Zone of the profile
+			ProfileZone mZone;
 
-			//! Is this is a system profile
-			bool mSystemProfile;
+			//! True if the profiler has accepted the profile
+			bool mActive;
 			
 	};
 	
@@ -112,12 +144,66 @@ namespace nrEngine{
 	 * Every time the stack is empty we compute the whole statistics for each profiles.
 	 * The time in that the stack is not empty is called frame. We assume that you always
 	 * profiles framewise.
+	 *
+	 * Profiles are identified by zones. Each zone is registered once by its name,
+	 * the macros do this once per call site. The stack, the frame statistics and
+	 * the history are flat arrays indexed by the zone, and the time is read from the
+	 * monotonic system clock in nanoseconds. So a profile costs only some tens of
+	 * nanoseconds and the engine profiling can stay enabled.
+	 *
+	 * The profiler can be used from any thread. The thread which created the
+	 * profiler (the kernel thread) is profiled directly, its outermost profile defines
+	 * the frame. Other threads (e.g. tasks running with TASK_IS_THREAD) write begin
+	 * and end records into a lock-free ring buffer of their own. At the end of each
+	 * frame the records are merged into a separate hierarchy per thread. A record
+	 * carries the thread and the task, which is the outermost profile of the thread.
+	 * If the buffer of a thread is full, new profiles of the thread are dropped until
+	 * the next frame.
+	 *
+	 * Besides the statistics the profiler can capture a timeline of some frames
+	 * (see startCapture()). Each begin and end of a profile in any thread is
+	 * recorded with its time and written in the Chrome Trace Event format, so
+	 * the frames can be inspected in chrome://tracing or in the Perfetto UI.
+	 * The spike detection (see enableSpikeDetection()) keeps the records of the
+	 * last frames and writes such a timeline each time a frame takes too long.
+	 * Code without profiles can be measured by the SampleProfiler, which is
+	 * provided by getSampleProfiler().
 	 * 
 	 * \ingroup gp
 	 **/
 	class _NRExport Profiler {
 		public:
 
+			/**
+			 * Register a zone by its name. Registering the same name again
+			 * returns the same zone. Zones are never unregistered and are
+			 * shared by all profiler instances. This method can be called from any thread.
+			 *
+			 * \param name Unique name of the profile
+			 * \param isSystemProfile Define if the profile is build for the engine
+			 **/
+			static ProfileZone registerZone(const std::string& name, bool isSystemProfile = false);
+
+			/**
+			 * Get the name of a registered zone
+			 **/
+			static std::string getZoneName(ProfileZone zone);
+
+			/**
+			 * Begin of profiling of a registered zone. Please use NR_ProfileZone(zone)
+			 * or NR_Profile(name) macro instead of this function.
+			 *
+			 * \param zone Zone returned by registerZone()
+			 * \param isSystemProfile Define if the profile is build for the engine
+			 * \return true if the profile was started, only then endZone() has to be called
+			 **/
+			bool beginZone(ProfileZone zone, bool isSystemProfile = false);
+
+			/**
+			 * End profiling of the zone started by the last beginZone()
+			 **/
+			void endZone(ProfileZone zone);
+
 			/**
 			 * Begin of profiling. Please use NR_ProfileBegin(name) macro
 			 * instead of this function, so it can be removed in the release
@@ -138,6 +224,66 @@ namespace nrEngine{
 			 **/
 			void endProfile(const std::string& name, bool isSystemProfile = false);
 			
+			/**
+			 * Capture a timeline of the next frames. The capture starts with the
+			 * next frame and records each begin and end of a profile of any thread.
+			 * After the given count of frames the timeline is written into the file
+			 * as JSON in the Chrome Trace Event format. Only enabled profiles are
+			 * recorded, so enable the engine profiling to see the kernel tasks,
+			 * the event delivery and the resource loading.
+			 *
+			 * \param fileName Name of the file to write the timeline into
+			 * \param frames Count of frames to capture
+			 * \return either OK or:
+			 *		- BAD_PARAMETERS if no frames are requested
+			 *		- PROFILE_CAPTURE_RUNNING if another capture is running
+			 **/
+			Result startCapture(const std::string& fileName, uint32 frames);
+
+			/**
+			 * Stop the running capture and write the frames captured so far.
+			 * The capture is stopped at the end of the current frame.
+			 **/
+			void stopCapture();
+
+			/**
+			 * Check whenever a capture is running or waits for the next frame
+			 **/
+			NR_FORCEINLINE bool isCapturing() const { return mCaptureState != CAPTURE_NONE; }
+
+			/**
+			 * Enable the detection of frame time spikes. The records of the last
+			 * frames are kept in a ring buffer. A frame is a spike, if the real frame
+			 * interval of the clock exceeds the threshold or the mean interval of the kept
+			 * frames by the given count of standard deviations. Then the timeline of the
+			 * frames around the spike is written into the directory, half of them
+			 * before the spike and half after it (see startCapture()).
+			 *
+			 * \param directory Existing directory for the timelines
+			 * \param frames Count of frames written for each spike
+			 * \param threshold Frame interval in seconds, which is always a spike, 0 to disable
+			 * \param deviations Count of standard deviations above the mean interval, 0 to disable
+			 * \return either OK or BAD_PARAMETERS if less than two frames are given
+			 * 			or both, the threshold and the deviations, are disabled
+			 **/
+			Result enableSpikeDetection(const std::string& directory, uint32 frames = 60, float32 threshold = 0.0f, float32 deviations = 4.0f);
+
+			/**
+			 * Disable the detection of frame time spikes
+			 **/
+			void disableSpikeDetection();
+
+			/**
+			 * Check whenever the spike detection is enabled
+			 **/
+			NR_FORCEINLINE bool isSpikeDetectionEnabled() const { return mSpikes.get() != NULL; }
+
+			/**
+			 * Get the sample profiler, which samples the stacks of the running
+			 * tasks. It is not running until it is started.
+			 **/
+			NR_FORCEINLINE SampleProfiler* getSampleProfiler() { return mSampler; }
+
 			/**
 			 * Reset the profiler, so we clear all currently using
 			 * profilers.
@@ -189,10 +335,8 @@ namespace nrEngine{
 			friend class Engine;
 
 			/**
-			 * Create a profiler object and use the given time source
-			 * to retrive the time. Engine will create the object
-			 * by itself and will specify a system time source object
-			 * instance for profiler using
+			 * Create a profiler object. The time source is kept for
+			 * compatibility, the profiles are measured by getMonotonicTime().
 			 **/
 			Profiler(SharedPtr<TimeSource> timeSource);
 
@@ -206,37 +350,43 @@ namespace nrEngine{
 			//! Time source used to retrieve time
 			SharedPtr<TimeSource>		mTimeSource;
 
-			
+			//! Record of the ring buffer of a thread
+			struct ProfileRecord {
+
+				//! Time of the record
+				uint64			time;
+
+				//! Zone of the profile
+				ProfileZone		zone;
+
+				//! Outermost profile of the thread, which is the running task
+				ProfileZone		task;
+
+				//! Thread which wrote the record
+				uint16			thread;
+
+				//! True for the begin of the profile and false for the end
+				bool			begin;
+			};
+
 			//! Represents an individual profile call
 			struct ProfileInstance {
 	
-				//! The name of the profile
-				std::string		name;
-	
-				//! The name of the parent, empty string if root
-				std::string		parent;
+				//! Zone of the profile
+				ProfileZone		zone;
 
-				//! Define if the profile is a system profile
-				bool				isSystemProfile;
-				
 				//! The time this profile was started
-				float64				currTime;
+				uint64			currTime;
 	
 				//! Represents the total time of all child profiles to subtract from this profile
-				float64				accum;
-	
-				/// The hierarchical level of this profile, 0 being the root profile
-				uint32				hierarchicalLvl;
+				uint64			accum;
 			};
 			
 			//! Represents the total timing information of a profile since profiles can be called more than once each frame
 			struct ProfileFrame {
 				
-				//! The name of the profile
-				std::string	name;
-			
 				//! The time this profile has taken this frame
-				float64			frameTime;
+				uint64			frameTime;
 			
 				//! The number of times this profile was called this frame
 				uint32			calls;
@@ -245,14 +395,17 @@ namespace nrEngine{
 				uint32			hierarchicalLvl;
 			
 				//! The total time incl. children this profile has taken this frame
-				float64			frameTotalTime;
+				uint64			frameTotalTime;
+
+				//! True if the profile was called in this frame
+				bool			used;
 				
 			};
 			
 			//! Represents a history of each profile during the duration of the app
 			struct ProfileHistory {
 	
-				//! The name of the profile
+				//! The name of the profile, empty if the zone was never called
 				std::string	name;
 
 				//! is system profile
@@ -286,28 +439,30 @@ namespace nrEngine{
 				float32 realTotalTime;
 				
 				//! Giving order on the profiles, to allows sorting
-				bool operator <(const ProfileHistory& p);
+				bool operator <(const ProfileHistory& p) const;
 				
 			};
 				
 			
-			typedef std::list<ProfileInstance>		ProfileStack;
-			typedef std::list<ProfileFrame>			ProfileFrameList;
-			typedef std::list<ProfileHistory>			ProfileHistoryList;
-			typedef std::map< std::string, ProfileHistoryList::iterator> ProfileHistoryMap;
-			typedef std::map< std::string, bool>		DisabledProfileMap;
-
-			//! A stack for each individual profile per frame
-			ProfileStack mProfiles;
-	
-			//! Accumulates the results of each profile per frame (since a profile can be called more than once a frame)
-			ProfileFrameList mProfileFrame;
-	
-			//! Keeps track of the statistics of each profile
-			ProfileHistoryList mProfileHistory;
-	
-			//! We use this for quick look-ups of profiles in the history list
-			ProfileHistoryMap mProfileHistoryMap;
+			typedef std::vector<ProfileRecord>			ProfileRecordList;
+			typedef std::vector<ProfileInstance>		ProfileStack;
+			typedef std::vector<ProfileFrame>			ProfileFrameList;
+			typedef std::vector<ProfileHistory>			ProfileHistoryList;
+
+			//! Profiles of one thread, defined in the source file
+			struct ThreadProfile;
+
+			//! Profiles of all threads, the kernel thread is the first one
+			std::vector< SharedPtr<ThreadProfile> > mThreads;
+
+			//! Profiles of the calling thread, if it is not the kernel thread
+			boost::thread_specific_ptr<ThreadProfile> mThreadProfile;
+
+			//! Thread which created the profiler
+			boost::thread::id mKernelThread;
+
+			//! Protects the list of the threads and the merging of their records
+			boost::mutex mThreadMutex;
 
 			//! The total time each frame takes
 			float64 mTotalFrameTime;
@@ -324,9 +479,73 @@ namespace nrEngine{
 			//! Keeps track of the new enabled/disabled state that the user has requested which will be applied after the frame ends
 			bool mNewEnableState;
 
-			void processFrameStats();
+			//! State of the timeline capture
+			enum CaptureState {
+				CAPTURE_NONE,
+				CAPTURE_PENDING,
+				CAPTURE_RUNNING
+			};
+
+			//! Current state of the capture
+			CaptureState mCaptureState;
+
+			//! File the captured timeline is written into
+			std::string mCaptureFile;
+
+			//! Count of frames to capture and count of frames captured so far
+			uint32 mCaptureFrames;
+			uint32 mCapturedFrames;
+
+			//! Records of all threads captured so far
+			ProfileRecordList mCapture;
+
+			//! State of the spike detection, defined in the source file
+			struct SpikeDetector;
+
+			//! Spike detection, NULL if disabled
+			SharedPtr<SpikeDetector> mSpikes;
+
+			//! Sample profiler of the process
+			SampleProfiler* mSampler;
+
+			//! Records of all threads in the current frame
+			ProfileRecordList mFrameRecords;
+
+			//! True if the records of the current frame are kept
+			bool mRecording;
+
+			//! Add a record of the kernel thread to the current frame
+			void captureRecord(ThreadProfile& tp, ProfileZone zone, uint64 time, bool begin);
+
+			//! Pass the records of the frame to the capture and the spike detection
+			void recordFrame();
+
+			//! Keep the records of the frame and check it for a spike
+			void detectSpike();
+
+			//! Write records as Chrome Trace Event JSON, with an optional marker at the given time
+			Result writeTrace(const std::string& fileName, const ProfileRecordList& records, const std::string& marker = std::string(), uint64 markerTime = 0);
+
+			//! Get the profiles of the calling thread, create them on the first call
+			ThreadProfile* getThreadProfile();
+
+			//! Push a profile on the stack of a thread, the caller has to set the start time
+			ProfileInstance& pushZone(ThreadProfile& tp, ProfileZone zone);
+
+			//! Pop the profile from the stack of a thread, return true if the stack is empty then
+			bool popZone(ThreadProfile& tp, ProfileZone zone, uint64 endTime, uint64& elapsed);
+
+			//! Merge the records written by the other threads
+			void mergeThreads();
+
+			void processFrameStats(ThreadProfile& tp);
 			void changeEnableState();
 
+			void logHistory(const ProfileHistoryList& list, Log::LogTarget lt);
+
+			//! Called when a thread exits, the profiler keeps the profiles of the thread
+			static void threadExit(ThreadProfile* tp);
+
 			void logLine(const char* name, float32 min, float32 max, float32 frameTime, float32 totalTime, uint32 totalCalls);
 
 	};
@@ -334,4 +553,3 @@ namespace nrEngine{
 }; // end namespace
 
 #endif
-
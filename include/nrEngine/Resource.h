@@ -20,6 +20,8 @@
 //----------------------------------------------------------------------------------
 #include "Prerequisities.h"
 #include "ResourceSystem.h"
+#include "ResourceHolder.h"
+#include "ResourcePtr.h"
 #include <boost/enable_shared_from_this.hpp>
 
 namespace nrEngine{
@@ -156,14 +158,50 @@ namespace nrEngine{
 		 * @param dirty True to mark resource as dirty otherwise false.
 		 * @note After the resource is reloaded it will be unmarked
 		 **/
-		NR_FORCEINLINE void setResourceDirty(bool dirty) { mResIsDirty = dirty; }
+		NR_FORCEINLINE void setResourceDirty(bool dirty) { mResIsDirty = dirty; mResGeneration++; }
 		
 		/**
 		* Check whenever a resource is dirty. Dirty resources require 
 		* reloading as soon as possible (i.e. on next access)
 		**/
 		NR_FORCEINLINE bool isResourceDirty() { return mResIsDirty; }
-		
+
+		/**
+		 * Get the generation of the resource state. The generation changes
+		 * each time the resource is loaded, unloaded or marked as dirty.
+		 * CachedResourcePtr uses it to detect when it has to resolve
+		 * the resource again.
+		 **/
+		NR_FORCEINLINE uint32 getResourceGeneration() const { return mResGeneration; }
+
+		/**
+		 * Get names of the resources this resource depends on. The list is filled
+		 * by the resource manager from the dependencies declared by the loader
+		 * (see IResourceLoader::declareDependencies()). All of them are loaded
+		 * before this resource is loaded.
+		 **/
+		NR_FORCEINLINE const std::list<std::string>& getResourceDependencies() const { return mResDependencies; }
+
+		/**
+		 * Allocate memory for the data of the resource. If the group of the resource
+		 * has an arena (see ResourceManager::enableGroupArena()), so the memory is
+		 * taken from the arena and released together with the group. Otherwise the
+		 * memory is allocated on the heap. Loaders should allocate the payload of
+		 * the resource through this method.
+		 *
+		 * @param size Count of bytes to allocate
+		 * @return pointer to the memory or NULL on failure
+		 **/
+		void* allocateResourceData(std::size_t size);
+
+		/**
+		 * Free memory allocated by allocateResourceData(). Memory of an arena
+		 * is not freed here, it stays reserved until the group is released.
+		 * The arena is the one the memory was allocated from, also if the
+		 * resource was moved to another group meanwhile.
+		 **/
+		void freeResourceData(void* data);
+
 	protected:
 		
 		/**
@@ -206,13 +244,20 @@ namespace nrEngine{
 		 * of emtpy resource. Call this method if you create a resource by your
 		 * own without loading by loader.
 		 **/
-		NR_FORCEINLINE void markResourceLoaded() { mResIsLoaded = true; mResIsDirty = false; }
+		NR_FORCEINLINE void markResourceLoaded() { mResIsLoaded = true; mResIsDirty = false; mResGeneration++; }
 		
 		/**
 		 * Mark the resource as unloaded. When you mark it, then empty resource
 		 * will be used instead.
 		 **/
-		NR_FORCEINLINE void markResourceUnloaded() { mResIsLoaded = false; }
+		NR_FORCEINLINE void markResourceUnloaded() { mResIsLoaded = false; mResGeneration++; }
+
+		/**
+		 * Set the count of bytes used by the resource data. Derived classes
+		 * should call this after loading, so the memory used by the resources
+		 * can be measured (e.g. by ResourceStreamer).
+		 **/
+		NR_FORCEINLINE void setResourceDataSize(std::size_t size) { mResDataSize = size; }
 		
 		 //! Get resource loader assigned with the resource
 		 NR_FORCEINLINE SharedPtr<IResourceLoader> getResourceLoader() { return mResLoader; }
@@ -225,6 +270,9 @@ namespace nrEngine{
 		//! Also resource manager is a friend
 		friend class ResourceManager;
 
+		//! Statistics need the loader of the resource
+		friend class ResourceStatistics;
+
 		//! Shows whenever resource is loaded (is in the memory)
 		bool mResIsLoaded;
 
@@ -254,6 +302,21 @@ namespace nrEngine{
 		
 		//! Set this variable to reload the resource on next access
 		bool mResIsDirty;
+
+		//! Names of the resources this one depends on
+		std::list<std::string> mResDependencies;
+
+		//! Generation of the resource state, changed on each load, unload or dirty marking
+		uint32 mResGeneration;
+
+		//! Arena the data of the resource was allocated from, NULL if allocated on the heap only
+		ResourceArena* mResArena;
+
+		/**
+		 * Set the loaded state of the resource and start a new generation.
+		 * Engine classes must use this instead of changing mResIsLoaded directly.
+		 **/
+		NR_FORCEINLINE void setResourceLoaded(bool loaded) { mResIsLoaded = loaded; mResGeneration++; }
 		
 		/**
 		 * Set the resource type for this resource.
@@ -277,6 +340,42 @@ namespace nrEngine{
 		};
 	};
 
+	//----------------------------------------------------------------------------------
+	template<typename ResType>
+	NR_FORCEINLINE ResType* CachedResourcePtr<ResType>::operator->() const
+	{
+		NR_ASSERT(mHolder.get() != NULL && "Holder does not contain valid data");
+
+		if (mResource == NULL || this->mHolder->mGeneration != mGeneration
+			|| (this->mHolder->mResource != NULL && this->mHolder->mResource->getResourceGeneration() != mResGeneration))
+			return resolve();
+
+		if (mEmpty)
+			this->mHolder->countEmptyAccess++;
+		else
+			this->mHolder->countAccess++;
+		return mResource;
+	}
+
+	//----------------------------------------------------------------------------------
+	template<typename ResType>
+	ResType* CachedResourcePtr<ResType>::resolve() const
+	{
+		ResType* ptr = dynamic_cast<ResType*>(getBase());
+		if (ptr == NULL)
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "CachedResourcePtr<%s> cannot cast from IResource", getBase()->getResourceName().c_str());
+			NR_ASSERT(ptr != NULL && "The resource has wrong type");
+		}
+
+		mResource = ptr;
+		mEmpty = (static_cast<IResource*>(ptr) != this->mHolder->mResource);
+		mGeneration = this->mHolder->mGeneration;
+		mResGeneration = this->mHolder->mResource ? this->mHolder->mResource->getResourceGeneration() : 0;
+
+		return ptr;
+	}
+
 };
 
 #endif
@@ -0,0 +1,120 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_RESOURCE_ARENA_H_
+#define _NR_RESOURCE_ARENA_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include <boost/thread/mutex.hpp>
+
+namespace nrEngine{
+
+	/**
+	 * Default size of the memory chunks reserved by a resource arena
+	 * \ingroup resource
+	 **/
+	const std::size_t NR_RESOURCE_ARENA_CHUNK_SIZE = 1024 * 1024;
+
+	//! Arena allocator for the data of the resources in one group
+	/**
+	 * The arena reserves memory in big chunks and hands it out by just
+	 * moving a pointer forward. Single allocations are never freed, instead
+	 * the whole arena is released at once. So the arena fits the resources
+	 * which live and die together, e.g. all resources of a level.
+	 *
+	 * Arenas are enabled per group through ResourceManager::enableGroupArena().
+	 * Resources get their memory through IResource::allocateResourceData(),
+	 * the manager releases the arena in ResourceManager::unloadGroup() and
+	 * ResourceManager::removeGroup().
+	 *
+	 * Memory of a resource unloaded on its own stays reserved, until the
+	 * whole group is released.
+	 *
+	 * \ingroup resource
+	 **/
+	class _NRExport ResourceArena {
+		public:
+
+			/**
+			 * Create an empty arena. No memory is reserved until the first allocation.
+			 * @param chunkSize Size of the memory chunks reserved by the arena
+			 **/
+			ResourceArena(std::size_t chunkSize = NR_RESOURCE_ARENA_CHUNK_SIZE);
+
+			//! Release all memory of the arena
+			~ResourceArena();
+
+			/**
+			 * Allocate memory from the arena. Allocations bigger than half of
+			 * the chunk size get a chunk of their own.
+			 * @param size Count of bytes to allocate
+			 * @param alignment Alignment of the returned memory, must be a power of two
+			 * @return pointer to the memory or NULL if no more memory is available
+			 **/
+			void* allocate(std::size_t size, std::size_t alignment = 16);
+
+			/**
+			 * Check whenever the given memory was allocated from this arena
+			 **/
+			bool contains(const void* ptr);
+
+			/**
+			 * Free all memory of the arena at once. All pointers returned
+			 * by allocate() get invalid.
+			 **/
+			void release();
+
+			/**
+			 * Get count of bytes allocated from the arena
+			 **/
+			std::size_t getUsedSize() const { return mUsed; }
+
+			/**
+			 * Get count of bytes reserved by the arena
+			 **/
+			std::size_t getReservedSize() const { return mReserved; }
+
+			/**
+			 * Get size of the chunks reserved by the arena
+			 **/
+			std::size_t getChunkSize() const { return mChunkSize; }
+
+		private:
+
+			//! Block of memory reserved at once
+			struct Chunk {
+				byte* data;
+				std::size_t size;
+				std::size_t used;
+			};
+
+			//! Reserved chunks, the last one is used for the small allocations
+			std::vector<Chunk> mChunks;
+
+			std::size_t mChunkSize;
+			std::size_t mUsed;
+			std::size_t mReserved;
+
+			boost::mutex mMutex;
+
+			//! Reserve a new chunk of the given size, return NULL on failure
+			Chunk* reserve(std::size_t size, bool dedicated);
+	};
+
+};
+
+#endif
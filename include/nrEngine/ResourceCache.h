@@ -0,0 +1,151 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_RESOURCE_CACHE_H_
+#define _NR_RESOURCE_CACHE_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+
+namespace nrEngine{
+
+	//! Magic number at the beginning of each cache file ("NRRC")
+	const uint32 NR_RESOURCE_CACHE_MAGIC = 0x4352524E;
+
+	//! Version of the cache file format
+	const uint32 NR_RESOURCE_CACHE_VERSION = 1;
+
+	//! Header of a cached resource file
+	/**
+	 * The cache file has following layout:
+	 *	- header
+	 *	- path of the source file (not null terminated)
+	 *	- data stored by the loader, aligned to 16 bytes
+	 *
+	 * \ingroup resource
+	 **/
+	struct ResourceCacheHeader {
+		//! Must be NR_RESOURCE_CACHE_MAGIC
+		uint32 magic;
+
+		//! Format version, must be NR_RESOURCE_CACHE_VERSION
+		uint32 version;
+
+		//! Version of the loader's data format
+		uint32 loaderVersion;
+
+		//! Length of the source path in bytes
+		uint32 pathLength;
+
+		//! Modification time of the source file
+		uint64 sourceTime;
+
+		//! Size of the source file
+		uint64 sourceSize;
+
+		//! Offset of the data from the beginning of the file
+		uint64 dataOffset;
+
+		//! Size of the data in bytes
+		uint64 dataSize;
+	};
+
+	//! Persistent cache of decoded resources
+	/**
+	 * The resource cache stores the decoded form of resources in a directory
+	 * on the disk, so they have not to be parsed from their source files on
+	 * each start of the application. Each entry is keyed by the path of the
+	 * source file and the loader. An entry is valid only if the modification
+	 * time and the size of the source file as well as the version of the
+	 * loader's data format did not change since the entry was stored.
+	 *
+	 * Cached entries are mapped into the memory, so loading them is just
+	 * one system call. Loaders use the cache by implementing
+	 * IResourceLoader::getCacheVersion(), IResourceLoader::loadCachedResource() and
+	 * IResourceLoader::saveCachedResource(). Only files found on the local
+	 * disk are cached. Set the cache through ResourceManager::setCacheDirectory().
+	 *
+	 * All methods can be called from the loading threads.
+	 *
+	 * \ingroup resource
+	 **/
+	class _NRExport ResourceCache {
+		public:
+
+			/**
+			 * Create the cache working in the given directory. The directory
+			 * is created if it does not exists.
+			 **/
+			ResourceCache(const std::string& directory);
+
+			//! Release the cache, stored entries stay on the disk
+			~ResourceCache();
+
+			/**
+			 * Get the directory of the cache
+			 **/
+			const std::string& getDirectory() const { return mDirectory; }
+
+			/**
+			 * Get the cached data of a source file.
+			 *
+			 * @param loader Unique name of the loader
+			 * @param loaderVersion Version of the loader's data format
+			 * @param fileName Path to the source file on the disk
+			 * @param data Here the data will be stored. The pointer points into
+			 *			the mapped cache file, which stays mapped as long as
+			 *			the pointer is referenced.
+			 * @param size Here the size of the data will be stored
+			 * @return false if there is no valid entry for the file
+			 **/
+			bool lookup(const std::string& loader, uint32 loaderVersion, const std::string& fileName,
+						SharedPtr<byte>& data, size_t& size);
+
+			/**
+			 * Store the decoded data of a source file in the cache. Old entry
+			 * of the file is replaced.
+			 *
+			 * @param loader Unique name of the loader
+			 * @param loaderVersion Version of the loader's data format
+			 * @param fileName Path to the source file on the disk
+			 * @param data Data to be stored
+			 * @param size Size of the data in bytes
+			 * @return either OK or FILE_NOT_FOUND if the source file or cache
+			 *			entry could not be accessed
+			 **/
+			Result store(const std::string& loader, uint32 loaderVersion, const std::string& fileName,
+						const void* data, size_t size);
+
+			/**
+			 * Remove all entries from the cache directory
+			 **/
+			void clear();
+
+			/**
+			 * Get the name of the cache file storing the entry of a source file
+			 **/
+			std::string getEntryName(const std::string& loader, const std::string& fileName) const;
+
+		private:
+
+			//! Directory containing the cached files
+			std::string mDirectory;
+
+	};
+
+};
+
+#endif
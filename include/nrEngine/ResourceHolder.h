@@ -62,11 +62,23 @@ namespace nrEngine{
 			**/
 			~ResourceHolder();
 
+			/**
+			* Get the generation of the holder. The generation changes each time
+			* the holder is bound to another resource or its lock state changes.
+			* Together with IResource::getResourceGeneration() it tells
+			* whenever getResource() could return something else than before.
+			**/
+			NR_FORCEINLINE uint32 getGeneration() const{
+				return mGeneration;
+			}
+
 		private:
 
 			friend class IResourceLoader;
 			friend class IResourcePtr;
 			friend class ResourceManager;
+			friend class ResourceStreamer;
+			template<typename ResType> friend class CachedResourcePtr;
 			
 			/**
 			* Create the object of this class
@@ -81,6 +93,9 @@ namespace nrEngine{
 			
 			//! Store number that represents how often the resource was in use
 			uint32		countAccess;
+
+			//! Store number that represents how often the empty resource was given instead
+			uint32		countEmptyAccess;
 			
 			//! Store the status if real resources lock stack
 			bool		mLockStack[NR_RESOURCE_LOCK_STACK];
@@ -93,6 +108,9 @@ namespace nrEngine{
 			
 			//! Position in empty locking state 
 			int32 mEmptyLockStackTop;
+
+			//! Generation of the holder, changed on rebinding and on lock state changes
+			uint32 mGeneration;
 			
 			/**
 			* Lock real resource for using. Locking has the effect that the getResource() method
@@ -148,6 +166,13 @@ namespace nrEngine{
 			NR_FORCEINLINE uint32 getAccessCount() const{
 				return countAccess;
 			}
+
+			/**
+			* Return the number of accesses which got the empty resource
+			**/
+			NR_FORCEINLINE uint32 getEmptyAccessCount() const{
+				return countEmptyAccess;
+			}
 			
 			/**
 			* Each access to the resource will should call this function. Here 
@@ -21,9 +21,35 @@
 #include "Prerequisities.h"
 #include "ResourceSystem.h"
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
 
 namespace nrEngine{
 
+	//! Description of a resource required by another resource
+	/**
+	 * Loaders declare dependencies of a resource through a list of such
+	 * descriptions (see IResourceLoader::declareDependencies()). The resource
+	 * manager loads all dependencies before the resource itself.
+	 *
+	 * \ingroup resource
+	 **/
+	struct ResourceDependency {
+		//! Unique name of the required resource. If empty, the file name is used
+		std::string name;
+
+		//! Group of the resource. If empty, the group of the dependent resource is used
+		std::string group;
+
+		//! File from which the resource is loaded
+		std::string fileName;
+
+		//! Resource type [optional]
+		std::string resourceType;
+	};
+
+	//! List of resource dependencies
+	typedef std::list<ResourceDependency> ResourceDependencyList;
 	
 	//! Interface for loading/creating resources
 	/**
@@ -56,6 +82,14 @@ namespace nrEngine{
 	* We need this behaviour also to prevent seg faults by using loaders from plugins,
 	* which does own own memory.
 	* 
+	* Loaders can be used from several threads at the same time. Following rules apply:
+	*	- The list of handled resources and the registration in the manager are
+	*	  synchronized by the engine.
+	*	- loadResource() and loadCachedResource() are called concurrently only if
+	*	  supportParallelLoading() returns true, so the loader declares them reentrant.
+	*	  Otherwise the calls are serialized by a lock of the loader.
+	*	- All other methods are called with the resource manager locked.
+	*
 	* @note File types and resource types are case sensitive. So *.png and *.PNG are different file types.
 	*
 	* \ingroup resource
@@ -112,6 +146,11 @@ namespace nrEngine{
 			 * It means that this loader can load each file of such a filetype.
 			 **/
 			NR_FORCEINLINE const std::vector<std::string>& getSupportedFileTypes(){return mSupportedFileTypes;}
+
+			/**
+			 * Get the unique name of the loader
+			 **/
+			NR_FORCEINLINE const std::string& getName() const {return mName;}
 			
 			/**
 			* This method will say if this loader does support creating of resource of the given
@@ -222,6 +261,71 @@ namespace nrEngine{
 			 * This method should be called from the constructor, to declare supported types.
 			 **/
 			virtual Result initializeResourceLoader() = 0;
+
+			/**
+			 * Declare resources which are required by the resource stored in the
+			 * given file. Overwrite this method if your resources reference other
+			 * resources (e.g. a material needs textures and shaders). The method
+			 * should only read as much of the file as needed to find the
+			 * dependencies. The resource manager loads the dependencies before
+			 * loadResource() is called, so the loader has not to load them by itself.
+			 * Names of the dependencies can be requested in loadResource()
+			 * through IResource::getResourceDependencies().
+			 *
+			 * Default implementation declares no dependencies.
+			 *
+			 * @param fileName Name of the file containing the resource
+			 * @param param Specific parameters specified by the user
+			 * @param deps List to which the dependencies should be added
+			 * @return either OK or an error code. On error the resource is not loaded.
+			 **/
+			virtual Result declareDependencies(const std::string& fileName, PropertyList* param, ResourceDependencyList& deps) { return OK; }
+
+			/**
+			 * Return true if loadResource() is reentrant, so it can be called
+			 * from several threads to decode resources concurrently. The loader must
+			 * not access the resource manager or other engine's subsystems in
+			 * loadResource() then, except of the resources given through
+			 * IResource::getResourceDependencies(), which are already loaded at this time.
+			 *
+			 * Default is false, so the loads of this loader are serialized and
+			 * resources of a dependency graph are loaded in the calling thread.
+			 **/
+			virtual bool supportParallelLoading() const { return false; }
+
+			/**
+			 * Return the version of the format in which the loader stores decoded
+			 * resources in the resource cache (see ResourceCache). Increase the
+			 * version each time the format changes, so old cache entries are not
+			 * used anymore.
+			 *
+			 * Default is 0, which means that the loader does not use the cache.
+			 **/
+			virtual uint32 getCacheVersion() const { return 0; }
+
+			/**
+			 * Load a resource from the data stored before by saveCachedResource().
+			 * The method is called instead of loadResource() if the cache contains
+			 * a valid entry for the file. Same threading rules as for loadResource() apply.
+			 *
+			 * @param res Resource instance created before with create()
+			 * @param fileName Name of the source file
+			 * @param data Cached data. The data is mapped into the memory, so
+			 *			the resource can reference it instead of copying.
+			 * @param size Size of the cached data in bytes
+			 * @return OK or an error code, on error the resource is loaded by loadResource()
+			 **/
+			virtual Result loadCachedResource(IResource* res, const std::string& fileName, SharedPtr<byte> data, size_t size) { return RES_ERROR; }
+
+			/**
+			 * Store the decoded form of a resource loaded by loadResource(), so it
+			 * can be loaded through loadCachedResource() on the next start.
+			 *
+			 * @param res Loaded resource
+			 * @param data Buffer which should receive the data
+			 * @return OK if the data should be stored in the cache
+			 **/
+			virtual Result saveCachedResource(IResource* res, std::vector<byte>& data) { return RES_ERROR; }
 			
 			/**
 			 * Create instance of the resource loader.
@@ -320,12 +424,43 @@ namespace nrEngine{
 			//! List of resources managed by this loader
 			ResourceList mHandledResources;
 
+			//! Protects the list of handled resources
+			boost::mutex mHandledMutex;
+
+			//! Serializes the loads if loadResource() is not reentrant
+			boost::recursive_mutex mLoadMutex;
+
+			//! Add a resource to the handled resources
+			void addHandled(SharedPtr<IResource> res);
+
+			//! Remove a resource from the handled resources, returns false if it was not handled
+			bool removeHandled(SharedPtr<IResource> res);
+
+			//! Check whenever the resource is handled by this loader
+			bool isHandled(SharedPtr<IResource> res);
+
 					
 			/**
 			 * Create an instance of appropriate resource object. 
 			 **/
 			SharedPtr<IResource> create(const std::string& resourceType, PropertyList* params = NULL);
 
+			/**
+			 * Create an instance of the resource which has to be loaded from the file.
+			 * The resource is setted up with its name and file, but it is not loaded.
+			 * @param fileName Receives the resolved file name
+			 * @see load()
+			 **/
+			SharedPtr<IResource> prepareLoad(const std::string& name, const std::string& group, const std::string& fileName, const std::string& resourceType, PropertyList* param, std::string& newFileName);
+
+			/**
+			 * Load a resource either from the resource cache or through loadResource().
+			 * Resources loaded from the source file are stored in the cache.
+			 * Resources loaded with parameters are never cached. The loading
+			 * is recorded in the resource statistics as load or as reload.
+			 **/
+			Result loadResourceCached(IResource* res, const std::string& fileName, PropertyList* param, bool reload = false);
+
 			/**
 			 * Get shared pointer from this class
 			 **/	
@@ -21,6 +21,8 @@
 #include "Prerequisities.h"
 #include "ResourceSystem.h"
 #include "ScriptEngine.h"
+#include "ResourceArena.h"
+#include <boost/thread/recursive_mutex.hpp>
 
 namespace nrEngine {
 
@@ -52,6 +54,15 @@ namespace nrEngine {
 	*			   unload function for the whole group.
 	*			 - Groups must not be disjoint, so you can have same resource in different groups.
 	*
+	* <b>-</b> Threads:
+	*		@par - All public methods can be called from any thread. They are serialized
+	*			   by one recursive lock of the manager.
+	*			 - Resources are registered before they are decoded, and the lock is not
+	*			   held while decoding. So other threads can use the manager meanwhile, and
+	*			   loading of a resource which is loaded by another thread just returns it.
+	*			 - Holders and pointers returned by the manager are not protected. Do not
+	*			   unload or remove a resource while another thread uses it.
+	*
 	* \ingroup resource
 	**/
 	class _NRExport ResourceManager{
@@ -198,6 +209,26 @@ namespace nrEngine {
 			* @param manualLoader Loader which should be used if you want to overload
 			*				all registered loader.
 			*
+			* If the loader declares dependencies of the resource (see
+			* IResourceLoader::declareDependencies()), so the manager builds a graph
+			* of all resources required by this one. Resources without unloaded
+			* dependencies are loaded first, in parallel if their loaders support it
+			* (see setLoaderThreadCount()). A resource is loaded as soon as all its
+			* dependencies are completed. If any dependency fails, so the resources
+			* depending on it are not loaded either.
+			*
+			* Dependencies are reference counted. As soon as the last resource depending
+			* on a dependency is unloaded, the dependency is unloaded too, unless it
+			* was loaded explicitly through this method.
+			*
+			* If the resource or one of its dependencies is being loaded by another
+			* thread, so the method waits until it is completed and does not load
+			* it a second time.
+			*
+			* @note While the resources are decoded and while the method waits for other
+			*		threads, the lock of the manager is released completely, also the
+			*		levels locked by the caller. A loader calling this method, e.g. while
+			*		it is reloaded, must not rely on the database being unchanged meanwhile.
 			**/
 			IResourcePtr	loadResource	(const std::string& name,
 											const std::string& group,
@@ -206,6 +237,50 @@ namespace nrEngine {
 											PropertyList* params = NULL,
 											ResourceLoader manualLoader = ResourceLoader());
 
+			/**
+			* Create a new instance of an already registered resource. The instance
+			* is a copy of the resource's description (name, group, files, dependencies)
+			* without any data. Use loadReloadInstance() to load it from the resource's
+			* files while the current instance is still in use and swapReloadInstance()
+			* to replace the current instance by the new one.
+			*
+			* This allows to reload resources in the background, e.g. if their
+			* files were changed on the disk.
+			*
+			* @param name Unique name of the resource
+			* @return new unloaded instance or NULL if resource is not found
+			**/
+			SharedPtr<IResource> createReloadInstance(const std::string& name);
+
+			/**
+			* Load an instance created by createReloadInstance() through its loader.
+			* The method can be called from any thread if supportParallelLoading()
+			* returns true for the instance, otherwise only from the main thread.
+			*
+			* @param res Instance created by createReloadInstance()
+			* @return either OK or the error code returned by the loader
+			**/
+			Result loadReloadInstance(SharedPtr<IResource> res);
+
+			/**
+			* Check whenever the loader of the given resource supports
+			* loading in other threads than the main thread.
+			**/
+			bool supportParallelLoading(SharedPtr<IResource> res);
+
+			/**
+			* Replace the current instance of a resource by the given one, which was
+			* loaded through loadReloadInstance(). All resource pointers will point
+			* to the new instance at once. The old instance is released by the
+			* loader and deleted as soon as it is not referenced anymore.
+			*
+			* @param res Loaded instance created by createReloadInstance()
+			* @return either OK or an error code:
+			*		- RES_NOT_FOUND if the resource was removed in the meanwhile
+			*		- RES_ERROR if the instance is not loaded
+			**/
+			Result swapReloadInstance(SharedPtr<IResource> res);
+
 #if 0
 			/**
 			* This function will add a given resource to the resource management system.
@@ -393,15 +468,162 @@ namespace nrEngine {
 			 * @return List of resource handles containing in this group 
 			 **/
 			const std::list<ResourceHandle>& getGroupHandles(const std::string& name);
+
+			/**
+			 * Enable an arena allocator for the given group. The data of the resources
+			 * in the group allocated through IResource::allocateResourceData() is then
+			 * taken from the arena. unloadGroup() and removeGroup() release the whole
+			 * arena at once instead of freeing each allocation on its own, as soon
+			 * as no resource of the group is loaded anymore.
+			 *
+			 * Enable the arena before the resources of the group are loaded.
+			 * Calling this for a group which has already an arena does nothing.
+			 *
+			 * @param group Unique name of the group
+			 * @param chunkSize Size of the memory chunks reserved by the arena
+			 **/
+			Result enableGroupArena(const std::string& group, std::size_t chunkSize = NR_RESOURCE_ARENA_CHUNK_SIZE);
+
+			/**
+			 * Get the arena of the group.
+			 * @return arena or NULL if the group does not use an arena
+			 **/
+			ResourceArena* getGroupArena(const std::string& group);
+
 			
-			
+			/**
+			 * Set the number of threads used to load resources of a dependency graph
+			 * in parallel. The calling thread is always used too, so with 0 threads
+			 * all resources are loaded sequentially. Default is the number of
+			 * processors minus one. The threads are started when they are needed
+			 * first and are kept until the manager is destroyed.
+			 **/
+			void setLoaderThreadCount(uint32 count) { mLoaderThreadCount = count; }
+
+			/**
+			 * Get the number of additional threads used to load dependencies
+			 **/
+			uint32 getLoaderThreadCount() const { return mLoaderThreadCount; }
+
+			/**
+			 * Enable or disable sharing of resources with identical content.
+			 * If enabled, the content of each file loaded through loadResource()
+			 * is hashed (see hashData()). If a loaded resource of the same type
+			 * and loader was created from the same content, so no new instance
+			 * is loaded. Instead the new resource name gets its own handle and
+			 * holder pointing to the already loaded instance.
+			 *
+			 * Only resources loaded without parameters are shared. Shared holders
+			 * are copy-on-reload: unloading, reloading or removing a resource through
+			 * the manager detaches it from the other holders, so they keep the old data.
+			 * Calling unload() or reload() directly on the resource object affects all
+			 * holders of the instance. Default is disabled.
+			 **/
+			void setContentSharing(bool enable) { mContentSharing = enable; }
+
+			/**
+			 * Check whenever resources with identical content are shared
+			 **/
+			bool isContentSharing() const { return mContentSharing; }
+
+			/**
+			 * Set the directory of the resource cache. Loaders supporting the cache
+			 * store there the decoded form of the loaded resources, so they can
+			 * be loaded faster on the next start (see ResourceCache). Empty
+			 * directory disables the cache, which is the default.
+			 **/
+			void setCacheDirectory(const std::string& directory);
+
+			/**
+			 * Get the resource cache or NULL if no cache is used
+			 **/
+			SharedPtr<ResourceCache> getResourceCache() const { return mCache; }
+
+			/**
+			 * Get statistics of all resources loaded by the given loader. Counters
+			 * of loads, reloads and unloads are collected since the start or since
+			 * the last resetStatistics(). The resident memory and the empty resource
+			 * hits are measured on the currently registered resources.
+			 **/
+			ResourceCounters getLoaderStatistics(const std::string& loaderName);
+
+			/**
+			 * Get statistics of all resources of the given group.
+			 * @see getLoaderStatistics()
+			 **/
+			ResourceCounters getGroupStatistics(const std::string& group);
+
+			/**
+			 * Get the collector of the statistics. Loaders record their
+			 * loading here.
+			 **/
+			ResourceStatistics& getStatistics() { return *mStatistics; }
+
+			/**
+			 * Drop the collected statistics and the empty resource hits of all holders
+			 **/
+			void resetStatistics();
+
+			/**
+			 * Store the statistics of each loader and group in the property manager.
+			 * For each loader a property group "ResourceLoader:name" and for each
+			 * resource group "ResourceGroup:name" is created, containing the counters
+			 * of ResourceCounters as properties (e.g. "loads", "residentBytes") and the
+			 * latencies in seconds ("loadTimeMean", "loadTimeP95", "loadTimeMax",
+			 * "reloadTimeMean", "reloadTimeP95", "reloadTimeMax").
+			 **/
+			void publishStatistics();
+
+			/**
+			 * Write the statistics of each loader and group into the log and
+			 * store them in the property manager (see publishStatistics()).
+			 **/
+			void dumpStatistics();
+
+			/**
+			 * Set the interval in seconds in which the statistics are dumped
+			 * automatically through dumpStatistics(). 0 disables the dump,
+			 * which is the default.
+			 **/
+			void setStatisticsDumpInterval(float32 seconds) { mStatisticsInterval = seconds; }
+
+			/**
+			 * Dump the statistics if the dump interval is expired. This is called
+			 * by the ResourceStatistics task on each kernel cycle.
+			 **/
+			void updateStatistics();
+
 			//! Typedef for the resource map returned by the getResourceMap() method
 			typedef std::map< std::string, std::list<ResourceHandle> > ResourceGroupMap;
 			
 			/**
 			 * Return the map containing group names and according resource list.
+			 * The map is not locked, other threads (e.g. the loader threads) could
+			 * change it while it is used. Use the copying method instead there.
 			 **/
 			const ResourceGroupMap& getResourceMap() { return mResourceGroup; }
+
+			/**
+			 * Copy the map containing group names and according resource list.
+			 * @param map Map to fill with the groups and their resources
+			 * @param generation Set to the generation of the copied map
+			 **/
+			void getResourceMap(ResourceGroupMap& map, uint32& generation)
+			{
+				DatabaseMutex::scoped_lock lock(mMutex);
+				map = mResourceGroup;
+				generation = mResourceMapGeneration;
+			}
+
+			/**
+			 * Get the generation of the resource map. It is changed each time
+			 * a resource is added to or removed from a group.
+			 **/
+			uint32 getResourceMapGeneration()
+			{
+				DatabaseMutex::scoped_lock lock(mMutex);
+				return mResourceMapGeneration;
+			}
 			
 		private:
 		
@@ -446,11 +668,137 @@ namespace nrEngine {
 			res_hdl_map        mResource;
 			res_str_map        mResourceName;
 			ResourceGroupMap   mResourceGroup;
+
+			//! Generation of the group map, changed on each change of the map
+			uint32             mResourceMapGeneration;
 			res_empty_map      mEmptyResource;
 	
 			// this list shouldn't be filled. it will be returned if no group were found in getGroupHandles() method 
 			std::list<ResourceHandle>	mEmptyResourceGroupHandleList;
-			
+
+			//! Reference counter of a resource required by other resources
+			struct DependencyRef {
+				//! Count of loaded resources depending on this one
+				int32 refCount;
+
+				//! True if the resource was loaded only as dependency
+				bool implicit;
+
+				DependencyRef() : refCount(0), implicit(false) {}
+			};
+
+			typedef std::map<ResourceHandle, DependencyRef>	res_dep_map;
+
+			//! References of the dependencies
+			res_dep_map        mDependencyRef;
+
+			//! Resources holding references on their dependencies
+			std::set<ResourceHandle>	mDependencyHolder;
+
+			//! Count of threads used to load dependency graphs
+			uint32 mLoaderThreadCount;
+
+			//! Graph of resources which has to be loaded together
+			struct LoadGraph;
+
+			//! Holder sharing the instance of another resource with the same content
+			struct SharedAlias {
+				//! Handle of the resource the instance belongs to
+				ResourceHandle owner;
+
+				//! Name, group and file of the resource using the alias
+				std::string name;
+				std::string group;
+				std::list<std::string> fileNames;
+			};
+
+			typedef std::map<ResourceHandle, SharedAlias>					res_alias_map;
+			typedef std::map<ResourceHandle, std::list<ResourceHandle> >	res_owner_map;
+
+			//! True if resources with identical content should be shared
+			bool mContentSharing;
+
+			//! Content hash of a loaded resource mapped to its handle
+			std::map<uint64, ResourceHandle>	mContent;
+
+			//! Handle of a loaded resource mapped to its content hash
+			std::map<ResourceHandle, uint64>	mContentKey;
+
+			//! Holders pointing to an instance of another resource
+			res_alias_map      mSharedAlias;
+
+			//! Resources sharing their instance with the list of the aliases
+			res_owner_map      mSharedOwner;
+
+			//! Cache of the decoded resources
+			SharedPtr<ResourceCache>	mCache;
+
+			//! Arenas of the groups, which allocate their resources from an arena
+			std::map<std::string, SharedPtr<ResourceArena> >	mGroupArena;
+
+			/**
+			 * Release the arena of the group, if no resource of the group is loaded
+			 **/
+			void releaseGroupArena(const std::string& group);
+
+			/**
+			 * Recursive mutex which counts how often the owning thread has locked it.
+			 * So loadResource() can release it completely while it waits for the
+			 * loader threads, even if the caller has locked it already.
+			 **/
+			class DatabaseMutex {
+				public:
+					typedef boost::unique_lock<DatabaseMutex> scoped_lock;
+
+					DatabaseMutex() : mDepth(0) {}
+
+					void lock() { mMutex.lock(); mDepth++; }
+					bool try_lock() { if (!mMutex.try_lock()) return false; mDepth++; return true; }
+					void unlock() { mDepth--; mMutex.unlock(); }
+
+					//! Release all levels locked by the calling thread, return their count
+					uint32 unlockAll()
+					{
+						uint32 depth = mDepth;
+						for (uint32 i = 0; i < depth; i++) unlock();
+						return depth;
+					}
+
+					//! Lock the mutex as often as it was locked before unlockAll()
+					void lockAll(uint32 depth)
+					{
+						for (uint32 i = 0; i < depth; i++) lock();
+					}
+
+				private:
+					boost::recursive_mutex mMutex;
+
+					//! Count of the levels locked by the owner, changed only by the owner
+					uint32 mDepth;
+			};
+
+			//! Protects the database, the loaders and the handle counter
+			DatabaseMutex	mMutex;
+
+			//! Threads loading the resources of the dependency graphs
+			struct LoaderPool;
+			SharedPtr<LoaderPool>	mLoaderPool;
+
+			//! Collected statistics
+			SharedPtr<ResourceStatistics>	mStatistics;
+
+			//! Interval of the statistics dump, 0 if disabled
+			float32 mStatisticsInterval;
+
+			//! Time of the last statistics dump
+			float64 mLastStatisticsDump;
+
+			/**
+			 * Add the resident memory and the empty resource hits of the
+			 * registered resources of the given loader or group (the other is NULL)
+			 **/
+			void addResidentStatistics(ResourceCounters& c, const std::string* loaderName, const std::string* group);
+
 			//------------------------------------------
 			// Methods
 			//------------------------------------------
@@ -492,6 +840,119 @@ namespace nrEngine {
 			**/
 			SharedPtr<ResourceHolder>*	getHolderByHandle(const ResourceHandle& handle);
 
+			/**
+			 * Find a loader for the file. If resource type is given, so
+			 * the loader is found by the resource type, otherwise by the file type.
+			 **/
+			ResourceLoader findLoader(const std::string& fileName, const std::string& resourceType);
+
+			/**
+			 * Add a resource and recursively all its dependencies to the graph.
+			 * @return index of the node or -1 if the resource is already loaded
+			 **/
+			int32 addGraphNode(LoadGraph& graph, const std::string& name, const std::string& group,
+								const std::string& fileName, const std::string& resourceType,
+								PropertyList* params, ResourceLoader loader, Result& ret);
+
+			/**
+			 * Load all resources of the graph. Each resource is loaded after its dependencies.
+			 * Method is executed by each loading thread.
+			 * @param graph Graph to be loaded
+			 * @param mainThread True if called by the thread which has build the graph.
+			 *				Only this thread loads resources which loaders does not
+			 *				support parallel loading.
+			 **/
+			void processGraph(LoadGraph* graph, bool mainThread);
+
+			/**
+			 * Check whenever the resource was registered by loadResource() and its
+			 * loading is not completed yet.
+			 * @param handle Handle of the resource
+			 * @param own Set to true if the calling thread loads the resource
+			 **/
+			bool isResourceLoading(ResourceHandle handle, bool* own = NULL);
+
+			/**
+			 * Wait until the resource is loaded by the thread loading it. The lock
+			 * of the manager, which the caller has to hold, is released meanwhile.
+			 **/
+			void waitLoading(ResourceHandle handle);
+
+			/**
+			 * Method executed by the threads of the loader pool. Each thread
+			 * helps to load the graphs queued by loadResource().
+			 **/
+			void loaderThread();
+
+			/**
+			 * Mark a node of the graph as completed and schedule the nodes
+			 * depending on it. Graph must be locked.
+			 **/
+			void completeGraphNode(LoadGraph* graph, int32 node, Result ret);
+
+			/**
+			 * Add references to all dependencies of the given resource.
+			 * Unloaded dependencies will be reloaded.
+			 **/
+			void acquireDependencies(IResource* res);
+
+			/**
+			 * Release references to all dependencies of the given resource.
+			 * Dependencies loaded implicitly are unloaded if not required anymore.
+			 **/
+			void releaseDependencies(IResource* res);
+
+			/**
+			 * Compute the content hash of the file to be loaded by the given loader.
+			 * @return false if the file could not be read
+			 **/
+			bool computeContentKey(ResourceLoader loader, const std::string& fileName,
+									const std::string& resourceType, uint64& key);
+
+			/**
+			 * Register a new resource name pointing to the instance of the given
+			 * loaded resource.
+			 **/
+			void addSharedAlias(ResourceHandle owner, const std::string& name,
+								const std::string& group, const std::string& fileName);
+
+			/**
+			 * Check whenever the resource with the given handle shares its instance
+			 **/
+			bool isShared(ResourceHandle handle);
+
+			/**
+			 * Get the handle of the resource using the given holder
+			 **/
+			ResourceHandle getSharedHandle(ResourceHolder* holder);
+
+			/**
+			 * Remove the resource with the given handle from the list of holders
+			 * sharing an instance. If the resource owns the instance, so the
+			 * next alias becomes the owner. The holder still points to the
+			 * shared instance after this call.
+			 * @param name,group,fileNames Description of the detached resource
+			 **/
+			void detachShared(ResourceHandle handle, std::string& name, std::string& group,
+								std::list<std::string>& fileNames);
+
+			/**
+			 * Give the shared resource with the given handle its own instance.
+			 * @param load If true, so the new instance is loaded from the file
+			 **/
+			Result copyShared(ResourceHandle handle, bool load);
+
+			/**
+			 * Remove the shared resource with the given handle from the database.
+			 * The instance stays in use by the other holders.
+			 **/
+			Result removeShared(ResourceHandle handle);
+
+			/**
+			 * Forget the content hash of the resource, so it is not shared anymore
+			 **/
+			void forgetContent(ResourceHandle handle);
+
 #if 0
 			/**
 			* This function will check if there is already an empty resource for the given resource
@@ -512,6 +973,9 @@ namespace nrEngine {
 
 			//! Resource object hast got access to certain objects
 			friend class IResource;
+
+			//! Streamer uses the access statistics of the holders
+			friend class ResourceStreamer;
 			
 			/**
 			* Get an empty resource of given type.
@@ -558,13 +1022,20 @@ namespace nrEngine {
 			/**
 			 * Get a new handle for the resource object. Handles are unique.
 			 **/
-			NR_FORCEINLINE ResourceHandle getNewHandle() { return ++mLastHandle; }
+			NR_FORCEINLINE ResourceHandle getNewHandle()
+			{
+				DatabaseMutex::scoped_lock lock(mMutex);
+				return ++mLastHandle;
+			}
 
 			//! Load any resource from the script
 			ScriptFunctionDef(scriptLoadResource);
 			
 			//! Unload any resource from scripts
 			ScriptFunctionDef(scriptUnloadResource);
+
+			//! Dump the resource statistics from scripts
+			ScriptFunctionDef(scriptResourceStatistics);
 			
 	};
 
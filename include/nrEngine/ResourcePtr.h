@@ -265,5 +265,92 @@ namespace nrEngine{
 			}
 	};
 
+
+	//! Resource pointer caching the resolved resource
+	/**
+	* This pointer behaves like ResourcePtr, but it does not resolve the resource
+	* through the holder and cast it on each access. Instead it stores the resolved
+	* and casted resource together with the generations of the holder and of the
+	* resource. As long as both generations are unchanged, an access is just the
+	* comparison of them. The resource is resolved again only if the resource was
+	* loaded, unloaded, reloaded or marked as dirty, or if the holder was locked,
+	* unlocked or bound to another resource.
+	*
+	* Use this pointer in tight loops accessing the same resources very often.
+	* Accesses are still counted, so the resource statistics stay valid.
+	*
+	* \ingroup resource
+	**/
+	template<typename ResType>
+	class _NRExport CachedResourcePtr: public IResourcePtr{
+		public:
+
+			/**
+			* Create an empty pointer, which does not point to anything
+			**/
+			CachedResourcePtr() : IResourcePtr(), mResource(NULL), mGeneration(0), mResGeneration(0), mEmpty(false) {}
+
+			/**
+			* Copy constructor to allow copying from base class
+			**/
+			CachedResourcePtr(const IResourcePtr& res) : IResourcePtr(res), mResource(NULL), mGeneration(0), mResGeneration(0), mEmpty(false) {}
+
+			/**
+			* Assign another resource. The cached resource is dropped.
+			**/
+			CachedResourcePtr& operator=(const IResourcePtr& res)
+			{
+				IResourcePtr::operator=(res);
+				mResource = NULL;
+				return *this;
+			}
+
+			/**
+			* Access to the resource to which one this pointer points. If nothing
+			* has changed since the last access, so the cached resource is returned.
+			* Defined in Resource.h, because it needs the complete resource class.
+			**/
+			NR_FORCEINLINE ResType* operator->() const;
+
+			/**
+			* Get the object stored by this pointer.
+			* NOTE: The instance is controlled by the pointer, so do not delete it
+			**/
+			NR_FORCEINLINE ResType* get()
+			{
+				return operator->();
+			}
+
+			/**
+			* Access to the resource to which one this pointer points.
+			* @see operator->()
+			**/
+			NR_FORCEINLINE ResType& operator*() const
+			{
+				return *(operator->());
+			}
+
+		private:
+
+			//! Resolved resource
+			mutable ResType* mResource;
+
+			//! Generation of the holder when the resource was resolved
+			mutable uint32 mGeneration;
+
+			//! Generation of the holder's resource when it was resolved
+			mutable uint32 mResGeneration;
+
+			//! True if the empty resource was resolved
+			mutable bool mEmpty;
+
+			/**
+			* Resolve the resource through the holder and store the generations.
+			* The holder could reload a dirty resource here, so the generations
+			* are read afterwards. Defined in Resource.h.
+			**/
+			ResType* resolve() const;
+	};
+
 };
 #endif
@@ -0,0 +1,189 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_RESOURCE_STATISTICS_H_
+#define _NR_RESOURCE_STATISTICS_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "ITask.h"
+#include <boost/thread/mutex.hpp>
+
+namespace nrEngine{
+
+	/**
+	 * Count of buckets in the latency histograms. Bucket i counts the latencies
+	 * in the range [2^(i-1), 2^i) microseconds, the first one all below 1 microsecond
+	 * and the last one all above.
+	 * \ingroup resource
+	 **/
+	const int32 NR_RESOURCE_HISTOGRAM_BUCKETS = 26;
+
+	//! Histogram of loading latencies
+	/**
+	 * \ingroup resource
+	 **/
+	struct _NRExport LatencyHistogram {
+
+		//! Count of measurements in each bucket
+		uint32 buckets[NR_RESOURCE_HISTOGRAM_BUCKETS];
+
+		//! Count of all measurements
+		uint32 count;
+
+		//! Sum, minimum and maximum of all measurements in seconds
+		float64 total, min, max;
+
+		//! Create empty histogram
+		LatencyHistogram();
+
+		//! Add a measurement in seconds
+		void add(float64 seconds);
+
+		//! Add all measurements of another histogram
+		void add(const LatencyHistogram& h);
+
+		//! Get the mean latency in seconds
+		float64 getMean() const { return count ? total / (float64)count : 0; }
+
+		/**
+		 * Get the latency in seconds below which the given part of
+		 * all measurements lies (e.g. 0.95). The upper bound of the bucket
+		 * is returned, so the value is exact up to a factor of two.
+		 **/
+		float64 getPercentile(float32 part) const;
+	};
+
+	//! Statistics of a resource loader or of a resource group
+	/**
+	 * \ingroup resource
+	 **/
+	struct _NRExport ResourceCounters {
+
+		//! Count of resources loaded, reloaded and unloaded
+		uint32 loads, reloads, unloads;
+
+		//! Count of unloads done to stay in the memory budget (see ResourceStreamer), included in unloads
+		uint32 evictions;
+
+		//! Count of failed loads and reloads
+		uint32 failures;
+
+		//! Count of loads served and not served by the ResourceCache
+		uint32 cacheHits, cacheMisses;
+
+		//! Bytes loaded since the start, as reported by IResource::getResourceDataSize()
+		uint64 bytesLoaded;
+
+		//! Count and bytes of the currently loaded resources
+		uint32 residentCount;
+		uint64 residentBytes;
+
+		//! How often the empty resource was served instead of the real one
+		uint32 emptyHits;
+
+		//! Latency of loading and reloading
+		LatencyHistogram loadTime, reloadTime;
+
+		//! Create zero counters
+		ResourceCounters();
+	};
+
+	//! Collects statistics of the resource management
+	/**
+	 * The resource manager and the loaders record each load, reload and unload
+	 * here, per loader and per resource group. The resident memory and the
+	 * empty resource hits are taken from the resources and holders, when
+	 * statistics are requested, so the access to the resources is not slowed down.
+	 *
+	 * The statistics are available through ResourceManager::getLoaderStatistics()
+	 * and ResourceManager::getGroupStatistics(), through the property manager
+	 * (see ResourceManager::publishStatistics()) and through the script function
+	 * "resourceStatistics". The engine runs the collector as a system task, which
+	 * dumps the statistics periodically (see ResourceManager::setStatisticsDumpInterval()).
+	 *
+	 * All record methods can be called from the loading threads.
+	 *
+	 * \ingroup resource
+	 **/
+	class _NRExport ResourceStatistics : public ITask {
+		public:
+
+			//! Name of the property group prefix used for published loader statistics
+			static const char* LOADER_GROUP;
+
+			//! Name of the property group prefix used for published group statistics
+			static const char* GROUP_GROUP;
+
+			ResourceStatistics();
+			~ResourceStatistics();
+
+			//! Record a load of the resource which took the given time
+			void recordLoad(IResource* res, float64 seconds, bool success);
+
+			//! Record a reload of the resource which took the given time
+			void recordReload(IResource* res, float64 seconds, bool success);
+
+			//! Record an unload of the resource
+			void recordUnload(IResource* res);
+
+			//! Record an unload done to stay in the memory budget, it is recorded by recordUnload() too
+			void recordEviction(IResource* res);
+
+			//! Record a lookup in the resource cache
+			void recordCacheLookup(IResource* res, bool hit);
+
+			//! Get the recorded statistics of a loader
+			ResourceCounters getLoader(const std::string& name);
+
+			//! Get the recorded statistics of a group
+			ResourceCounters getGroup(const std::string& name);
+
+			//! Get names of all loaders with recorded statistics
+			std::vector<std::string> getLoaderNames();
+
+			//! Get names of all groups with recorded statistics
+			std::vector<std::string> getGroupNames();
+
+			//! Drop all recorded statistics
+			void reset();
+
+			/**
+			 * Format the counters as one line of text
+			 **/
+			static std::string format(const std::string& name, const ResourceCounters& c);
+
+			/**
+			 * Dump the statistics if the dump interval is expired
+			 **/
+			Result updateTask();
+
+		private:
+
+			typedef std::map<std::string, ResourceCounters> CounterMap;
+
+			CounterMap mLoader;
+			CounterMap mGroup;
+
+			boost::mutex mMutex;
+
+			//! Get the loader name of a resource
+			static const std::string& getLoaderName(IResource* res);
+	};
+
+};
+
+#endif
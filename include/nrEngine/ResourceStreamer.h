@@ -0,0 +1,210 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_RESOURCE_STREAMER_H_
+#define _NR_RESOURCE_STREAMER_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "ITask.h"
+#include "Priority.h"
+#include "ResourceSystem.h"
+
+namespace nrEngine{
+
+	//! Kernel task streaming resources in and out of the memory
+	/**
+	 * The streamer collects requests to load or unload resources and executes
+	 * only a limited number of them in each kernel cycle, so streaming does not
+	 * stall the application. Pending requests are ranked by:
+	 *	- the priority hint of the resource (see setPriority()),
+	 *	- the priority hint of the resource's group (see setGroupPriority()),
+	 *	- the recent access frequency of the resource.
+	 *
+	 * The access frequency is sampled from the access counter of the resource
+	 * holders. Old accesses are decayed, so only the recent usage counts.
+	 * Requests with better (smaller) priority are executed first. Loads of equal
+	 * priority are executed before the unloads. Loads are ordered from the hottest
+	 * to the coldest resource and unloads the other way round.
+	 *
+	 * If a memory budget is set, the streamer unloads the coldest resources of
+	 * the lowest priority as long as the loaded resources use more memory than
+	 * the budget. Memory used by the resources is taken from
+	 * IResource::getResourceDataSize(). The unloading is also limited per
+	 * cycle, so the resources are streamed out gradually.
+	 *
+	 * The streamer has to be added to the kernel by the application:
+	 * <code>
+	 *	SharedPtr<ResourceStreamer> streamer(new ResourceStreamer());
+	 *	Engine::sKernel()->AddTask(streamer, ORDER_NORMAL);
+	 * </code>
+	 *
+	 * \ingroup resource
+	 **/
+	class _NRExport ResourceStreamer : public ITask {
+		public:
+
+			//! Create the streamer
+			ResourceStreamer();
+
+			//! Release the streamer, pending requests are dropped
+			~ResourceStreamer();
+
+			/**
+			 * Request to load a resource. If the resource is already registered
+			 * by the manager, so it will be reloaded if it is unloaded and the
+			 * request is dropped if it is loaded. Otherwise it will be loaded
+			 * through ResourceManager::loadResource().
+			 *
+			 * A request for the same resource replaces the previous one.
+			 * @param name Unique name of the resource
+			 * @param group Group of the resource
+			 * @param fileName File containing the resource
+			 * @param resourceType Type of the resource, can be empty
+			 **/
+			void requestLoad(const std::string& name, const std::string& group = std::string(),
+							const std::string& fileName = std::string(),
+							const std::string& resourceType = std::string());
+
+			/**
+			 * Request to unload a resource. A request for the same resource
+			 * replaces the previous one.
+			 **/
+			void requestUnload(const std::string& name);
+
+			/**
+			 * Drop a pending request of the resource
+			 **/
+			void cancelRequest(const std::string& name);
+
+			/**
+			 * Get the count of pending requests
+			 **/
+			uint32 getPendingCount() const { return mRequests.size(); }
+
+			/**
+			 * Set the priority hint of a resource. The hint of the resource
+			 * overrides the hint of its group.
+			 **/
+			void setPriority(const std::string& name, const CPriority& priority);
+
+			/**
+			 * Set the priority hint of all resources in a group
+			 **/
+			void setGroupPriority(const std::string& group, const CPriority& priority);
+
+			/**
+			 * Get the priority of a resource. If no hint was given, so
+			 * CPriority::NORMAL is returned.
+			 **/
+			CPriority getPriority(const std::string& name, const std::string& group) const;
+
+			/**
+			 * Set the maximal number of loads and unloads done in one cycle.
+			 * Requests of resident resources are dropped without counting them.
+			 * Default is 4.
+			 **/
+			void setOperationsPerTick(uint32 count) { mOpsPerTick = count; }
+
+			/**
+			 * Set the amount of memory in bytes which can be used by the loaded
+			 * resources. 0 disables the budget, which is the default.
+			 **/
+			void setMemoryBudget(size_t bytes) { mMemoryBudget = bytes; }
+
+			/**
+			 * Get the memory used by the loaded resources as measured
+			 * by the last sampling
+			 **/
+			size_t getMemoryUsage() const { return mMemoryUsage; }
+
+			/**
+			 * Set how often the access counters are sampled. Default is 0.5 seconds.
+			 **/
+			void setSampleInterval(float32 seconds) { mSampleInterval = seconds; }
+
+			/**
+			 * Set the factor in the range [0,1] with which the access frequency
+			 * is decayed on each sampling. Smaller values forget faster. Default is 0.5.
+			 **/
+			void setDecay(float32 decay) { mDecay = decay; }
+
+			/**
+			 * Get the recent access frequency of a resource.
+			 **/
+			float32 getHeat(const ResourceHandle& handle) const;
+
+			/**
+			 * Execute the pending requests
+			 **/
+			Result updateTask();
+
+			//! Candidate for a load or unload operation
+			struct Candidate {
+				std::string name;
+				uint32 priority;
+				float32 heat;
+				bool load;
+
+				//! Order in which requests are executed
+				bool operator < (const Candidate& c) const;
+			};
+
+		private:
+
+			//! Pending request
+			struct Request {
+				std::string group;
+				std::string fileName;
+				std::string resourceType;
+				bool load;
+			};
+
+			//! Access statistic of a resource
+			struct Stat {
+				uint32 lastCount;
+				float32 heat;
+			};
+
+			//! Sample the access counters and measure the memory usage
+			void sample();
+
+			//! Unload cold resources to stay in the memory budget
+			uint32 evict(uint32 maxOps);
+
+			//! Execute the best ranked requests, return the count of loads and unloads done
+			uint32 processRequests(uint32 maxOps);
+
+			typedef std::map<std::string, Request> RequestMap;
+			typedef std::map<ResourceHandle, Stat> StatMap;
+			typedef std::map<std::string, uint32> PriorityMap;
+
+			RequestMap mRequests;
+			StatMap mStats;
+			PriorityMap mPriority;
+			PriorityMap mGroupPriority;
+
+			uint32 mOpsPerTick;
+			size_t mMemoryBudget;
+			size_t mMemoryUsage;
+			float32 mSampleInterval;
+			float32 mDecay;
+			float64 mLastSample;
+	};
+
+};
+
+#endif
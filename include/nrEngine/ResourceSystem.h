@@ -74,6 +74,10 @@ namespace nrEngine{
 #include "ResourceHolder.h"
 #include "ResourceLoader.h" 
 #include "ResourcePtr.h"
+#include "ResourceCache.h"
+#include "ResourceArena.h"
+#include "ResourceStatistics.h"
+#include "ResourceStreamer.h"
 
 
 #endif
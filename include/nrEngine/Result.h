@@ -92,6 +92,9 @@ namespace nrEngine{
 		//! If the profile you requesting already exists
 		PROFILE_ALREADY_EXISTS = PROFILE_ERROR | (1 << 3),
 
+		//! If a capture of the profiler is already running
+		PROFILE_CAPTURE_RUNNING = PROFILE_ERROR | (1 << 4),
+
 
 		//------------------------------------------------------------------------------
 
@@ -134,6 +137,12 @@ namespace nrEngine{
 		//! No such parameter exists
 	 	VFS_NO_PARAMETER		= VFS_ERROR | (1 << 11),
 
+		//! A file system with the same name is already registered by the manager
+		VFS_FS_ALREADY_REGISTERED	= VFS_ERROR | (1 << 12),
+
+		//! There is no file system with such a name
+		VFS_FS_NOT_REGISTERED	= VFS_ERROR | (1 << 13),
+
 
 		//------------------------------------------------------------------------------
 
@@ -256,6 +265,12 @@ namespace nrEngine{
 		//! No empty resource was created before
 		RES_NO_EMPTY_RES_FOUND 		= RES_ERROR | (1 << 13),
 
+		//! Resource dependencies are cyclic, so they can not be loaded
+		RES_DEPENDENCY_CYCLE		= RES_ERROR | (1 << 14),
+
+		//! A resource on which the resource depends could not be loaded
+		RES_DEPENDENCY_FAILED		= RES_ERROR | (1 << 15),
+
 
 		//------------------------------------------------------------------------------
 		//! This are plugin managment errors
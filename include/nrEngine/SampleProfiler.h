@@ -0,0 +1,173 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef _NR_SAMPLE_PROFILER_H_
+#define _NR_SAMPLE_PROFILER_H_
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include "Prerequisities.h"
+#include "Profiler.h"
+#include <boost/atomic.hpp>
+
+//----------------------------------------------------------------------------------
+// Defines
+//----------------------------------------------------------------------------------
+
+//! Maximal count of stack frames stored for a sample
+#define NR_SAMPLE_STACK_DEPTH 32
+
+namespace nrEngine{
+
+	//! Statistical profiler sampling the stacks of the running code
+	/**
+	 * The sample profiler complements the instrumented profiles of the Profiler.
+	 * It interrupts the process in a regular interval of the consumed cpu time
+	 * (setitimer(ITIMER_PROF) and SIGPROF) and stores the stack of the interrupted
+	 * thread. So also code which is not annotated by profiles (e.g. plugins) is
+	 * measured. Each sample is assigned to the task, which was updated by the
+	 * interrupted thread, either by the kernel or as a threaded task.
+	 *
+	 * The samples are written in the folded stack format, one line per stack
+	 * with the count of its samples. It can be turned into a flame graph by
+	 * flamegraph.pl or speedscope. The first frame of each stack is the task.
+	 *
+	 * The samples are stored in a buffer, which is allocated on start, so the
+	 * signal handler does not allocate any memory. If the buffer is full, further
+	 * samples are dropped. Function names are resolved by the dynamic symbol
+	 * table, so functions of an application are only named if it is linked with
+	 * -rdynamic. Otherwise the module and the offset are written.
+	 *
+	 * The sampling is supported on linux only and only one sample profiler
+	 * can run in the process at once.
+	 *
+	 * \ingroup gp
+	 **/
+	class _NRExport SampleProfiler {
+		public:
+
+			/**
+			 * Start the sampling.
+			 *
+			 * \param frequency Count of samples per second of consumed cpu time
+			 * \param maxSamples Count of samples which can be stored
+			 * \return either OK or:
+			 *		- BAD_PARAMETERS if the frequency or the count of samples is 0
+			 *		- PROFILE_CAPTURE_RUNNING if a sample profiler is already running
+			 *		- PROFILE_ERROR if the sampling is not supported
+			 **/
+			Result start(uint32 frequency = 1000, uint32 maxSamples = 65536);
+
+			/**
+			 * Stop the sampling. The samples are kept until the next start.
+			 **/
+			void stop();
+
+			/**
+			 * Check whenever the sampling is running
+			 **/
+			NR_FORCEINLINE bool isRunning() const { return mRunning; }
+
+			/**
+			 * Get count of stored samples
+			 **/
+			uint32 getSampleCount() const;
+
+			/**
+			 * Get count of samples dropped, because the buffer was full
+			 **/
+			NR_FORCEINLINE uint32 getDroppedCount() const { return mDropped; }
+
+			/**
+			 * Write the stored samples in the folded stack format into a file.
+			 * The sampling has to be stopped before.
+			 *
+			 * \param fileName Name of the file to write
+			 * \return either OK or:
+			 *		- PROFILE_CAPTURE_RUNNING if the sampling is running
+			 *		- FILE_ERROR if the file can not be written
+			 **/
+			Result writeFolded(const std::string& fileName);
+
+			/**
+			 * Called by the kernel before a task is updated by the current thread.
+			 * Returns the task updated before, which has to be restored by leaveTask().
+			 **/
+			static ProfileZone enterTask(ProfileZone task);
+
+			/**
+			 * Restore the task updated by the current thread
+			 **/
+			static void leaveTask(ProfileZone previous);
+
+			/**
+			 * Assigns the samples of the current thread to a task in the scope
+			 **/
+			class TaskScope {
+				public:
+					TaskScope(ProfileZone task) : mPrevious(enterTask(task)) {}
+					~TaskScope() { leaveTask(mPrevious); }
+				private:
+					ProfileZone mPrevious;
+			};
+
+		private:
+
+			//! Only profiler can create the instance
+			friend class Profiler;
+
+			/**
+			 * Create the sample profiler, no memory is allocated before start
+			 **/
+			SampleProfiler();
+
+			/**
+			 * Stop the sampling and release the samples
+			 **/
+			~SampleProfiler();
+
+			//! Stack of one sample
+			struct Sample {
+
+				//! Task updated by the interrupted thread
+				ProfileZone task;
+
+				//! Count of frames
+				int32 depth;
+
+				//! Return addresses, the innermost one first
+				void* frames[NR_SAMPLE_STACK_DEPTH];
+			};
+
+			//! Buffer of the samples
+			std::vector<Sample> mSamples;
+
+			//! Next free sample in the buffer
+			boost::atomic<uint32> mNext;
+
+			//! Count of dropped samples
+			boost::atomic<uint32> mDropped;
+
+			//! True while the sampling is running
+			bool mRunning;
+
+			//! Signal handler, stores a sample
+			static void signalHandler(int sig);
+
+	};
+
+}; // end namespace
+
+#endif
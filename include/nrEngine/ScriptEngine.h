@@ -193,6 +193,10 @@ namespace nrEngine{
 			//! Get  the function according to the given name
 			FunctionDatabase::iterator get(const std::string& name);
 
+			//! Count and duration of the function calls
+			MetricCounter* mCallCount;
+			MetricHistogram* mCallTime;
+
 
 			ScriptFunctionDef(scriptLoad);
 			ScriptFunctionDef(scriptRun);
@@ -66,6 +66,17 @@ namespace nrEngine{
 	 * \ingroup helpers
 	 **/
 	std::string _NRExport orderToString(int32 order);
+
+	/**
+	 * Compute a 64 bit hash value of the given data. The xxHash64
+	 * algorithm is used, which is fast enough to hash whole files
+	 * (several GB/s) and produces nearly no collisions.
+	 * @param data Pointer to the data
+	 * @param size Size of the data in bytes
+	 * @param seed Start value, use different seeds to get different hash functions
+	 * \ingroup helpers
+	 **/
+	uint64 _NRExport hashData(const void* data, size_t size, uint64 seed = 0);
 	
 }; // end namespace
 
@@ -18,6 +18,8 @@
  *------------------------------------------------------------------------*/
 #include "Prerequisities.h"
 #include "Profiler.h"
+#include "SampleProfiler.h"
+#include "Metrics.h"
 #include "Property.h"
 #include "PropertyManager.h"
 #include "Priority.h"
@@ -26,6 +28,7 @@
 #include "Engine.h"
 #include "Exception.h"
 #include "Log.h"
+#include "BinaryLog.h"
 #include "Clock.h"
 #include "ResourceSystem.h"
 #include "PluginLoader.h"
@@ -33,6 +36,12 @@
 #include "IStream.h"
 #include "FileSystemManager.h"
 #include "FileStream.h"
+#include "MemoryStream.h"
+#include "MappedFileStream.h"
+#include "LineReader.h"
+#include "ArchiveFileSystem.h"
+#include "LocalFileSystem.h"
+#include "MemoryFileSystem.h"
 
 #include "ScriptEngine.h"
 #include "ScriptConnector.h"
@@ -0,0 +1,215 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/ArchiveFileSystem.h>
+#include <nrEngine/MappedFileStream.h>
+#include <nrEngine/Log.h>
+#include <boost/checked_delete.hpp>
+#include <zlib.h>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	static bool _compareEntryHash(const ArchiveEntry& a, uint32 hash)
+	{
+		return a.hash < hash;
+	}
+
+	//----------------------------------------------------------------------------------
+	ArchiveFileSystem::ArchiveFileSystem(const std::string& archiveName) : mArchiveName(archiveName),
+		mArchiveSize(0), mEntries(NULL), mEntryCount(0), mNames(NULL)
+	{
+		mType = "archive";
+	}
+
+	//----------------------------------------------------------------------------------
+	ArchiveFileSystem::~ArchiveFileSystem()
+	{
+		deinitialize();
+	}
+
+	//----------------------------------------------------------------------------------
+	uint32 ArchiveFileSystem::hashName(const std::string& name)
+	{
+		uint32 hash = 2166136261u;
+		for (size_t i=0; i < name.length(); i++){
+			hash ^= (byte)name[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ArchiveFileSystem::initialize()
+	{
+		if (mArchive) return VFS_ALREADY_OPEN;
+
+		// map the whole archive into the memory
+		size_t size = 0;
+		SharedPtr<byte> archive = MappedFileStream::map(mArchiveName, size);
+		if (!archive){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: Can not open archive \"%s\"", mArchiveName.c_str());
+			return VFS_CANNOT_OPEN;
+		}
+
+		// check the header
+		const ArchiveHeader* header = (const ArchiveHeader*)archive.get();
+		if (size < sizeof(ArchiveHeader) || header->magic != NR_ARCHIVE_MAGIC || header->version != NR_ARCHIVE_VERSION
+			|| header->tocOffset > size || uint64(header->entryCount) * sizeof(ArchiveEntry) > size - header->tocOffset
+			|| header->namesOffset > size || header->namesSize > size - header->namesOffset)
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: \"%s\" is not a valid archive", mArchiveName.c_str());
+			return VFS_CANNOT_OPEN;
+		}
+
+		// the names are read without further checks
+		const ArchiveEntry* entries = (const ArchiveEntry*)(archive.get() + header->tocOffset);
+		for (uint32 i=0; i < header->entryCount; i++){
+			if (uint64(entries[i].nameOffset) + entries[i].nameLength > header->namesSize){
+				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: \"%s\" contains corrupted names", mArchiveName.c_str());
+				return VFS_CANNOT_OPEN;
+			}
+		}
+
+		mArchive = archive;
+		mArchiveSize = size;
+		mEntryCount = header->entryCount;
+		mEntries = entries;
+		mNames = (const char*)(archive.get() + header->namesOffset);
+
+		NR_Log(Log::LOG_ENGINE, "ArchiveFileSystem: Archive \"%s\" with %d files mounted", mArchiveName.c_str(), mEntryCount);
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ArchiveFileSystem::deinitialize()
+	{
+		// opened streams hold their own reference on the mapping
+		mArchive.reset();
+		mArchiveSize = 0;
+		mEntries = NULL;
+		mEntryCount = 0;
+		mNames = NULL;
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string ArchiveFileSystem::getEntryName(const ArchiveEntry& entry) const
+	{
+		return std::string(mNames + entry.nameOffset, entry.nameLength);
+	}
+
+	//----------------------------------------------------------------------------------
+	const ArchiveEntry* ArchiveFileSystem::findEntry(const std::string& name) const
+	{
+		if (!mEntries) return NULL;
+
+		// binary search for the first entry with the same hash value
+		uint32 hash = hashName(name);
+		const ArchiveEntry* end = mEntries + mEntryCount;
+		const ArchiveEntry* it = std::lower_bound(mEntries, end, hash, _compareEntryHash);
+
+		// check all entries with the same hash value
+		for (; it != end && it->hash == hash; it++){
+			if (it->nameLength == name.length() && memcmp(mNames + it->nameOffset, name.c_str(), name.length()) == 0)
+				return it;
+		}
+
+		return NULL;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ArchiveFileSystem::exists(const std::string& fileName)
+	{
+		return findEntry(normalizeName(fileName)) != NULL;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ArchiveFileSystem::fillFileInfo(const ArchiveEntry& entry, FileInfo& info)
+	{
+		info.fsParent = this;
+		info.name = getEntryName(entry);
+		info.realPath = mArchiveName + ":" + info.name;
+		info.size = entry.size;
+
+		size_t slash = info.name.rfind('/');
+		info.path = (slash == std::string::npos) ? std::string() : info.name.substr(0, slash + 1);
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr ArchiveFileSystem::listFiles(bool recursive)
+	{
+		return findFiles("*", recursive);
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr ArchiveFileSystem::findFiles(const std::string& pattern, bool recursive)
+	{
+		FileInfoListPtr list(new FileInfoList());
+		std::string pat = normalizeName(pattern);
+
+		for (uint32 i=0; i < mEntryCount; i++){
+			std::string name = getEntryName(mEntries[i]);
+			if (matchPattern(pat, name, recursive)){
+				FileInfo info;
+				fillFileInfo(mEntries[i], info);
+				list->push_back(info);
+			}
+		}
+
+		return list;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<FileStream> ArchiveFileSystem::open(const std::string& filename, PropertyList* params)
+	{
+		const ArchiveEntry* entry = findEntry(normalizeName(filename));
+		if (entry == NULL){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: File \"%s\" not found in \"%s\"", filename.c_str(), mArchiveName.c_str());
+			return SharedPtr<FileStream>();
+		}
+
+		// uncompressed files are served with their size, so it must match the stored data
+		bool compressed = (entry->flags & ArchiveEntry::COMPRESSED) != 0;
+		if (entry->offset > mArchiveSize || entry->storedSize > mArchiveSize - entry->offset
+			|| (!compressed && entry->size != entry->storedSize)){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: File \"%s\" is corrupted in \"%s\"", filename.c_str(), mArchiveName.c_str());
+			return SharedPtr<FileStream>();
+		}
+
+		const byte* data = mArchive.get() + entry->offset;
+
+		// uncompressed files are served directly from the mapped archive
+		if (!compressed){
+			return SharedPtr<FileStream>(new MemoryStream(mArchive, data, entry->size));
+		}
+
+		// inflate compressed data into its own buffer
+		SharedPtr<byte> buffer(new byte[entry->size + 1], boost::checked_array_deleter<byte>());
+		uLongf size = entry->size;
+		if (uncompress(buffer.get(), &size, data, entry->storedSize) != Z_OK || size != entry->size){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ArchiveFileSystem: Can not decompress \"%s\" from \"%s\"", filename.c_str(), mArchiveName.c_str());
+			return SharedPtr<FileStream>();
+		}
+		buffer.get()[size] = 0;
+
+		return SharedPtr<FileStream>(new MemoryStream(buffer, buffer.get(), size));
+	}
+
+};
+
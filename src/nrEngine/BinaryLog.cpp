@@ -0,0 +1,383 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/BinaryLog.h>
+#include <string.h>
+#include <stdio.h>
+
+namespace nrEngine{
+
+	//----------------------------------------------------------------------------------
+	// Conversion of a format string, the part from start to end is passed
+	// to printf together with the argument
+	//----------------------------------------------------------------------------------
+	struct _LogConversion {
+		uint32 start;
+		uint32 end;
+		char type;
+	};
+
+	//----------------------------------------------------------------------------------
+	// Get conversions of a format string, false if one of them can not be stored
+	//----------------------------------------------------------------------------------
+	static bool _parseConversions(const char* format, std::vector<_LogConversion>& conversions)
+	{
+		uint32 i = 0;
+		while (format[i]){
+			if (format[i++] != '%') continue;
+			if (format[i] == '%'){ i++; continue; }
+
+			_LogConversion c;
+			c.start = i - 1;
+
+			// flags, width and precision, arguments given by '*' or position are not supported
+			while (format[i] && strchr("-+ #0'", format[i])) i++;
+			while (format[i] >= '0' && format[i] <= '9') i++;
+			if (format[i] == '.'){
+				i++;
+				while (format[i] >= '0' && format[i] <= '9') i++;
+			}
+			if (format[i] == '*' || format[i] == '$') return false;
+
+			// length modifier
+			char length = 0;
+			while (format[i] && strchr("hlLqjzt", format[i])){
+				if (length == 'l' && format[i] == 'l') length = 'q';
+				else if (format[i] != 'h') length = format[i];
+				i++;
+			}
+
+			switch (format[i]){
+				case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+					if (length == 'l') c.type = 'l';
+					else if (length == 'q' || length == 'j' || length == 'L') c.type = 'q';
+					else if (length == 'z' || length == 't') c.type = 'z';
+					else c.type = 'i';
+					break;
+				case 'c':
+					if (length) return false;
+					c.type = 'i';
+					break;
+				case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+					c.type = length == 'L' ? 'D' : 'd';
+					break;
+				case 's':
+					if (length) return false;
+					c.type = 's';
+					break;
+				case 'p':
+					c.type = 'p';
+					break;
+				default:
+					return false;
+			}
+
+			c.end = ++i;
+			conversions.push_back(c);
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	// Append a formatted string
+	//----------------------------------------------------------------------------------
+	static void _append(std::string& out, const char* format, ...)
+	{
+		char buf[512];
+		va_list args;
+		va_start(args, format);
+		int32 len = vsnprintf(buf, sizeof(buf), format, args);
+		va_end(args);
+		if (len < 0) return;
+
+		if ((uint32)len < sizeof(buf)){
+			out.append(buf, len);
+			return;
+		}
+
+		// long strings are formatted once more
+		std::vector<char> big(len + 1);
+		va_start(args, format);
+		vsnprintf(&big[0], big.size(), format, args);
+		va_end(args);
+		out.append(&big[0], len);
+	}
+
+	//----------------------------------------------------------------------------------
+	// Helpers to store values in the byte order of the machine
+	//----------------------------------------------------------------------------------
+	template<typename T> static void _write(std::ostream& stream, T value)
+	{
+		stream.write((const char*)&value, sizeof(T));
+	}
+
+	static void _writeString(std::ostream& stream, const std::string& str)
+	{
+		_write<uint32>(stream, str.length());
+		stream.write(str.data(), str.length());
+	}
+
+	template<typename T> static bool _read(const std::string& data, uint32& pos, T& value)
+	{
+		if (pos + sizeof(T) > data.length()) return false;
+		memcpy(&value, data.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	static bool _readString(const std::string& data, uint32& pos, std::string& str)
+	{
+		uint32 len = 0;
+		if (!_read(data, pos, len) || pos + len > data.length()) return false;
+		str.assign(data, pos, len);
+		pos += len;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool BinaryLog::parseFormat(const char* format, std::string& args)
+	{
+		std::vector<_LogConversion> conversions;
+		if (!_parseConversions(format, conversions)) return false;
+
+		args.clear();
+		for (uint32 i = 0; i < conversions.size(); i++)
+			args += conversions[i].type;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	uint32 BinaryLog::encode(const std::string& args, va_list list, char* buffer, uint32 size)
+	{
+		uint32 pos = 0;
+		for (uint32 i = 0; i < args.length(); i++){
+
+			// each of the remaining arguments takes at most 8 bytes besides the strings
+			uint32 reserve = (args.length() - i) * 8;
+			if (pos + reserve > size) return pos;
+
+			int64 iv = 0;
+			float64 dv = 0;
+			switch (args[i]){
+				case 'i':{
+					int32 v = va_arg(list, int);
+					memcpy(buffer + pos, &v, sizeof(v));
+					pos += sizeof(v);
+					continue;
+				}
+				case 's':{
+					const char* str = va_arg(list, const char*);
+					if (str == NULL) str = "(null)";
+					uint32 len = strlen(str);
+					if (len > size - pos - reserve) len = size - pos - reserve;
+					memcpy(buffer + pos, &len, sizeof(len));
+					memcpy(buffer + pos + sizeof(len), str, len);
+					pos += sizeof(len) + len;
+					continue;
+				}
+				case 'l': iv = va_arg(list, long); break;
+				case 'q': iv = va_arg(list, long long); break;
+				case 'z': iv = va_arg(list, size_t); break;
+				case 'p': iv = (int64)(size_t)va_arg(list, void*); break;
+				case 'd': dv = va_arg(list, double); break;
+				case 'D': dv = (float64)va_arg(list, long double); break;
+				default: return pos;
+			}
+
+			if (args[i] == 'd' || args[i] == 'D')
+				memcpy(buffer + pos, &dv, sizeof(dv));
+			else
+				memcpy(buffer + pos, &iv, sizeof(iv));
+			pos += 8;
+		}
+		return pos;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool BinaryLog::decode(const BinaryLogSite& site, const BinaryLogRecord& record, std::vector<BinaryLogValue>& values)
+	{
+		values.clear();
+		if (site.text) return true;
+
+		uint32 pos = 0;
+		for (uint32 i = 0; i < site.args.length(); i++){
+			BinaryLogValue v;
+			v.type = site.args[i];
+			v.i = 0;
+			v.d = 0;
+
+			bool ok = false;
+			if (v.type == 'i'){
+				int32 iv = 0;
+				ok = _read(record.data, pos, iv);
+				v.i = iv;
+			}else if (v.type == 's'){
+				ok = _readString(record.data, pos, v.s);
+			}else if (v.type == 'd' || v.type == 'D'){
+				ok = _read(record.data, pos, v.d);
+			}else{
+				ok = _read(record.data, pos, v.i);
+			}
+			if (!ok) return false;
+
+			values.push_back(v);
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string BinaryLog::format(const BinaryLogSite& site, const BinaryLogRecord& record)
+	{
+		if (site.text) return record.data;
+
+		std::vector<_LogConversion> conversions;
+		std::vector<BinaryLogValue> values;
+		if (!_parseConversions(site.format.c_str(), conversions) || !decode(site, record, values) || values.size() != conversions.size())
+			return site.format + " <corrupted arguments>";
+
+		// each conversion is printed together with the text before it
+		std::string out;
+		uint32 pos = 0;
+		for (uint32 i = 0; i < conversions.size(); i++){
+			std::string part = site.format.substr(pos, conversions[i].end - pos);
+			const BinaryLogValue& v = values[i];
+			switch (v.type){
+				case 'i': _append(out, part.c_str(), (int)v.i); break;
+				case 'l': _append(out, part.c_str(), (long)v.i); break;
+				case 'q': _append(out, part.c_str(), (long long)v.i); break;
+				case 'z': _append(out, part.c_str(), (size_t)v.i); break;
+				case 'p': _append(out, part.c_str(), (void*)(size_t)v.i); break;
+				case 'd': _append(out, part.c_str(), v.d); break;
+				case 'D': _append(out, part.c_str(), (long double)v.d); break;
+				case 's': _append(out, part.c_str(), v.s.c_str()); break;
+			}
+			pos = conversions[i].end;
+		}
+
+		// the rest may contain escaped percent signs
+		_append(out, site.format.substr(pos).c_str());
+		return out;
+	}
+
+	//----------------------------------------------------------------------------------
+	void BinaryLog::writeHeader(std::ostream& stream)
+	{
+		stream.write(NR_BINARY_LOG_MAGIC, 8);
+		_write<uint32>(stream, NR_BINARY_LOG_VERSION);
+	}
+
+	//----------------------------------------------------------------------------------
+	void BinaryLog::writeSite(std::ostream& stream, const BinaryLogSite& site)
+	{
+		_write<uint8>(stream, CHUNK_SITE);
+		_write<uint32>(stream, 4 + 1 + 4 + site.args.length() + 4 + site.format.length());
+		_write<uint32>(stream, site.id);
+		_write<uint8>(stream, site.text ? 1 : 0);
+		_writeString(stream, site.args);
+		_writeString(stream, site.format);
+	}
+
+	//----------------------------------------------------------------------------------
+	void BinaryLog::writeRecord(std::ostream& stream, const BinaryLogRecord& record)
+	{
+		_write<uint8>(stream, CHUNK_RECORD);
+		_write<uint32>(stream, 4 * 4 + 8 + record.data.length());
+		_write<uint32>(stream, record.site);
+		_write<uint32>(stream, record.thread);
+		_write<uint32>(stream, record.target);
+		_write<int32>(stream, record.level);
+		_write<int64>(stream, record.time);
+		stream.write(record.data.data(), record.data.length());
+	}
+
+	//----------------------------------------------------------------------------------
+	BinaryLogReader::BinaryLogReader()
+	{
+
+	}
+
+	//----------------------------------------------------------------------------------
+	BinaryLogReader::~BinaryLogReader()
+	{
+		mFile.close();
+	}
+
+	//----------------------------------------------------------------------------------
+	Result BinaryLogReader::open(const std::string& fileName)
+	{
+		mFile.close();
+		mFile.clear();
+		mSites.clear();
+
+		mFile.open(fileName.c_str(), std::ios::in | std::ios::binary);
+		if (!mFile.is_open()) return FILE_NOT_FOUND;
+
+		char magic[8];
+		uint32 version = 0;
+		mFile.read(magic, sizeof(magic));
+		mFile.read((char*)&version, sizeof(version));
+		if (!mFile || memcmp(magic, NR_BINARY_LOG_MAGIC, sizeof(magic)) != 0 || version != NR_BINARY_LOG_VERSION){
+			mFile.close();
+			return FILE_ERROR;
+		}
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool BinaryLogReader::next(BinaryLogRecord& record)
+	{
+		while (mFile.is_open()){
+			uint8 kind = 0;
+			uint32 size = 0;
+			mFile.read((char*)&kind, sizeof(kind));
+			mFile.read((char*)&size, sizeof(size));
+			if (!mFile) return false;
+
+			std::string chunk(size, 0);
+			if (size) mFile.read(&chunk[0], size);
+			if (!mFile) return false;
+
+			uint32 pos = 0;
+			if (kind == BinaryLog::CHUNK_SITE){
+				BinaryLogSite site;
+				uint8 text = 0;
+				if (_read(chunk, pos, site.id) && _read(chunk, pos, text) && _readString(chunk, pos, site.args) && _readString(chunk, pos, site.format)){
+					site.text = text != 0;
+					mSites[site.id] = site;
+				}
+			}else if (kind == BinaryLog::CHUNK_RECORD){
+				if (_read(chunk, pos, record.site) && _read(chunk, pos, record.thread) && _read(chunk, pos, record.target)
+					&& _read(chunk, pos, record.level) && _read(chunk, pos, record.time)){
+					record.data.assign(chunk, pos, std::string::npos);
+					return true;
+				}
+			}
+
+			// unknown chunks are skipped
+		}
+		return false;
+	}
+
+	//----------------------------------------------------------------------------------
+	const BinaryLogSite* BinaryLogReader::getSite(uint32 id) const
+	{
+		std::map<uint32, BinaryLogSite>::const_iterator it = mSites.find(id);
+		return it == mSites.end() ? NULL : &it->second;
+	}
+
+}; // end namespace
+
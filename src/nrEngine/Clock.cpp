@@ -159,7 +159,7 @@ namespace nrEngine{
 		
 		// set the id of the timer
 		timer->_observerID = id;
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Clock::createTimer(): New timer created (id=%d)", id);
+		NR_LogDebug(Log::LOG_ENGINE, "Clock::createTimer(): New timer created (id=%d)", id);
 		
 		// return created timer
 		return ::boost::dynamic_pointer_cast<Timer, ITimeObserver>(timer);
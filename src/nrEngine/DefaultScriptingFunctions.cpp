@@ -23,6 +23,7 @@ namespace nrEngine{
 				Engine::sScriptEngine()->add("set", set);
 				Engine::sScriptEngine()->add("get", get);
 				Engine::sScriptEngine()->add("list", list);
+				Engine::sScriptEngine()->add("taskTimes", Kernel::scriptTaskTimes);
 			}
 
 
@@ -31,6 +32,7 @@ namespace nrEngine{
 				Engine::sScriptEngine()->del("set");
 				Engine::sScriptEngine()->del("get");
 				Engine::sScriptEngine()->del("list");
+				Engine::sScriptEngine()->del("taskTimes");
 			}
 		
 		private:
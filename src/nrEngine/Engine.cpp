@@ -15,6 +15,7 @@
 #include <nrEngine/Kernel.h>
 #include <nrEngine/Clock.h>
 #include <nrEngine/Profiler.h>
+#include <nrEngine/Metrics.h>
 #include <nrEngine/ResourceManager.h>
 #include <nrEngine/PluginLoader.h>
 #include <nrEngine/FileStreamLoader.h>
@@ -22,6 +23,7 @@
 #include <nrEngine/ScriptEngine.h>
 #include <nrEngine/ScriptLoader.h>
 #include <nrEngine/PropertyManager.h>
+#include <nrEngine/FileSystemManager.h>
 #include "DefaultScriptingFunctions.cpp"
 
 namespace nrEngine{
@@ -32,10 +34,12 @@ namespace nrEngine{
 	Kernel*			Engine::_kernel = NULL;
 	Clock*			Engine::_clock = NULL;
 	Profiler*		Engine::_profiler = NULL;
+	Metrics*		Engine::_metrics = NULL;
 	ResourceManager* 	Engine::_resmgr = NULL;
 	ScriptEngine* 		Engine::_script = NULL;
 	EventManager* 		Engine::_event = NULL;
 	PropertyManager* 	Engine::_propmgr = NULL;
+	FileSystemManager*	Engine::_fsmgr = NULL;
 
 	//--------------------------------------------------------------------------
 	bool Engine::valid(void* p, char* name, bool showWarn)
@@ -98,6 +102,13 @@ namespace nrEngine{
 		return _profiler;
 	}
 
+	//--------------------------------------------------------------------------
+	 Metrics* Engine::sMetrics()
+	{
+		valid(_metrics, (char*)"Metrics");
+		return _metrics;
+	}
+
 	//--------------------------------------------------------------------------
 	 ResourceManager* Engine::sResourceManager()
 	{
@@ -126,6 +137,13 @@ namespace nrEngine{
 		return _propmgr;
 	}
 
+	//--------------------------------------------------------------------------
+	FileSystemManager* Engine::sFileSystemManager()
+	{
+		valid(_fsmgr, (char*)"FileSystemManager");
+		return _fsmgr;
+	}
+
 	//------------------------------------------------------------------------
 	Engine::Engine()
 	{
@@ -136,6 +154,13 @@ namespace nrEngine{
 			NR_EXCEPT(OUT_OF_MEMORY, "Log system could not be created. Probably memory is full", "Engine::Engine()");
 		}
 
+		// the metrics are created early, so the subsystems can register their metrics
+		_metrics = (new Metrics());
+		if (_metrics == NULL)
+		{
+			NR_EXCEPT(OUT_OF_MEMORY, "Metrics could not be created. Probably memory is full", "Engine::Engine()");
+		}
+
 		// create property manager
 		_propmgr = (new PropertyManager());
 		if (_propmgr == NULL)
@@ -143,6 +168,13 @@ namespace nrEngine{
 			NR_EXCEPT(OUT_OF_MEMORY, "PropertyManager could not been created. Check if the memory is not full", "Engine::Engine()");
 		}
 
+		// create the virtual file system
+		_fsmgr = (new FileSystemManager());
+		if (_fsmgr == NULL)
+		{
+			NR_EXCEPT(OUT_OF_MEMORY, "FileSystemManager could not been created. Check if the memory is not full", "Engine::Engine()");
+		}
+
 		// initialize the scripting engine
 		_script = (new ScriptEngine());
 		if (_script == NULL)
@@ -176,6 +208,9 @@ namespace nrEngine{
 		// remove the manager
 		delete _resmgr;
 
+		// release all file systems
+		delete _fsmgr;
+
 		// delete the clock
 		delete _clock;
 
@@ -194,6 +229,9 @@ namespace nrEngine{
 		// remove profiler
 		delete _profiler;
 
+		// remove the metrics, after all subsystems which have published into them
+		delete _metrics;
+
 		// delete the log system
 		delete _logger;
 
@@ -263,6 +301,14 @@ namespace nrEngine{
 		ResourceLoader scriptLoader( new ScriptLoader() );
 		_resmgr->registerLoader((char*)"ScriptLoader", scriptLoader);
 
+		// the statistics are dumped periodically by the kernel
+		_resmgr->getStatistics().setTaskType(TASK_SYSTEM);
+		_kernel->AddTask(SharedPtr<ITask>(&_resmgr->getStatistics(), null_deleter()), ORDER_SYS_THIRD);
+
+		// the metrics are exported periodically by the kernel
+		_metrics->setTaskType(TASK_SYSTEM);
+		_kernel->AddTask(SharedPtr<ITask>(_metrics, null_deleter()), ORDER_SYS_FOURTH);
+
 		return true;
 	}
 
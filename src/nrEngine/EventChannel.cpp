@@ -16,12 +16,17 @@
 #include <nrEngine/EventChannel.h>
 #include <nrEngine/Log.h>
 #include <nrEngine/Profiler.h>
+#include <nrEngine/Metrics.h>
 
 namespace nrEngine{
 
 	//------------------------------------------------------------------------
 	EventChannel::EventChannel(EventManager* manager, const std::string& name) : mName(name){
 		mParentManager = manager;
+
+		std::string label = Metrics::label("channel", name);
+		mEmitted = Engine::sMetrics()->getCounter("nrengine_events_emitted_total", "Count of events emitted into a channel", label);
+		mDelivered = Engine::sMetrics()->getCounter("nrengine_events_delivered_total", "Count of events delivered to the actors of a channel, once per actor", label);
 	}
 
 	//------------------------------------------------------------------------
@@ -51,7 +56,7 @@ namespace nrEngine{
 		if (notice) actor->_noticeConnected(this);
 
 		// Log debug stuff
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "EventChannel (%s): New actor connected \"%s\"", getName().c_str(), actor->getName().c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "EventChannel (%s): New actor connected \"%s\"", getName().c_str(), actor->getName().c_str());
 
 		return OK;
 	}
@@ -71,7 +76,7 @@ namespace nrEngine{
 		if (notice) actor->_noticeDisconnected(this);
 
 		// Log debug stuff
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "EventChannel (%s): Actor \"%s\" disconnected ", getName().c_str(), actor->getName().c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "EventChannel (%s): Actor \"%s\" disconnected ", getName().c_str(), actor->getName().c_str());
 
 		return OK;
 	}
@@ -83,7 +88,7 @@ namespace nrEngine{
 		_nrEngineProfile("EventChannel._disconnectAll");
 
 		// some logging
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "EventChannel (%s): Disconnect all actors", getName().c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "EventChannel (%s): Disconnect all actors", getName().c_str());
 
 		// iterate through all connections and close them
 		ActorDatabase::iterator it = mActorDb.begin();
@@ -107,6 +112,7 @@ namespace nrEngine{
 		// iterate through all connected actors and emit the signal
 		ActorDatabase::iterator it = mActorDb.begin();
 		for (; it != mActorDb.end(); it++){
+			if (mDelivered) mDelivered->inc();
 			it->second->OnEvent(*this, event);
 		}
 	}
@@ -114,6 +120,8 @@ namespace nrEngine{
 	//------------------------------------------------------------------------
 	void EventChannel::push (SharedPtr<Event> event)
 	{
+		if (mEmitted) mEmitted->inc();
+
 		// check if the event priority is immediat
 		if (event->getPriority() == Priority::IMMEDIATE){
 			emit(event);
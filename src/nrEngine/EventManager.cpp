@@ -112,13 +112,13 @@ namespace nrEngine{
 
 		// if user want to send the message to all channels
 		if (name.length() == 0){
-			NR_Log(Log::LOG_ENGINE, Log::LL_CHATTY, "EventManager: Emit event '%s' to all channels", event->getEventType());
+			NR_LogChatty(Log::LOG_ENGINE, "EventManager: Emit event '%s' to all channels", event->getEventType());
 			ChannelDatabase::iterator it = mChannelDb.begin();
 			for (; it != mChannelDb.end(); it++)
 				it->second->push(event);
 
 		}else{
-			NR_Log(Log::LOG_ENGINE, Log::LL_CHATTY, "EventManager: Emit event '%s' to '%s'", event->getEventType(), name.c_str());
+			NR_LogChatty(Log::LOG_ENGINE, "EventManager: Emit event '%s' to '%s'", event->getEventType(), name.c_str());
 			// get the channel according to the name and emit the message
 			SharedPtr<EventChannel> channel = getChannel(name);
 			if (channel == NULL)
@@ -154,14 +154,9 @@ namespace nrEngine {
 		// read data
 		mStream->read((char*)data, mSize);
 
-		// get the size of readed data
+		// get the size of readed data, the buffer could be larger than needed,
+		// but this is cheaper than to copy the data once more
 		count = mStream->gcount();
-		if (count < mSize){
-			byte* ndata = new byte[count];
-			memcpy(ndata, data, sizeof(byte) * count);
-			delete [] data;
-			return ndata;
-		}
 		return data;
 	}
 
@@ -0,0 +1,266 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/FileSystemManager.h>
+#include <nrEngine/LocalFileSystem.h>
+#include <nrEngine/MappedFileStream.h>
+#include <nrEngine/Log.h>
+#include <sys/stat.h>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	FileSystemManager::FileSystemManager() : mIndexValid(false)
+	{
+		NR_Log(Log::LOG_ENGINE, "FileSystemManager: Initialize the virtual file system");
+	}
+
+	//----------------------------------------------------------------------------------
+	FileSystemManager::~FileSystemManager()
+	{
+		// release all file systems
+		while (mMounts.size()){
+			std::string name = mMounts.front().name;
+			removeFilesystem(name);
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	FileSystemManager::MountList::iterator FileSystemManager::findMount(const std::string& name)
+	{
+		MountList::iterator it = mMounts.begin();
+		for (; it != mMounts.end(); it++)
+			if (it->name == name) return it;
+		return mMounts.end();
+	}
+
+	//----------------------------------------------------------------------------------
+	Result FileSystemManager::addFilesystem(SharedPtr<IFileSystem> fs, int32 priority, const std::string& name)
+	{
+		if (!fs) return BAD_PARAMETERS;
+
+		Mount mount;
+		mount.name = name.length() ? name : fs->getType();
+		mount.priority = priority;
+		mount.fs = fs;
+
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+
+		// check if such a file system is already registered
+		if (findMount(mount.name) != mMounts.end()){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "FileSystemManager: File system %s is already registered", mount.name.c_str());
+			return VFS_FS_ALREADY_REGISTERED;
+		}
+
+		// initialize the file system
+		Result ret = fs->initialize();
+		if (ret != OK){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "FileSystemManager: File system %s could not be initialized", mount.name.c_str());
+			return ret;
+		}
+
+		// insert the file system before all file systems of lower priority
+		MountList::iterator it = mMounts.begin();
+		while (it != mMounts.end() && it->priority >= priority) it++;
+		mMounts.insert(it, mount);
+		mIndexValid = false;
+
+		NR_Log(Log::LOG_ENGINE, "FileSystemManager: File system %s of type %s registered with priority %d", mount.name.c_str(), fs->getType().c_str(), priority);
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result FileSystemManager::removeFilesystem(const std::string& name)
+	{
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+
+		MountList::iterator it = findMount(name);
+		if (it == mMounts.end()) return VFS_FS_NOT_REGISTERED;
+
+		NR_Log(Log::LOG_ENGINE, "FileSystemManager: Remove file system %s", name.c_str());
+
+		it->fs->deinitialize();
+		mMounts.erase(it);
+
+		// remove the files from the index
+		mIndex.clear();
+		mIndexValid = false;
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<IFileSystem> FileSystemManager::getFilesystem(const std::string& name)
+	{
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+
+		MountList::iterator it = findMount(name);
+		if (it == mMounts.end()) return SharedPtr<IFileSystem>();
+		return it->fs;
+	}
+
+	//----------------------------------------------------------------------------------
+	void FileSystemManager::rebuildIndex()
+	{
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+
+		mIndexValid = false;
+		updateIndex();
+	}
+
+	//----------------------------------------------------------------------------------
+	void FileSystemManager::updateIndex()
+	{
+		if (mIndexValid) return;
+
+		mIndex.clear();
+
+		// file systems are sorted by priority, so the first one providing a file wins
+		for (MountList::iterator it = mMounts.begin(); it != mMounts.end(); it++){
+			IFileSystem::FileInfoListPtr files = it->fs->listFiles(true);
+			if (!files) continue;
+
+			for (IFileSystem::FileInfoList::iterator jt = files->begin(); jt != files->end(); jt++){
+				mIndex.insert(std::make_pair(jt->name, *jt));
+			}
+		}
+
+		mIndexValid = true;
+		NR_LogDebug(Log::LOG_ENGINE, "FileSystemManager: Index contains %d files", (int32)mIndex.size());
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<IFileSystem> FileSystemManager::splitName(const std::string& fileName, std::string& name)
+	{
+		std::string::size_type pos = fileName.find(':');
+		if (pos == std::string::npos) return SharedPtr<IFileSystem>();
+
+		// only registered names are prefixes, so "d:/file" is still a valid file name
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+		MountList::iterator it = findMount(fileName.substr(0, pos));
+		if (it == mMounts.end()) return SharedPtr<IFileSystem>();
+
+		name = IFileSystem::normalizeName(fileName.substr(pos + 1));
+		return it->fs;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<IFileSystem> FileSystemManager::lookup(const std::string& fileName, IFileSystem::FileInfo& info)
+	{
+		std::string name = IFileSystem::normalizeName(fileName);
+
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+		if (mMounts.size() == 0) return SharedPtr<IFileSystem>();
+		updateIndex();
+
+		FileIndex::const_iterator it = mIndex.find(name);
+		if (it == mIndex.end()) return SharedPtr<IFileSystem>();
+		info = it->second;
+
+		// the file system is kept alive while the file is used
+		for (MountList::iterator jt = mMounts.begin(); jt != mMounts.end(); jt++)
+			if (jt->fs.get() == info.fsParent) return jt->fs;
+
+		return SharedPtr<IFileSystem>();
+	}
+
+	//----------------------------------------------------------------------------------
+	bool FileSystemManager::exists(const std::string& fileName)
+	{
+		std::string name;
+		SharedPtr<IFileSystem> fs = splitName(fileName, name);
+		if (fs) return fs->exists(name);
+
+		IFileSystem::FileInfo info;
+		if (lookup(fileName, info)) return true;
+
+		// open() falls back to the disk for unknown files, so check it here too
+		struct stat st;
+		return stat(fileName.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool FileSystemManager::getFileInfo(const std::string& fileName, IFileSystem::FileInfo& info)
+	{
+		return lookup(fileName, info).get() != NULL;
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr FileSystemManager::findFiles(const std::string& pattern, bool recursive)
+	{
+		IFileSystem::FileInfoListPtr list(new IFileSystem::FileInfoList());
+		std::string pat = IFileSystem::normalizeName(pattern);
+
+		boost::recursive_mutex::scoped_lock lock(mMutex);
+		updateIndex();
+
+		for (FileIndex::const_iterator it = mIndex.begin(); it != mIndex.end(); it++){
+			if (IFileSystem::matchPattern(pat, it->first, recursive))
+				list->push_back(it->second);
+		}
+
+		return list;
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr FileSystemManager::listFiles(bool recursive)
+	{
+		return findFiles("*", recursive);
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<FileStream> FileSystemManager::open(const std::string& fileName, PropertyList* params)
+	{
+		// if file system is specified, so use it
+		std::string name;
+		SharedPtr<IFileSystem> fs = splitName(fileName, name);
+		if (fs) return fs->open(name, params);
+
+		// check if any file system provides the file
+		IFileSystem::FileInfo info;
+		fs = lookup(fileName, info);
+		if (fs) return fs->open(info.name, params);
+
+		// the file is not known, so try to open it from the disk
+		SharedPtr<FileStream> stream(new MappedFileStream());
+		if (stream->open(fileName) != OK) return SharedPtr<FileStream>();
+
+		return stream;
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string FileSystemManager::resolve(const std::string& fileName)
+	{
+		std::string name;
+		SharedPtr<IFileSystem> fs = splitName(fileName, name);
+
+		if (!fs){
+			IFileSystem::FileInfo info;
+			fs = lookup(fileName, info);
+			if (!fs) return fileName;
+			name = info.name;
+		}
+
+		// only files on the local disk have a real path
+		LocalFileSystem* local = dynamic_cast<LocalFileSystem*>(fs.get());
+		if (local) return local->getRealPath(name);
+
+		return fileName;
+	}
+
+};
+
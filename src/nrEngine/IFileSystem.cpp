@@ -51,6 +51,46 @@ namespace nrEngine {
 		//mParameter[name] = value;
 		return OK;
 	}
+
+	//----------------------------------------------------------------------------------
+	static bool _matchPattern(const char* pat, const char* str, bool crossDirs)
+	{
+		while (*pat){
+			if (*pat == '*'){
+				pat++;
+				// match as much as possible, but do not go into subdirectories if not allowed
+				for (const char* s = str; ; s++){
+					if (_matchPattern(pat, s, crossDirs)) return true;
+					if (*s == 0 || (!crossDirs && *s == '/')) return false;
+				}
+			}
+			if (*str == 0) return false;
+			if (*pat != '?' && *pat != *str) return false;
+			pat++; str++;
+		}
+		return *str == 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool IFileSystem::matchPattern(const std::string& pattern, const std::string& name, bool recursive)
+	{
+		return _matchPattern(pattern.c_str(), name.c_str(), recursive);
+	}
 		
-};
+	//----------------------------------------------------------------------------------
+	std::string IFileSystem::normalizeName(const std::string& name)
+	{
+		std::string res = name;
+		std::replace(res.begin(), res.end(), '\\', '/');
 
+		// remove leading "./" and "/"
+		size_t start = 0;
+		while (start < res.length()){
+			if (res[start] == '/') start++;
+			else if (res.compare(start, 2, "./") == 0) start += 2;
+			else break;
+		}
+		return res.substr(start);
+	}
+
+};
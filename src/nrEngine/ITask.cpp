@@ -17,9 +17,36 @@
 #include <nrEngine/ITask.h>
 #include <nrEngine/Log.h>
 #include <nrEngine/Kernel.h>
+#include <nrEngine/Profiler.h>
+#include <nrEngine/SampleProfiler.h>
+#include <nrEngine/GetTime.h>
 
 namespace nrEngine{
 
+	//--------------------------------------------------------------------
+	TaskTimes::TaskTimes() : calls(0), wallAverage(0), cpuAverage(0), wallMax(0), cpuMax(0), wallTotal(0), cpuTotal(0)
+	{
+	}
+
+	//--------------------------------------------------------------------
+	void TaskTimes::add(float64 wall, float64 cpu)
+	{
+		// the first update initializes the averages
+		if (calls == 0){
+			wallAverage = wall;
+			cpuAverage = cpu;
+		}else{
+			wallAverage += (wall - wallAverage) * NR_TASK_TIME_SMOOTHING;
+			cpuAverage += (cpu - cpuAverage) * NR_TASK_TIME_SMOOTHING;
+		}
+
+		if (wall > wallMax) wallMax = wall;
+		if (cpu > cpuMax) cpuMax = cpu;
+		wallTotal += wall;
+		cpuTotal += cpu;
+		calls++;
+	}
+
 	//--------------------------------------------------------------------
 	ITask::ITask() : IThread(){
 		init();
@@ -41,6 +68,7 @@ namespace nrEngine{
 		_taskType = TASK_USER;
 		_taskGraphColor = 0;
 		_taskProperty = TASK_NONE;
+		_taskProfileZone = NR_PROFILE_NO_ZONE;
 	}
 	
 	//--------------------------------------------------------------------
@@ -106,6 +134,14 @@ namespace nrEngine{
 	//--------------------------------------------------------------------
 	void ITask::setTaskName(const std::string& name){
 		_taskName = name;
+		_taskProfileZone = NR_PROFILE_NO_ZONE;
+	}
+
+	//--------------------------------------------------------------------
+	uint32 ITask::getTaskProfileZone(){
+		if (_taskProfileZone == NR_PROFILE_NO_ZONE)
+			_taskProfileZone = Profiler::registerZone(_taskName + "::update", true);
+		return _taskProfileZone;
 	}
 
 	struct _taskSort : std::less<SharedPtr<ITask> >
@@ -127,7 +163,7 @@ namespace nrEngine{
 		_taskDependencies.sort(_taskSort());
 		
 		// debug info
-		NR_Log(Log::LOG_KERNEL, Log::LL_DEBUG, "Task %s depends now on task %s", getTaskName(), task->getTaskName());
+		NR_LogDebug(Log::LOG_KERNEL, "Task %s depends now on task %s", getTaskName(), task->getTaskName());
 
 		return OK;
 	}
@@ -184,7 +220,37 @@ namespace nrEngine{
 
 	//--------------------------------------------------------------------
 	void ITask::_noticeUpdate(){
-		updateTask();
+		// threaded tasks are profiled in their own thread
+		_nrEngineProfileZone(getTaskProfileZone());
+		SampleProfiler::TaskScope sampleTask(getTaskProfileZone());
+		_updateTask();
+	}
+
+	//--------------------------------------------------------------------
+	Result ITask::_updateTask(){
+		uint64 wall = getMonotonicTime();
+		uint64 cpu = getThreadCpuTime();
+
+		Result ret = updateTask();
+
+		cpu = getThreadCpuTime() - cpu;
+		wall = getMonotonicTime() - wall;
+
+		boost::mutex::scoped_lock lock(_taskTimesMutex);
+		_taskTimes.add((float64)wall * 0.000000001, (float64)cpu * 0.000000001);
+		return ret;
+	}
+
+	//--------------------------------------------------------------------
+	TaskTimes ITask::getTaskTimes(){
+		boost::mutex::scoped_lock lock(_taskTimesMutex);
+		return _taskTimes;
+	}
+
+	//--------------------------------------------------------------------
+	void ITask::resetTaskTimes(){
+		boost::mutex::scoped_lock lock(_taskTimesMutex);
+		_taskTimes = TaskTimes();
 	}
 
 	//--------------------------------------------------------------------
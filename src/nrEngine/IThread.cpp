@@ -49,7 +49,6 @@ namespace nrEngine{
 		}
 		NR_Log(Log::LOG_KERNEL, "IThread: Create thread and start it");
 
-		mThread.reset(new boost::thread(boost::bind(&IThread::run, this)));
 		// initialise the attribute
 		/*pthread_attr_init(&mThreadAttr);
 
@@ -65,8 +64,7 @@ namespace nrEngine{
 			NR_Log(Log::LOG_KERNEL, Log::LL_ERROR, "IThread: creation of a thread failed with error code %d", res);
 			return;
 		}*/
-		mThreadState = THREAD_RUNNING;
-   
+		// the thread is started only once, it has to see the running state
 		mThreadState = THREAD_RUNNING;
 		mThread.reset(new boost::thread(boost::bind(IThread::run, this)));
 		
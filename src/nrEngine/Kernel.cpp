@@ -13,15 +13,43 @@
 
 #include <nrEngine/Kernel.h>
 #include <nrEngine/Profiler.h>
+#include <nrEngine/SampleProfiler.h>
 #include <nrEngine/events/KernelTaskEvent.h>
 #include <nrEngine/EventManager.h>
 #include <nrEngine/StdHelpers.h>
 #include <nrEngine/Log.h>
+#include <nrEngine/GetTime.h>
+#include <nrEngine/Metrics.h>
 
 namespace nrEngine {
 
 	std::list< SharedPtr<ITask> >::iterator Kernel::_loopIterator;
 
+	//-------------------------------------------------------------------------
+	ScriptFunctionDec(scriptTaskTimes, Kernel)
+	{
+		Kernel* kernel = Engine::sKernel();
+
+		// reset the times if requested
+		if (args.size() > 1 && args[1] == "reset"){
+			kernel->resetTaskTimes();
+			return ScriptResult();
+		}
+
+		// one line per running and sleeping task
+		std::string text;
+		const std::list< SharedPtr<ITask> >* lists[2] = {&kernel->taskList, &kernel->pausedTaskList};
+		for (int32 i=0; i < 2; i++){
+			std::list< SharedPtr<ITask> >::const_iterator it = lists[i]->begin();
+			for (; it != lists[i]->end(); it++){
+				if (text.length()) text += "\n";
+				text += formatTaskTimes((*it)->getTaskName(), (*it)->getTaskTimes());
+			}
+		}
+
+		return ScriptResult(text);
+	}
+
 	//-------------------------------------------------------------------------
 	Kernel::Kernel(){
 		taskList.clear();
@@ -31,6 +59,11 @@ namespace nrEngine {
 		bInitializedRoot = false;
 		_bSystemTasksAccessable = false;
 		sendEvents(true);
+
+		Metrics* metrics = Engine::sMetrics();
+		mTickCount = metrics->getCounter("nrengine_kernel_ticks_total", "Count of kernel cycles");
+		mTickTime = metrics->getHistogram("nrengine_kernel_tick_seconds", "Duration of a kernel cycle");
+		mTaskCount = metrics->getGauge("nrengine_kernel_tasks", "Count of running kernel tasks");
 	}
 
 	//-------------------------------------------------------------------------
@@ -63,6 +96,7 @@ namespace nrEngine {
 
 		// Profiling of the engine
 		_nrEngineProfile("Kernel::OneTick");
+		uint64 tickStart = getMonotonicTime();
 
 		// start tasks if their are not started before
 		prepareRootTask();
@@ -91,11 +125,10 @@ namespace nrEngine {
 				if (t->getTaskState() == TASK_RUNNING){
 
 					// do some profiling
-					char name[256];
-					sprintf(name, "%s::update", t->getTaskName());
-					_nrEngineProfile(name);
+					_nrEngineProfileZone(t->getTaskProfileZone());
+					SampleProfiler::TaskScope sampleTask(t->getTaskProfileZone());
 
-					t->updateTask();
+					t->_updateTask();
 
 					// check if the task should run only once
 					if (t->getTaskProperty() & TASK_RUN_ONCE)
@@ -134,6 +167,11 @@ namespace nrEngine {
 			if (!killed) it++;
 		}
 
+		// the yield is not part of the cycle
+		if (mTickCount) mTickCount->inc();
+		if (mTickTime) mTickTime->addNanoseconds(getMonotonicTime() - tickStart);
+		if (mTaskCount) mTaskCount->set((float64)taskList.size());
+
 		// Now we yield the running thread, so that our system could still
 		// response
 		IThread::yield();
@@ -171,7 +209,7 @@ namespace nrEngine {
 	//-------------------------------------------------------------------------
 	/*void Kernel::startTasks(){
 
-		NR_Log(Log::LOG_KERNEL, Log::LL_DEBUG, "Start all kernel tasks");
+		NR_LogDebug(Log::LOG_KERNEL, "Start all kernel tasks");
 
 		// start all tasks, which are not running at now
 		for(it = taskList.begin(); it != taskList.end(); it++){
@@ -264,7 +302,7 @@ namespace nrEngine {
 		SharedPtr<ITask> task = getTaskByID(id);
 
 		if (!task) {
-			NR_Log(Log::LOG_KERNEL, Log::LL_DEBUG, "Can not start task with id=%d, because such task does not exists", id);
+			NR_LogDebug(Log::LOG_KERNEL, "Can not start task with id=%d, because such task does not exists", id);
 			return KERNEL_NO_TASK_FOUND;
 		}
 
@@ -736,6 +774,39 @@ namespace nrEngine {
 		}
 	}
 
+	//-------------------------------------------------------------------------
+	Result Kernel::getTaskTimes(TaskId id, TaskTimes& times){
+
+		// reading the times is allowed for the system tasks too
+		PipelineIterator it;
+		if (!_getTaskByID(id, it, TL_RUNNING | TL_SLEEPING)){
+			NR_Log(Log::LOG_KERNEL, "getTaskTimes: No task with id=%d found", id);
+			return KERNEL_NO_TASK_FOUND;
+		}
+
+		times = (*it)->getTaskTimes();
+		return OK;
+	}
+
+	//-------------------------------------------------------------------------
+	void Kernel::resetTaskTimes(){
+		PipelineIterator it;
+		for (it = taskList.begin(); it != taskList.end(); it++)
+			(*it)->resetTaskTimes();
+		for (it = pausedTaskList.begin(); it != pausedTaskList.end(); it++)
+			(*it)->resetTaskTimes();
+	}
+
+	//-------------------------------------------------------------------------
+	std::string Kernel::formatTaskTimes(const std::string& name, const TaskTimes& times){
+		char buf[512];
+		sprintf(buf, "%s: %llu updates, wall %.3f ms avg %.3f ms max %.3f s total, cpu %.3f ms avg %.3f ms max %.3f s total",
+			name.c_str(), (unsigned long long)times.calls,
+			times.wallAverage * 1000.0, times.wallMax * 1000.0, times.wallTotal,
+			times.cpuAverage * 1000.0, times.cpuMax * 1000.0, times.cpuTotal);
+		return std::string(buf);
+	}
+
 	//-------------------------------------------------------------------------
 	Result Kernel::_loopStartCycle()
 	{
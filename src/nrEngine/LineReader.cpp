@@ -0,0 +1,129 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/LineReader.h>
+#include <nrEngine/MemoryStream.h>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	LineReader::LineReader(IStream* stream, size_t bufferSize) : mStream(stream), mBuffer(NULL),
+		mBufferSize(bufferSize), mBegin(NULL), mEnd(NULL), mStreamEnd(false), mLineNumber(0)
+	{
+		if (mBufferSize < 1) mBufferSize = 1;
+
+		// memory streams already have all the data, so use it directly
+		MemoryStream* mem = dynamic_cast<MemoryStream*>(stream);
+		if (mem){
+			size_t count = 0;
+			mBegin = (const char*)mem->getData(count);
+			mEnd = mBegin + count;
+			mem->seek(0, IStream::END);
+			mStreamEnd = true;
+			return;
+		}
+
+		mBuffer = new char[mBufferSize];
+		mBegin = mEnd = mBuffer;
+	}
+
+	//----------------------------------------------------------------------------------
+	LineReader::LineReader(const char* data, size_t length) : mStream(NULL), mBuffer(NULL),
+		mBufferSize(0), mBegin(data), mEnd(data + length), mStreamEnd(true), mLineNumber(0)
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	LineReader::~LineReader()
+	{
+		NR_SAFE_DELETE_ARRAY(mBuffer);
+	}
+
+	//----------------------------------------------------------------------------------
+	bool LineReader::refill()
+	{
+		if (mStreamEnd) return false;
+
+		size_t left = mEnd - mBegin;
+
+		// the whole buffer is one line, so grow the buffer
+		if (left == mBufferSize){
+			char* buffer = new char[mBufferSize * 2];
+			memcpy(buffer, mBegin, left);
+			delete [] mBuffer;
+			mBuffer = buffer;
+			mBufferSize *= 2;
+
+		// move the rest of the data to the beginning of the buffer
+		}else if (mBegin != mBuffer){
+			memmove(mBuffer, mBegin, left);
+		}
+		mBegin = mBuffer;
+		mEnd = mBuffer + left;
+
+		// read as much as fits into the buffer
+		size_t count = mStream->read(mBuffer + left, 1, mBufferSize - left);
+		if (count == 0){
+			mStreamEnd = true;
+			return false;
+		}
+		mEnd += count;
+
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool LineReader::readLine(Line& line, char delim)
+	{
+		const char* end = NULL;
+		const char* scan = mBegin;
+
+		// search for the delimiter, refill the buffer until it is found
+		while ((end = findDelim(scan, mEnd, delim)) == NULL){
+			size_t scanned = mEnd - mBegin;
+			if (!refill()) break;
+			scan = mBegin + scanned;
+		}
+
+		// nothing left to read
+		if (end == NULL && mBegin == mEnd) return false;
+
+		line.data = mBegin;
+		if (end){
+			line.length = end - mBegin;
+			mBegin = end + 1;
+		}else{
+			line.length = mEnd - mBegin;
+			mBegin = mEnd;
+		}
+
+		// remove CR from windows line endings
+		if (delim == '\n' && line.length > 0 && line.data[line.length - 1] == '\r')
+			line.length--;
+
+		mLineNumber++;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool LineReader::eof()
+	{
+		if (mBegin != mEnd) return false;
+		return !refill();
+	}
+
+};
+
@@ -0,0 +1,137 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/LocalFileSystem.h>
+#include <nrEngine/MappedFileStream.h>
+#include <nrEngine/Log.h>
+
+#include <sys/stat.h>
+#if NR_PLATFORM != NR_PLATFORM_WIN32
+#	include <dirent.h>
+#endif
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	LocalFileSystem::LocalFileSystem(const std::string& root) : mRoot(root)
+	{
+		mType = "file";
+
+		if (mRoot.length() && mRoot[mRoot.length()-1] != '/' && mRoot[mRoot.length()-1] != '\\')
+			mRoot += "/";
+	}
+
+	//----------------------------------------------------------------------------------
+	LocalFileSystem::~LocalFileSystem()
+	{
+
+	}
+
+	//----------------------------------------------------------------------------------
+	Result LocalFileSystem::initialize()
+	{
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result LocalFileSystem::deinitialize()
+	{
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool LocalFileSystem::isCaseSensitive() const
+	{
+	#if NR_PLATFORM == NR_PLATFORM_WIN32
+		return false;
+	#else
+		return true;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string LocalFileSystem::getRealPath(const std::string& fileName) const
+	{
+		return mRoot + fileName;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool LocalFileSystem::exists(const std::string& fileName)
+	{
+		struct stat st;
+		return stat(getRealPath(fileName).c_str(), &st) == 0 && (st.st_mode & S_IFREG);
+	}
+
+	//----------------------------------------------------------------------------------
+	void LocalFileSystem::scanDirectory(const std::string& path, const std::string& pattern, bool recursive, FileInfoList& list)
+	{
+	#if NR_PLATFORM != NR_PLATFORM_WIN32
+		std::string dirName = mRoot + path;
+		DIR* dir = opendir(dirName.length() ? dirName.c_str() : ".");
+		if (dir == NULL) return;
+
+		struct dirent* ent;
+		while ((ent = readdir(dir)) != NULL){
+			std::string name = ent->d_name;
+			if (name == "." || name == "..") continue;
+
+			std::string fileName = path + name;
+
+			struct stat st;
+			if (stat((mRoot + fileName).c_str(), &st) != 0) continue;
+
+			if (S_ISDIR(st.st_mode)){
+				if (recursive) scanDirectory(fileName + "/", pattern, recursive, list);
+			}else if (S_ISREG(st.st_mode) && matchPattern(pattern, fileName, recursive)){
+				FileInfo info;
+				info.fsParent = this;
+				info.name = fileName;
+				info.path = path;
+				info.realPath = mRoot + fileName;
+				info.size = st.st_size;
+				list.push_back(info);
+			}
+		}
+		closedir(dir);
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr LocalFileSystem::listFiles(bool recursive)
+	{
+		return findFiles("*", recursive);
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr LocalFileSystem::findFiles(const std::string& pattern, bool recursive)
+	{
+		FileInfoListPtr list(new FileInfoList());
+		scanDirectory("", pattern, recursive, *list);
+		return list;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<FileStream> LocalFileSystem::open(const std::string& filename, PropertyList* params)
+	{
+		SharedPtr<FileStream> stream(new MappedFileStream());
+		if (stream->open(getRealPath(filename)) != OK)
+			return SharedPtr<FileStream>();
+
+		return stream;
+	}
+
+};
+
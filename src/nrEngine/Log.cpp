@@ -12,15 +12,399 @@
 
 
 #include <nrEngine/Log.h>
+#include <nrEngine/BinaryLog.h>
 #include <iostream>
 #include <time.h>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <sys/time.h>
 
 namespace nrEngine{
 
+	//-------------------------------------------------------------------------
+	// Size of the ring buffer of a thread, must be a power of two
+	//-------------------------------------------------------------------------
+	static const uint32 NR_LOG_THREAD_BUFFER = 64 * 1024;
+
+	//-------------------------------------------------------------------------
+	// Size of the arguments of a binary message
+	//-------------------------------------------------------------------------
+	static const uint32 NR_LOG_BINARY_DATA = 2048;
+
+	//-------------------------------------------------------------------------
+	// Maximal count of sites in a binary stream, the messages of further
+	// format strings are stored as formatted text of one shared site
+	//-------------------------------------------------------------------------
+	static const uint32 NR_LOG_BINARY_SITES = 4096;
+
+	//-------------------------------------------------------------------------
+	// Maximal count of format addresses cached by a thread
+	//-------------------------------------------------------------------------
+	static const uint32 NR_LOG_THREAD_SITES = 1024;
+
+	//-------------------------------------------------------------------------
+	// Header of a message in the ring buffer, followed by the message text or
+	// by the arguments of a binary message (site is not 0).
+	// Entries are aligned to 8 bytes. If the rest of the buffer can not take
+	// an entry, it is skipped: either by a padding entry (level is -1) or
+	// implicitly, if even the header does not fit.
+	//-------------------------------------------------------------------------
+	struct _LogEntry {
+		uint32 size;
+		uint32 seq;
+		int32 target;
+		int32 level;
+		uint32 site;
+		uint32 length;
+		int64 time;
+	};
+
+	//-------------------------------------------------------------------------
+	// Hash of a format string address
+	//-------------------------------------------------------------------------
+	static NR_FORCEINLINE uint32 _hashFormat(const char* format)
+	{
+		return (uint32)(((size_t)format >> 3) * 2654435761u);
+	}
+
+	//-------------------------------------------------------------------------
+	// Ring buffer of the messages of one thread, read by the background thread
+	//-------------------------------------------------------------------------
+	struct _LogThreadBuffer {
+		std::vector<char> data;
+		boost::atomic<uint32> head;
+		boost::atomic<uint32> tail;
+		boost::atomic<bool> exited;
+
+		// set while the thread puts a message into the buffer
+		boost::atomic<bool> busy;
+
+		// index of the thread in the binary stream
+		uint32 thread;
+
+		// sites of the binary logging used by the thread, hashed by the format address.
+		// The address is only a hint: formats which are no literals or literals of
+		// a reloaded plugin can use the same address for another text.
+		std::vector<const char*> siteFormats;
+		std::vector<BinaryLogSite*> sites;
+		uint32 siteCount;
+
+		_LogThreadBuffer() : data(NR_LOG_THREAD_BUFFER), head(0), tail(0), exited(false), busy(false), thread(0), siteCount(0) {}
+
+		BinaryLogSite* findSite(const char* format) const
+		{
+			if (siteFormats.empty()) return NULL;
+			uint32 mask = siteFormats.size() - 1;
+			for (uint32 i = _hashFormat(format) & mask; siteFormats[i]; i = (i + 1) & mask)
+				if (siteFormats[i] == format)
+					return strcmp(sites[i]->format.c_str(), format) == 0 ? sites[i] : NULL;
+			return NULL;
+		}
+
+		void addSite(const char* format, BinaryLogSite* site)
+		{
+			// the address can be cached already with another text
+			if (siteFormats.size()){
+				uint32 mask = siteFormats.size() - 1;
+				for (uint32 i = _hashFormat(format) & mask; siteFormats[i]; i = (i + 1) & mask)
+					if (siteFormats[i] == format){
+						sites[i] = site;
+						return;
+					}
+			}
+
+			// the cache is dropped if too many addresses are used
+			if (siteCount >= NR_LOG_THREAD_SITES){
+				siteFormats.assign(siteFormats.size(), (const char*)NULL);
+				siteCount = 0;
+			}
+
+			// the table is kept at most half full
+			if ((siteCount + 1) * 2 > siteFormats.size()){
+				std::vector<const char*> oldFormats(siteFormats.size() ? siteFormats.size() * 2 : 64, (const char*)NULL);
+				std::vector<BinaryLogSite*> oldSites(oldFormats.size(), (BinaryLogSite*)NULL);
+				oldFormats.swap(siteFormats);
+				oldSites.swap(sites);
+				siteCount = 0;
+				for (uint32 i = 0; i < oldFormats.size(); i++)
+					if (oldFormats[i]) addSite(oldFormats[i], oldSites[i]);
+			}
+
+			uint32 mask = siteFormats.size() - 1;
+			uint32 i = _hashFormat(format) & mask;
+			while (siteFormats[i]) i = (i + 1) & mask;
+			siteFormats[i] = format;
+			sites[i] = site;
+			siteCount++;
+		}
+	};
+
+	//-------------------------------------------------------------------------
+	// The thread holds a reference on its buffer, so the buffer stays valid
+	// even if the thread exits after the logging was released
+	//-------------------------------------------------------------------------
+	static void _logThreadExit(SharedPtr<_LogThreadBuffer>* buffer)
+	{
+		(*buffer)->exited = true;
+		delete buffer;
+	}
+
+	//-------------------------------------------------------------------------
+	// Message read from a ring buffer, sorted by the sequence number
+	//-------------------------------------------------------------------------
+	struct _LogMessage {
+		uint32 seq;
+		int32 target;
+		Log::LogLevel level;
+		uint32 site;
+		uint32 thread;
+		int64 time;
+		std::string text;
+
+		bool operator < (const _LogMessage& m) const { return (int32)(seq - m.seq) < 0; }
+	};
+
+	//-------------------------------------------------------------------------
+	// State of the asynchronous logging
+	//-------------------------------------------------------------------------
+	struct Log::AsyncLog {
+
+		//! True while the messages are logged asynchronously
+		boost::atomic<bool> enabled;
+
+		//! Set to stop the background thread
+		bool stop;
+
+		//! Milliseconds between two writes
+		uint32 interval;
+
+		//! Sequence number of the next message, keeps the order between the threads
+		boost::atomic<uint32> seq;
+
+		//! Buffers of all threads, protected by the mutex
+		std::vector< SharedPtr<_LogThreadBuffer> > buffers;
+
+		//! Buffer of the calling thread
+		boost::thread_specific_ptr< SharedPtr<_LogThreadBuffer> > buffer;
+
+		//! Background thread
+		SharedPtr<boost::thread> thread;
+
+		//! Protects the buffer list and the writing
+		boost::mutex mutex;
+
+		//! Wakes the background thread
+		boost::mutex wakeMutex;
+		boost::condition_variable wake;
+		bool wakeRequested;
+
+		//! Count of threads which got a buffer
+		uint32 threads;
+
+		//! True while the messages are logged binary
+		boost::atomic<bool> binary;
+
+		//! True if the asynchronous logging was enabled by the binary logging
+		bool binaryAsync;
+
+		//! Binary stream, written by the background thread
+		std::ofstream binaryFile;
+
+		//! Sites of the binary logging, the id is the index plus one
+		std::vector< SharedPtr<BinaryLogSite> > sites;
+		std::map<std::string, BinaryLogSite*> siteMap;
+		boost::mutex siteMutex;
+
+		//! Site of the messages formatted as text, if the site limit is reached
+		BinaryLogSite* textSite;
+
+		//! Count of sites written into the binary stream
+		uint32 writtenSites;
+
+		AsyncLog() : enabled(false), stop(false), interval(100), seq(0), buffer(_logThreadExit), wakeRequested(false),
+			threads(0), binary(false), binaryAsync(false), textSite(NULL), writtenSites(0) {}
+
+		//! Wake up the background thread
+		void notify()
+		{
+			boost::mutex::scoped_lock lock(wakeMutex);
+			wakeRequested = true;
+			wake.notify_one();
+		}
+
+		//! Get the buffer of the calling thread, create it on the first call
+		_LogThreadBuffer* getBuffer()
+		{
+			SharedPtr<_LogThreadBuffer>* b = buffer.get();
+			if (b) return b->get();
+
+			boost::mutex::scoped_lock lock(mutex);
+			SharedPtr<_LogThreadBuffer> nb(new _LogThreadBuffer());
+			nb->thread = ++threads;
+			buffers.push_back(nb);
+			buffer.reset(new SharedPtr<_LogThreadBuffer>(nb));
+			return nb.get();
+		}
+
+		//! Get the site of a format string, register it on the first call
+		BinaryLogSite* getSite(_LogThreadBuffer* b, const char* format)
+		{
+			BinaryLogSite* site = b->findSite(format);
+			if (site) return site;
+
+			// the same format can be used by several threads, sites are
+			// identified by the text of the format
+			boost::mutex::scoped_lock lock(siteMutex);
+			std::map<std::string, BinaryLogSite*>::const_iterator it = siteMap.find(format);
+			if (it != siteMap.end()){
+				site = it->second;
+			}else if (sites.size() < NR_LOG_BINARY_SITES){
+				site = addSite(format, false);
+				siteMap[format] = site;
+			}else{
+				// too many formats, probably they are built at runtime
+				if (textSite == NULL) textSite = addSite("<formatted text>", true);
+				return textSite;
+			}
+
+			b->addSite(format, site);
+			return site;
+		}
+
+		//! Create a new site, the site mutex must be locked
+		BinaryLogSite* addSite(const char* format, bool text)
+		{
+			SharedPtr<BinaryLogSite> ns(new BinaryLogSite());
+			ns->id = sites.size() + 1;
+			ns->format = format;
+			ns->text = text || !BinaryLog::parseFormat(format, ns->args);
+			sites.push_back(ns);
+			return ns.get();
+		}
+
+		//! Put a binary message into the buffer of the calling thread
+		void pushBinary(_LogThreadBuffer* b, int32 target, LogLevel level, const char* msg, va_list args)
+		{
+			BinaryLogSite* site = getSite(b, msg);
+
+			// only the arguments are stored, messages of text sites are formatted
+			char data[NR_LOG_BINARY_DATA];
+			uint32 len = 0;
+			if (site->text){
+				int32 res = vsnprintf(data, sizeof(data), msg, args);
+				len = res < 0 ? 0 : (res < (int32)sizeof(data) ? res : sizeof(data) - 1);
+			}else{
+				len = BinaryLog::encode(site->args, args, data, sizeof(data));
+			}
+
+			push(b, target, level, site->id, data, len);
+		}
+
+		//! Put a message or the arguments of a site into the buffer
+		void push(_LogThreadBuffer* b, int32 target, LogLevel level, uint32 site, const char* msg, uint32 len)
+		{
+			// too long messages are cut
+			if (len > NR_LOG_THREAD_BUFFER / 4) len = NR_LOG_THREAD_BUFFER / 4;
+			uint32 need = (sizeof(_LogEntry) + len + 1 + 7) & ~7;
+
+			uint32 head = b->head.load(boost::memory_order_relaxed);
+			uint32 pos = head & (NR_LOG_THREAD_BUFFER - 1);
+			uint32 pad = NR_LOG_THREAD_BUFFER - pos < need ? NR_LOG_THREAD_BUFFER - pos : 0;
+
+			// wait until the background thread has written enough messages
+			while (head + pad + need - b->tail.load(boost::memory_order_acquire) > NR_LOG_THREAD_BUFFER){
+				notify();
+				boost::this_thread::yield();
+			}
+
+			if (pad >= sizeof(_LogEntry)){
+				_LogEntry* e = (_LogEntry*)&b->data[pos];
+				e->size = pad;
+				e->level = -1;
+			}
+			head += pad;
+
+			_LogEntry* e = (_LogEntry*)&b->data[head & (NR_LOG_THREAD_BUFFER - 1)];
+			e->size = need;
+			e->seq = seq.fetch_add(1, boost::memory_order_relaxed);
+			e->target = target;
+			e->level = level;
+			e->site = site;
+			e->length = len;
+			if (site){
+				struct timeval now;
+				gettimeofday(&now, NULL);
+				e->time = (int64)now.tv_sec * 1000000 + now.tv_usec;
+			}else{
+				e->time = (int64)::time(NULL);
+			}
+			memcpy(e + 1, msg, len);
+			((char*)(e + 1))[len] = 0;
+			b->head.store(head + need, boost::memory_order_release);
+
+			// errors are written at once, and full buffers as soon as possible
+			if (level <= LL_ERROR){
+				notify();
+			}else if (head + need - b->tail.load(boost::memory_order_relaxed) > NR_LOG_THREAD_BUFFER / 2){
+				notify();
+			}
+		}
+
+		//! Read the messages of all threads, the mutex must be locked
+		void pop(std::vector<_LogMessage>& messages)
+		{
+			std::vector< SharedPtr<_LogThreadBuffer> >::iterator it;
+			for (it = buffers.begin(); it != buffers.end(); ){
+				_LogThreadBuffer& b = **it;
+				bool exited = b.exited;
+
+				uint32 tail = b.tail.load(boost::memory_order_relaxed);
+				uint32 head = b.head.load(boost::memory_order_acquire);
+				while (tail != head){
+					uint32 pos = tail & (NR_LOG_THREAD_BUFFER - 1);
+					if (NR_LOG_THREAD_BUFFER - pos < sizeof(_LogEntry)){
+						tail += NR_LOG_THREAD_BUFFER - pos;
+						continue;
+					}
+
+					const _LogEntry* e = (const _LogEntry*)&b.data[pos];
+					if (e->level >= 0){
+						_LogMessage m;
+						m.seq = e->seq;
+						m.target = e->target;
+						m.level = (LogLevel)e->level;
+						m.site = e->site;
+						m.thread = b.thread;
+						m.time = e->time;
+						m.text.assign((const char*)(e + 1), e->length);
+						messages.push_back(m);
+					}
+					tail += e->size;
+				}
+				b.tail.store(tail, boost::memory_order_release);
+
+				// buffers of exited threads are removed, when they are empty
+				if (exited && b.head == tail)
+					it = buffers.erase(it);
+				else
+					it++;
+			}
+		}
+	};
+
 	//-------------------------------------------------------------------------
 	Log::Log()
 	{
+		// the state is created once, so the logging threads can always read it
+		_async.reset(new AsyncLog());
+
         _logLevel = LL_NORMAL;
+        _activeTargets = LOG_CONSOLE;
         _bInitialized = false;        
 	}
 	
@@ -28,6 +412,8 @@ namespace nrEngine{
 	Log::~Log()
 	{	
 		log (LOG_ANYTHING, LL_DEBUG, "Logging stopped");
+		setAsync(false);
+		flush();
 		
 		// close streams
 		_kernelLog.close();
@@ -50,6 +436,14 @@ namespace nrEngine{
 		//_serverLog.open((logPath + "/server.log").c_str(), std::ios::out);// | ios::app);
 		_engineLog.open((logPath + "/engine.log").c_str(), std::ios::out);// | ios::app);
 		_pluginLog.open((logPath + "/plugin.log").c_str(), std::ios::out);// | ios::app);
+
+		// messages to the targets without a file are not formatted
+		if (_appLog.is_open()) _activeTargets |= LOG_APP;
+		if (_kernelLog.is_open()) _activeTargets |= LOG_KERNEL;
+		if (_clientLog.is_open()) _activeTargets |= LOG_CLIENT;
+		if (_serverLog.is_open()) _activeTargets |= LOG_SERVER;
+		if (_engineLog.is_open()) _activeTargets |= LOG_ENGINE;
+		if (_pluginLog.is_open()) _activeTargets |= LOG_PLUGIN;
 			
 		log (LOG_ANYTHING, LL_DEBUG, "Logging activated");
 
@@ -61,49 +455,63 @@ namespace nrEngine{
 	//-------------------------------------------------------------------------
 	void Log::log(LogTarget target, const char* msg, ...)
 	{
-		// check whenver we have already initialised the log engine
-        if (!_bInitialized) return;
-        			
-		// get messages 
 		va_list args; 
 		va_start(args,msg);
-		char szBuf[2056];
-		memset(szBuf, 0, sizeof(char)*2056);
-		vsprintf(szBuf,msg,args);
+		logV(target, LL_NORMAL, msg, args);
 		va_end(args);
-		
-		// log the message
-		logIt(target, LL_NORMAL, szBuf);
-		
-		// echo logging
-		if (_echoMap[target]){
-			logIt(_echoMap[target], LL_NORMAL, szBuf);
-		}
-
 	}
 	
 	//-------------------------------------------------------------------------
 	void Log::log(LogTarget target, LogLevel level, const char* msg, ...)
 	{
-        // check whenver we have already initialised the log engine
-        if (!_bInitialized) return;
-			
-		// get messages 
 		va_list args; 
 		va_start(args,msg);
-		char szBuf[2056];
-		memset(szBuf, 0, sizeof(char)*2056);
-		vsprintf(szBuf,msg,args);
+		logV(target, level, msg, args);
 		va_end(args);
-		
+	}
+
+	//-------------------------------------------------------------------------
+	void Log::logV(LogTarget target, LogLevel level, const char* msg, va_list args)
+	{
+		// check whenever the coming message is allowed to be logged
+		if (!isLogged(target, level)) return;
+
+		// the echo map is not changed here, so other threads can read it
+		std::map<int32, int32>::const_iterator echo = _echoMap.find(target);
+
+		// asynchronous messages are logged to the target and its echo at once.
+		// The thread is marked busy before the state is checked, so setAsync()
+		// can wait until the message is in the buffer.
+		if (_async->enabled){
+			_LogThreadBuffer* b = _async->getBuffer();
+			b->busy = true;
+			if (_async->enabled){
+				int32 targets = target | (echo != _echoMap.end() ? echo->second : 0);
+				if (_async->binary){
+					// binary messages are not formatted at all
+					_async->pushBinary(b, targets, level, msg, args);
+				}else{
+					char szBuf[2056];
+					vsnprintf(szBuf, sizeof(szBuf), msg, args);
+					_async->push(b, targets, level, 0, szBuf, strlen(szBuf));
+				}
+				b->busy.store(false, boost::memory_order_release);
+				return;
+			}
+			b->busy.store(false, boost::memory_order_release);
+		}
+
+		// get messages 
+		char szBuf[2056];
+		vsnprintf(szBuf, sizeof(szBuf), msg, args);
+
 		// log the message
 		logIt(target, level, szBuf);
-		
+
 		// echo logging
-		if (_echoMap[target]){
-			logIt(_echoMap[target], level, szBuf);
+		if (echo != _echoMap.end() && echo->second){
+			logIt(echo->second, level, szBuf);
 		}
-		
 	}
 
 	//-------------------------------------------------------------------------
@@ -111,13 +519,21 @@ namespace nrEngine{
     {
 		// check whenever the coming message is allowed to be logged
 		if (level > _logLevel) return;
-		
+
+		// the background thread writes into the same streams
+		boost::mutex::scoped_lock lock(_async->mutex);
+		writeIt(target, level, time(NULL), msg, true);
+	}
+
+	//-------------------------------------------------------------------------
+	void Log::writeIt(int32 target, LogLevel level, time_t logTime, const char *msg, bool flush)
+	{
 		// get messages 
 		const char *szBuf = msg;
 		
 		// Get time & date string
-		time_t _time = time(NULL);
-		tm* time = localtime(&_time);
+		struct tm timeBuf;
+		tm* time = localtime_r(&logTime, &timeBuf);
 		
 		// create the string before the message		
 		char timeDate[255];
@@ -131,41 +547,214 @@ namespace nrEngine{
 		// Check whereever to log
 		if((target & LOG_APP) && _appLog.is_open()){
 			_appLog << timeDate << ": " << szBuf << "\n";
-			_appLog.flush();
+			if (flush) _appLog.flush();
 		}
 		
 		if((target & LOG_CLIENT) && _clientLog.is_open()){
 			_clientLog << timeDate << ": " << szBuf << "\n";
-			_clientLog.flush();
+			if (flush) _clientLog.flush();
 		}
 		
 		if((target & LOG_SERVER) && _serverLog.is_open()){
 			_serverLog << timeDate << ": " << szBuf << "\n";
-			_serverLog.flush();
+			if (flush) _serverLog.flush();
 		}
 		
 		if((target & LOG_KERNEL) && _kernelLog.is_open()){
 			_kernelLog << timeDate << ": " << szBuf << "\n";
-			_kernelLog.flush();
+			if (flush) _kernelLog.flush();
 		}
 		
 		if((target & LOG_ENGINE) && _engineLog.is_open()){
 			_engineLog << timeDate << ": " << szBuf << "\n";
-			_engineLog.flush();
+			if (flush) _engineLog.flush();
 		}
 		
 		if((target & LOG_PLUGIN) && _pluginLog.is_open()){
 			_pluginLog << timeDate << ": " << szBuf << "\n";
-			_pluginLog.flush();
+			if (flush) _pluginLog.flush();
 		}
 	
 		if (target & LOG_CONSOLE){
 			std::cout << timeDate << ": " << szBuf << "\n";
-			std::cout.flush();
+			if (flush) std::cout.flush();
 		}
 			
 	}
 
+	//-------------------------------------------------------------------------
+	void Log::setAsync(bool async, float32 flushInterval)
+	{
+		// the binary logging needs the background thread
+		if (!async && isBinary()) setBinary(false);
+
+		if (async == isAsync()) return;
+
+		if (async){
+			_async->interval = flushInterval > 0.0f ? (uint32)(flushInterval * 1000.0f) : 1;
+			_async->stop = false;
+			_async->enabled = true;
+			_async->thread.reset(new boost::thread(boost::bind(&Log::asyncThread, this)));
+			return;
+		}
+
+		// threads which passed the check of the state finish their message first.
+		// The background thread still runs, so they do not wait for a full buffer forever.
+		_async->enabled = false;
+		std::vector< SharedPtr<_LogThreadBuffer> > buffers;
+		{
+			boost::mutex::scoped_lock lock(_async->mutex);
+			buffers = _async->buffers;
+		}
+		for (uint32 i = 0; i < buffers.size(); i++){
+			while (buffers[i]->busy){
+				_async->notify();
+				boost::this_thread::yield();
+			}
+		}
+
+		// stop the background thread and write the rest
+		{
+			boost::mutex::scoped_lock lock(_async->wakeMutex);
+			_async->stop = true;
+			_async->wake.notify_one();
+		}
+		_async->thread->join();
+		_async->thread.reset();
+		writeAsync();
+	}
+
+	//-------------------------------------------------------------------------
+	bool Log::isAsync() const
+	{
+		return _async->enabled;
+	}
+
+	//-------------------------------------------------------------------------
+	Result Log::setBinary(bool binary, const std::string& fileName)
+	{
+		if (binary == isBinary()) return OK;
+
+		if (binary){
+			std::string file = logPath + "/" + fileName;
+			{
+				boost::mutex::scoped_lock lock(_async->mutex);
+				_async->binaryFile.open(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!_async->binaryFile.is_open()){
+					lock.unlock();
+					log(LOG_ENGINE, LL_ERROR, "Log: Can not create binary log file %s", file.c_str());
+					return FILE_ERROR;
+				}
+
+				// the sites are written again into the new stream
+				BinaryLog::writeHeader(_async->binaryFile);
+				_async->writtenSites = 0;
+			}
+			log(LOG_ENGINE, "Log: Start binary logging into %s", file.c_str());
+
+			_async->binaryAsync = !isAsync();
+			if (_async->binaryAsync) setAsync(true);
+			_async->binary = true;
+			return OK;
+		}
+
+		// binary messages logged meanwhile are written as text
+		_async->binary = false;
+		if (_async->binaryAsync)
+			setAsync(false);
+		else
+			writeAsync();
+
+		boost::mutex::scoped_lock lock(_async->mutex);
+		_async->binaryFile.close();
+		return OK;
+	}
+
+	//-------------------------------------------------------------------------
+	bool Log::isBinary() const
+	{
+		return _async->binary;
+	}
+
+	//-------------------------------------------------------------------------
+	void Log::flush()
+	{
+		writeAsync();
+	}
+
+	//-------------------------------------------------------------------------
+	void Log::writeAsync()
+	{
+		boost::mutex::scoped_lock lock(_async->mutex);
+
+		std::vector<_LogMessage> messages;
+		_async->pop(messages);
+
+		// the messages of all threads are written in the order they were logged
+		std::sort(messages.begin(), messages.end());
+
+		// sites are registered before their messages, so all sites of the messages are known here
+		std::vector< SharedPtr<BinaryLogSite> > sites;
+		{
+			boost::mutex::scoped_lock lock(_async->siteMutex);
+			sites = _async->sites;
+		}
+		bool binary = _async->binaryFile.is_open();
+		if (binary){
+			for (; _async->writtenSites < sites.size(); _async->writtenSites++)
+				BinaryLog::writeSite(_async->binaryFile, *sites[_async->writtenSites]);
+		}
+
+		std::vector<_LogMessage>::const_iterator it;
+		for (it = messages.begin(); it != messages.end(); it++){
+			if (it->site == 0){
+				writeIt(it->target, it->level, (time_t)it->time, it->text.c_str(), false);
+				continue;
+			}
+
+			BinaryLogRecord record;
+			record.site = it->site;
+			record.thread = it->thread;
+			record.target = it->target;
+			record.level = it->level;
+			record.time = it->time;
+			record.data = it->text;
+
+			if (binary)
+				BinaryLog::writeRecord(_async->binaryFile, record);
+			else
+				writeIt(it->target, it->level, (time_t)(it->time / 1000000), BinaryLog::format(*sites[it->site - 1], record).c_str(), false);
+		}
+
+		// the files are flushed once per batch
+		if (messages.size()){
+			if (binary) _async->binaryFile.flush();
+			if (_appLog.is_open()) _appLog.flush();
+			if (_clientLog.is_open()) _clientLog.flush();
+			if (_serverLog.is_open()) _serverLog.flush();
+			if (_kernelLog.is_open()) _kernelLog.flush();
+			if (_engineLog.is_open()) _engineLog.flush();
+			if (_pluginLog.is_open()) _pluginLog.flush();
+			std::cout.flush();
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	void Log::asyncThread()
+	{
+		while (true){
+			{
+				boost::mutex::scoped_lock lock(_async->wakeMutex);
+				if (!_async->stop && !_async->wakeRequested)
+					_async->wake.timed_wait(lock, boost::posix_time::milliseconds(_async->interval));
+				_async->wakeRequested = false;
+				if (_async->stop) return;
+			}
+
+			writeAsync();
+		}
+	}
+
 	//-------------------------------------------------------------------------
 	std::string Log::getLevelStr(LogLevel level)
 	{
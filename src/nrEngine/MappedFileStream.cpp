@@ -0,0 +1,112 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/MappedFileStream.h>
+#include <nrEngine/Log.h>
+#include <boost/checked_delete.hpp>
+
+#if NR_PLATFORM != NR_PLATFORM_WIN32
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace nrEngine {
+
+#if NR_PLATFORM != NR_PLATFORM_WIN32
+	//----------------------------------------------------------------------------------
+	// Deleter used to unmap the file as soon as nobody reference it anymore
+	//----------------------------------------------------------------------------------
+	struct _FileUnmapper {
+		size_t size;
+		_FileUnmapper(size_t s) : size(s) {}
+		void operator()(byte* ptr)
+		{
+			munmap(ptr, size);
+		}
+	};
+#endif
+
+	//----------------------------------------------------------------------------------
+	MappedFileStream::MappedFileStream()
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	MappedFileStream::~MappedFileStream()
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<byte> MappedFileStream::map(const std::string& fileName, size_t& size)
+	{
+		size = 0;
+
+	#if NR_PLATFORM != NR_PLATFORM_WIN32
+		int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (fd < 0) return SharedPtr<byte>();
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0){
+			::close(fd);
+			return SharedPtr<byte>();
+		}
+
+		void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (ptr == MAP_FAILED) return SharedPtr<byte>();
+
+		size = st.st_size;
+		return SharedPtr<byte>((byte*)ptr, _FileUnmapper(size));
+	#else
+		// no memory mapping available, so read the whole file
+		std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+		if (!file.good()) return SharedPtr<byte>();
+
+		file.seekg(0, std::ios_base::end);
+		size_t fileSize = file.tellg();
+		file.seekg(0, std::ios_base::beg);
+		if (fileSize == 0) return SharedPtr<byte>();
+
+		SharedPtr<byte> data(new byte[fileSize], boost::checked_array_deleter<byte>());
+		file.read((char*)data.get(), fileSize);
+		size = file.gcount();
+		return data;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MappedFileStream::open (const std::string& fileName)
+	{
+		size_t size = 0;
+		SharedPtr<byte> data = map(fileName, size);
+
+		if (!data){
+			// empty files can not be mapped, but they are valid files
+			std::ifstream file(fileName.c_str());
+			if (!file.good()){
+				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "The file \"%s\" was not found", fileName.c_str());
+				return FILE_NOT_FOUND;
+			}
+		}
+
+		setData(data, data.get(), size);
+		return OK;
+	}
+
+};
+
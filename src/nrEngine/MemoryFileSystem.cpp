@@ -0,0 +1,200 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/MemoryFileSystem.h>
+#include <nrEngine/LocalFileSystem.h>
+#include <nrEngine/MemoryStream.h>
+#include <nrEngine/Log.h>
+#include <boost/checked_delete.hpp>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	MemoryFileSystem::MemoryFileSystem()
+	{
+		mType = "memory";
+	}
+
+	//----------------------------------------------------------------------------------
+	MemoryFileSystem::~MemoryFileSystem()
+	{
+		clear();
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::initialize()
+	{
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::deinitialize()
+	{
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::addFile(const std::string& fileName, const void* data, size_t size)
+	{
+		if (data == NULL && size > 0) return BAD_PARAMETERS;
+
+		// copy the data, add zero at the end, so text files can be used as strings
+		SharedPtr<byte> buffer(new byte[size + 1], boost::checked_array_deleter<byte>());
+		if (size) memcpy(buffer.get(), data, size);
+		buffer.get()[size] = 0;
+
+		return registerBuffer(fileName, buffer, buffer.get(), size);
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::registerBuffer(const std::string& fileName, SharedPtr<byte> holder, const byte* data, size_t size)
+	{
+		if (data == NULL && size > 0) return BAD_PARAMETERS;
+
+		boost::mutex::scoped_lock lock(mMutex);
+		Blob& blob = mFiles[normalizeName(fileName)];
+		blob.holder = holder;
+		blob.data = data;
+		blob.size = size;
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::snapshot(const std::string& diskFileName, const std::string& fileName)
+	{
+		std::ifstream file(diskFileName.c_str(), std::ios::in | std::ios::binary);
+		if (!file.good()){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "MemoryFileSystem: The file \"%s\" was not found", diskFileName.c_str());
+			return FILE_NOT_FOUND;
+		}
+
+		// calculate the size
+		file.seekg(0, std::ios_base::end);
+		size_t size = file.tellg();
+		file.seekg(0, std::ios_base::beg);
+
+		// read the file directly into its own buffer
+		SharedPtr<byte> buffer(new byte[size + 1], boost::checked_array_deleter<byte>());
+		file.read((char*)buffer.get(), size);
+		size = file.gcount();
+		buffer.get()[size] = 0;
+
+		return registerBuffer(fileName.length() ? fileName : diskFileName, buffer, buffer.get(), size);
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::snapshotDirectory(const std::string& directory, const std::string& pattern)
+	{
+		LocalFileSystem dir(directory);
+		FileInfoListPtr files = dir.findFiles(pattern, true);
+
+		Result ret = OK;
+		for (FileInfoList::iterator it = files->begin(); it != files->end(); it++){
+			Result res = snapshot(it->realPath, it->name);
+			if (res != OK) ret = res;
+		}
+
+		NR_Log(Log::LOG_ENGINE, "MemoryFileSystem: %d files from \"%s\" copied into the memory", (int32)files->size(), directory.c_str());
+
+		return ret;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryFileSystem::removeFile(const std::string& fileName)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		FileMap::iterator it = mFiles.find(normalizeName(fileName));
+		if (it == mFiles.end()) return VFS_FILE_NOT_FOUND;
+
+		mFiles.erase(it);
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	void MemoryFileSystem::clear()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		mFiles.clear();
+	}
+
+	//----------------------------------------------------------------------------------
+	size_t MemoryFileSystem::getDataSize() const
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		size_t size = 0;
+		for (FileMap::const_iterator it = mFiles.begin(); it != mFiles.end(); it++)
+			size += it->second.size;
+		return size;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool MemoryFileSystem::exists(const std::string& fileName)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		return mFiles.find(normalizeName(fileName)) != mFiles.end();
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr MemoryFileSystem::listFiles(bool recursive)
+	{
+		return findFiles("*", recursive);
+	}
+
+	//----------------------------------------------------------------------------------
+	IFileSystem::FileInfoListPtr MemoryFileSystem::findFiles(const std::string& pattern, bool recursive)
+	{
+		FileInfoListPtr list(new FileInfoList());
+		std::string pat = normalizeName(pattern);
+
+		boost::mutex::scoped_lock lock(mMutex);
+		for (FileMap::const_iterator it = mFiles.begin(); it != mFiles.end(); it++){
+			if (!matchPattern(pat, it->first, recursive)) continue;
+
+			FileInfo info;
+			info.fsParent = this;
+			info.name = it->first;
+			info.realPath = "memory:" + it->first;
+			info.size = it->second.size;
+
+			std::string::size_type slash = info.name.rfind('/');
+			info.path = (slash == std::string::npos) ? std::string() : info.name.substr(0, slash + 1);
+
+			list->push_back(info);
+		}
+
+		return list;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<FileStream> MemoryFileSystem::open(const std::string& filename, PropertyList* params)
+	{
+		std::string name = normalizeName(filename);
+
+		boost::mutex::scoped_lock lock(mMutex);
+		FileMap::const_iterator it = mFiles.find(name);
+		if (it == mFiles.end()){
+			lock.unlock();
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "MemoryFileSystem: File \"%s\" not found", filename.c_str());
+			return SharedPtr<FileStream>();
+		}
+
+		const Blob& blob = it->second;
+		return SharedPtr<FileStream>(new MemoryStream(blob.holder, blob.data, blob.size));
+	}
+
+};
+
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/MemoryStream.h>
+#include <nrEngine/Log.h>
+#include <boost/checked_delete.hpp>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	MemoryStream::MemoryStream() : mData(NULL), mPos(0)
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	MemoryStream::MemoryStream(SharedPtr<byte> holder, const byte* data, size_t size) : mData(NULL), mPos(0)
+	{
+		setData(holder, data, size);
+	}
+
+	//----------------------------------------------------------------------------------
+	MemoryStream::~MemoryStream()
+	{
+		close();
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryStream::unloadResource()
+	{
+		close();
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryStream::reloadResource(PropertyList* params)
+	{
+		// views on foreign memory can not be reloaded, they are valid as long as they exists
+		if (getResourceFilenameList().size() == 0) return OK;
+		return open(getResourceFilenameList().front());
+	}
+
+	//----------------------------------------------------------------------------------
+	void MemoryStream::setData(SharedPtr<byte> holder, const byte* data, size_t size)
+	{
+		mHolder = holder;
+		mData = data;
+		mSize = size;
+		mPos = 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result MemoryStream::open (const std::string& fileName)
+	{
+		std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+		if (!file.good())
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "The file \"%s\" was not found", fileName.c_str());
+			return FILE_NOT_FOUND;
+		}
+
+		// calculate the size
+		file.seekg(0, std::ios_base::end);
+		size_t size = file.tellg();
+		file.seekg(0, std::ios_base::beg);
+
+		// read the whole file into the memory
+		SharedPtr<byte> data(new byte[size + 1], boost::checked_array_deleter<byte>());
+		file.read((char*)data.get(), size);
+		size = file.gcount();
+		data.get()[size] = 0;
+
+		setData(data, data.get(), size);
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	void MemoryStream::close()
+	{
+		mHolder.reset();
+		mData = NULL;
+		mSize = 0;
+		mPos = 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	size_t MemoryStream::read(void *buf, size_t size, size_t nmemb)
+	{
+		if (!mData || size == 0) return 0;
+
+		// like FileStream, the bytes left are read, if there are less than requested
+		size_t avail = mSize - mPos;
+		size_t count = nmemb > avail / size ? avail : size * nmemb;
+		memcpy(buf, mData + mPos, count);
+		mPos += count;
+
+		return count;
+	}
+
+	//----------------------------------------------------------------------------------
+	size_t MemoryStream::readDelim(void* buf, size_t count, const std::string& delim)
+	{
+		if (!mData) return 0;
+		if (delim.empty()){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "MemoryStream::readDelim(): No delimiter provided");
+			return 0;
+		}
+
+		char* out = static_cast<char*>(buf);
+		const char* start = (const char*)mData + mPos;
+		size_t avail = std::min(count, mSize - mPos);
+
+		// search for the delimiter in the data available
+		const char* end = (const char*)memchr(start, delim[0], avail);
+		size_t ret = end ? size_t(end - start) : avail;
+
+		memcpy(out, start, ret);
+		mPos += ret;
+
+		// skip the delimiter itself
+		if (end) mPos++;
+
+		// trim off CR if we found CR/LF
+		if (delim[0] == '\n' && ret > 0 && out[ret-1] == '\r') --ret;
+		out[ret] = '\0';
+
+		return ret;
+	}
+
+	//----------------------------------------------------------------------------------
+	size_t MemoryStream::tell() const
+	{
+		return mPos;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool MemoryStream::eof() const
+	{
+		return mPos >= mSize;
+	}
+
+	//----------------------------------------------------------------------------------
+	byte* MemoryStream::getData(size_t& count) const
+	{
+		if (!mData || mPos >= mSize){
+			count = 0;
+			return NULL;
+		}
+
+		count = mSize - mPos;
+		return const_cast<byte*>(mData + mPos);
+	}
+
+	//----------------------------------------------------------------------------------
+	bool MemoryStream::seek(int32 offset, int32 whence)
+	{
+		if (!mData) return false;
+
+		int64 pos = offset;
+		if (whence == IStream::CURRENT)
+			pos += mPos;
+		else if (whence == IStream::END)
+			pos += mSize;
+
+		if (pos < 0 || pos > (int64)mSize) return false;
+
+		mPos = (size_t)pos;
+		return true;
+	}
+
+};
+
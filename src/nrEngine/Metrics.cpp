@@ -0,0 +1,362 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/Metrics.h>
+#include <nrEngine/Log.h>
+#include <nrEngine/GetTime.h>
+#include <stdio.h>
+#include <math.h>
+
+namespace nrEngine{
+
+	//----------------------------------------------------------------------------------
+	// Quantiles written for each histogram
+	//----------------------------------------------------------------------------------
+	static const float64 _quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+	//----------------------------------------------------------------------------------
+	// Get index of the highest set bit, the value must not be 0
+	//----------------------------------------------------------------------------------
+	static NR_FORCEINLINE uint32 _highestBit(uint64 value)
+	{
+	#if NR_COMPILER == NR_COMPILER_GNUC
+		return 63 - __builtin_clzll(value);
+	#else
+		uint32 bit = 0;
+		if (value >> 32) { value >>= 32; bit += 32; }
+		if (value >> 16) { value >>= 16; bit += 16; }
+		if (value >> 8) { value >>= 8; bit += 8; }
+		if (value >> 4) { value >>= 4; bit += 4; }
+		if (value >> 2) { value >>= 2; bit += 2; }
+		if (value >> 1) bit += 1;
+		return bit;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	// Get bucket of a value in nanoseconds
+	//----------------------------------------------------------------------------------
+	static NR_FORCEINLINE uint32 _bucket(uint64 ns)
+	{
+		if (ns >= ((uint64)1 << NR_METRICS_MAX_BITS)) return NR_METRICS_BUCKETS - 1;
+		if (ns < (1 << NR_METRICS_SUB_BITS)) return (uint32)ns;
+
+		// the highest bit selects the power of two, the next bits the linear bucket in it
+		uint32 msb = _highestBit(ns);
+		uint32 shift = msb - NR_METRICS_SUB_BITS;
+		return ((shift + 1) << NR_METRICS_SUB_BITS) | (uint32)((ns >> shift) & ((1 << NR_METRICS_SUB_BITS) - 1));
+	}
+
+	//----------------------------------------------------------------------------------
+	// Get upper bound of a bucket in nanoseconds
+	//----------------------------------------------------------------------------------
+	static uint64 _bucketBound(uint32 bucket)
+	{
+		if (bucket < (1 << NR_METRICS_SUB_BITS)) return bucket + 1;
+
+		uint32 shift = (bucket >> NR_METRICS_SUB_BITS) - 1;
+		uint64 low = (uint64)((1 << NR_METRICS_SUB_BITS) | (bucket & ((1 << NR_METRICS_SUB_BITS) - 1))) << shift;
+		return low + ((uint64)1 << shift);
+	}
+
+	//----------------------------------------------------------------------------------
+	// Format a value in the Prometheus text format
+	//----------------------------------------------------------------------------------
+	static std::string _value(float64 value)
+	{
+		char buf[64];
+		sprintf(buf, "%.9g", value);
+		return buf;
+	}
+
+	//----------------------------------------------------------------------------------
+	// Get name of a sample with labels, extra labels are added to the metric labels
+	//----------------------------------------------------------------------------------
+	static std::string _sample(const std::string& name, const std::string& labels, const std::string& extra = "")
+	{
+		if (labels.length() == 0 && extra.length() == 0) return name;
+		if (labels.length() == 0) return name + "{" + extra + "}";
+		if (extra.length() == 0) return name + "{" + labels + "}";
+		return name + "{" + labels + "," + extra + "}";
+	}
+
+	//----------------------------------------------------------------------------------
+	MetricGauge::MetricGauge() : mBits(0)
+	{
+		set(0);
+	}
+
+	//----------------------------------------------------------------------------------
+	void MetricGauge::set(float64 value)
+	{
+		uint64 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		mBits.store(bits, boost::memory_order_relaxed);
+	}
+
+	//----------------------------------------------------------------------------------
+	void MetricGauge::add(float64 value)
+	{
+		uint64 bits = mBits.load(boost::memory_order_relaxed);
+		uint64 next;
+		do{
+			float64 v;
+			memcpy(&v, &bits, sizeof(v));
+			v += value;
+			memcpy(&next, &v, sizeof(next));
+		}while (!mBits.compare_exchange_weak(bits, next, boost::memory_order_relaxed));
+	}
+
+	//----------------------------------------------------------------------------------
+	float64 MetricGauge::get() const
+	{
+		uint64 bits = mBits.load(boost::memory_order_relaxed);
+		float64 v;
+		memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	//----------------------------------------------------------------------------------
+	MetricHistogram::MetricHistogram() : mCount(0), mSum(0), mMax(0)
+	{
+		for (int32 i=0; i < NR_METRICS_BUCKETS; i++) mBuckets[i] = 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	void MetricHistogram::add(float64 seconds)
+	{
+		addNanoseconds(seconds > 0 ? (uint64)(seconds * 1000000000.0) : 0);
+	}
+
+	//----------------------------------------------------------------------------------
+	void MetricHistogram::addNanoseconds(uint64 ns)
+	{
+		mBuckets[_bucket(ns)].fetch_add(1, boost::memory_order_relaxed);
+		mCount.fetch_add(1, boost::memory_order_relaxed);
+		mSum.fetch_add(ns, boost::memory_order_relaxed);
+
+		uint64 max = mMax.load(boost::memory_order_relaxed);
+		while (ns > max && !mMax.compare_exchange_weak(max, ns, boost::memory_order_relaxed)){}
+	}
+
+	//----------------------------------------------------------------------------------
+	float64 MetricHistogram::getSum() const
+	{
+		return (float64)mSum.load(boost::memory_order_relaxed) * 0.000000001;
+	}
+
+	//----------------------------------------------------------------------------------
+	float64 MetricHistogram::getMax() const
+	{
+		return (float64)mMax.load(boost::memory_order_relaxed) * 0.000000001;
+	}
+
+	//----------------------------------------------------------------------------------
+	float64 MetricHistogram::getQuantile(float64 part) const
+	{
+		// the buckets are read while other threads add values, so the count is taken from them
+		uint64 count = 0;
+		for (int32 i=0; i < NR_METRICS_BUCKETS; i++) count += mBuckets[i].load(boost::memory_order_relaxed);
+		if (count == 0) return 0;
+
+		uint64 limit = (uint64)ceil(part * (float64)count);
+		if (limit == 0) limit = 1;
+
+		uint64 max = mMax.load(boost::memory_order_relaxed);
+		uint64 sum = 0;
+		for (int32 i=0; i < NR_METRICS_BUCKETS; i++){
+			sum += mBuckets[i].load(boost::memory_order_relaxed);
+			if (sum >= limit){
+				uint64 bound = _bucketBound(i);
+				return (float64)(bound < max ? bound : max) * 0.000000001;
+			}
+		}
+		return (float64)max * 0.000000001;
+	}
+
+	//----------------------------------------------------------------------------------
+	Metrics::Metrics() : ITask(), mExportInterval(0), mLastExport(0)
+	{
+		setTaskName("Metrics");
+	}
+
+	//----------------------------------------------------------------------------------
+	Metrics::~Metrics()
+	{
+		MetricMap::iterator it;
+		for (it = mMetrics.begin(); it != mMetrics.end(); it++){
+			switch (it->second.type){
+				case COUNTER: delete (MetricCounter*)it->second.metric; break;
+				case GAUGE: delete (MetricGauge*)it->second.metric; break;
+				case HISTOGRAM: delete (MetricHistogram*)it->second.metric; break;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string Metrics::label(const std::string& name, const std::string& value)
+	{
+		std::string res = name + "=\"";
+		for (uint32 i=0; i < value.length(); i++){
+			if (value[i] == '\\' || value[i] == '"') res += '\\';
+			if (value[i] == '\n')
+				res += "\\n";
+			else
+				res += value[i];
+		}
+		return res + "\"";
+	}
+
+	//----------------------------------------------------------------------------------
+	void* Metrics::get(MetricType type, const std::string& name, const std::string& help, const std::string& labels)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+
+		FamilyMap::iterator f = mFamilies.find(name);
+		if (f == mFamilies.end()){
+			Family family;
+			family.type = type;
+			family.help = help;
+			f = mFamilies.insert(std::make_pair(name, family)).first;
+		}else if (f->second.type != type){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "Metrics: %s is already used by a metric of another type", name.c_str());
+			return NULL;
+		}
+
+		std::string key = name + "{" + labels + "}";
+		MetricMap::iterator it = mMetrics.find(key);
+		if (it != mMetrics.end()) return it->second.metric;
+
+		Metric m;
+		m.type = type;
+		m.name = name;
+		m.labels = labels;
+		switch (type){
+			case COUNTER: m.metric = new MetricCounter(); break;
+			case GAUGE: m.metric = new MetricGauge(); break;
+			case HISTOGRAM: m.metric = new MetricHistogram(); break;
+		}
+		mMetrics[key] = m;
+		return m.metric;
+	}
+
+	//----------------------------------------------------------------------------------
+	MetricCounter* Metrics::getCounter(const std::string& name, const std::string& help, const std::string& labels)
+	{
+		return (MetricCounter*)get(COUNTER, name, help, labels);
+	}
+
+	//----------------------------------------------------------------------------------
+	MetricGauge* Metrics::getGauge(const std::string& name, const std::string& help, const std::string& labels)
+	{
+		return (MetricGauge*)get(GAUGE, name, help, labels);
+	}
+
+	//----------------------------------------------------------------------------------
+	MetricHistogram* Metrics::getHistogram(const std::string& name, const std::string& help, const std::string& labels)
+	{
+		return (MetricHistogram*)get(HISTOGRAM, name, help, labels);
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string Metrics::exportText()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+
+		// the metrics of one name follow each other in the map
+		std::string out, maxOut, lastName;
+		MetricMap::const_iterator it;
+		for (it = mMetrics.begin(); it != mMetrics.end(); it++){
+			const Metric& m = it->second;
+
+			if (m.name != lastName){
+				out += maxOut;
+				maxOut = "";
+				lastName = m.name;
+
+				const Family& f = mFamilies[m.name];
+				if (f.help.length()) out += "# HELP " + m.name + " " + f.help + "\n";
+				out += "# TYPE " + m.name + (m.type == COUNTER ? " counter\n" : (m.type == GAUGE ? " gauge\n" : " summary\n"));
+				if (m.type == HISTOGRAM)
+					maxOut = "# TYPE " + m.name + "_max gauge\n";
+			}
+
+			if (m.type == COUNTER){
+				out += _sample(m.name, m.labels) + " " + _value((float64)((MetricCounter*)m.metric)->get()) + "\n";
+			}else if (m.type == GAUGE){
+				out += _sample(m.name, m.labels) + " " + _value(((MetricGauge*)m.metric)->get()) + "\n";
+			}else{
+				const MetricHistogram* h = (const MetricHistogram*)m.metric;
+				for (uint32 q=0; q < sizeof(_quantiles) / sizeof(_quantiles[0]); q++)
+					out += _sample(m.name, m.labels, "quantile=\"" + _value(_quantiles[q]) + "\"") + " " + _value(h->getQuantile(_quantiles[q])) + "\n";
+				out += _sample(m.name + "_sum", m.labels) + " " + _value(h->getSum()) + "\n";
+				out += _sample(m.name + "_count", m.labels) + " " + _value((float64)h->getCount()) + "\n";
+				maxOut += _sample(m.name + "_max", m.labels) + " " + _value(h->getMax()) + "\n";
+			}
+		}
+		out += maxOut;
+
+		return out;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result Metrics::exportFile(const std::string& fileName)
+	{
+		std::string text = exportText();
+
+		// the file is written beside and renamed, so it is replaced at once
+		std::string tmpName = fileName + ".tmp";
+		FILE* file = fopen(tmpName.c_str(), "w");
+		if (file == NULL){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "Metrics: Can not write the metrics into %s", fileName.c_str());
+			return FILE_ERROR;
+		}
+		fwrite(text.data(), 1, text.length(), file);
+		fclose(file);
+
+		if (rename(tmpName.c_str(), fileName.c_str()) != 0){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "Metrics: Can not replace %s", fileName.c_str());
+			remove(tmpName.c_str());
+			return FILE_ERROR;
+		}
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	void Metrics::setExport(const std::string& fileName, float32 interval)
+	{
+		mExportFile = fileName;
+		mExportInterval = interval;
+		mLastExport = getMonotonicTime();
+
+		if (interval > 0)
+			NR_Log(Log::LOG_ENGINE, "Metrics: Export the metrics into %s each %g seconds", fileName.c_str(), interval);
+	}
+
+	//----------------------------------------------------------------------------------
+	Result Metrics::updateTask()
+	{
+		if (mExportInterval <= 0 || mExportFile.length() == 0) return OK;
+
+		uint64 now = getMonotonicTime();
+		if ((float64)(now - mLastExport) * 0.000000001 < mExportInterval) return OK;
+		mLastExport = now;
+
+		return exportFile(mExportFile);
+	}
+
+}; // end namespace
+
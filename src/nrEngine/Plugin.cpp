@@ -43,7 +43,7 @@ namespace nrEngine {
 	//----------------------------------------------------------------------------------
 	Result Plugin::initialize(PropertyList* params)
 	{
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Check if the loaded library is valid plugin");
+		NR_LogDebug(Log::LOG_ENGINE, "Check if the loaded library is valid plugin");
 
 		// get version information
 		m_plgEngineVersion = (plgEngineVersion)getSymbol("plgEngineVersion");
@@ -70,7 +70,7 @@ namespace nrEngine {
 
 #define GET_SYMBOL(var, type)\
 		{\
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Get plugin symbol %s", #type);\
+			NR_LogDebug(Log::LOG_ENGINE, "Get plugin symbol %s", #type);\
 			var = (type)getSymbol(#type);\
 			if (!var){\
 				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "Plugin symbol %s was not found", #type);\
@@ -102,7 +102,7 @@ namespace nrEngine {
 			// get the list of methods provided by this plugin
 			m_plgGetMethods(mPlgMethods);
 
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Plugin provides following symbols: ");
+			NR_LogDebug(Log::LOG_ENGINE, "Plugin provides following symbols: ");
 
 			// now go through each of this method and print some log info about it
 			for (uint32 i=0; i < mPlgMethods.size(); i++){
@@ -111,7 +111,7 @@ namespace nrEngine {
 					params += mPlgMethods[i].param[j].name;
 					if (j < mPlgMethods[i].param.size() - 1) params += ", ";
 				}
-				NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "  found  -  %s (%s)", mPlgMethods[i].name.c_str(), params.c_str());
+				NR_LogDebug(Log::LOG_ENGINE, "  found  -  %s (%s)", mPlgMethods[i].name.c_str(), params.c_str());
 			}		
 		}*/
 		
@@ -18,270 +18,806 @@
 #include <nrEngine/Profiler.h>
 #include <nrEngine/Exception.h>
 #include <nrEngine/TimeSource.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+#include <nrEngine/Clock.h>
+#include <nrEngine/SampleProfiler.h>
+#include <fstream>
+#include <math.h>
 
 namespace nrEngine{
 
 	//--------------------------------------------------------------------
-	Profile::Profile(const std::string& name, bool isSystemProfile) : mName(name), mSystemProfile(isSystemProfile)
+	// Names of the registered zones, shared by all profilers
+	//--------------------------------------------------------------------
+	struct _ZoneRegistry {
+		boost::mutex mutex;
+		std::vector<std::string> names;
+		std::vector<bool> system;
+		std::map<std::string, ProfileZone> zones;
+	};
+
+	static _ZoneRegistry& _zoneRegistry()
+	{
+		static _ZoneRegistry registry;
+		return registry;
+	}
+
+	//--------------------------------------------------------------------
+	Profile::Profile(const std::string& name, bool isSystemProfile) : mZone(Profiler::registerZone(name, isSystemProfile))
 	{
-		Engine::sProfiler()->beginProfile(mName, isSystemProfile);
+		mActive = Engine::sProfiler()->beginZone(mZone, isSystemProfile);
+	}
+
+	//--------------------------------------------------------------------
+	Profile::Profile(ProfileZone zone, bool isSystemProfile) : mZone(zone)
+	{
+		mActive = Engine::sProfiler()->beginZone(mZone, isSystemProfile);
 	}
 	
 	//--------------------------------------------------------------------
 	Profile::~Profile()
 	{
-		Engine::sProfiler()->endProfile(mName, mSystemProfile);
+		if (mActive) Engine::sProfiler()->endZone(mZone);
 	}
 	
 	
 	
 	//--------------------------------------------------------------------
-	Profiler::Profiler(SharedPtr<TimeSource> timeSource)
+	// Count of records in the ring buffer of a thread, must be a power of two
+	//--------------------------------------------------------------------
+	static const uint32 NR_PROFILE_THREAD_RECORDS = 8192;
+
+	//--------------------------------------------------------------------
+	// Profiles of one thread. The stack, the frame statistics and the history
+	// are used by the kernel thread only. The other threads write into the
+	// ring buffer, which is read by the kernel thread at the end of a frame.
+	//--------------------------------------------------------------------
+	struct Profiler::ThreadProfile {
+
+		//! Index of the thread, 0 for the kernel thread
+		uint32 id;
+
+		//! True for the thread which created the profiler
+		bool kernel;
+
+		//! A stack for each individual profile per frame, only the first depth entries are used
+		ProfileStack stack;
+
+		//! Count of the currently running profiles
+		uint32 depth;
+
+		//! Accumulates the results of each profile per frame, indexed by the zone
+		ProfileFrameList frame;
+
+		//! Zones called in the current frame
+		std::vector<ProfileZone> frameZones;
+
+		//! Keeps track of the statistics of each profile, indexed by the zone
+		ProfileHistoryList history;
+
+		//! Records written by the thread
+		std::vector<ProfileRecord> records;
+
+		//! Next record written by the thread
+		boost::atomic<uint32> head;
+
+		//! Next record read by the kernel thread
+		boost::atomic<uint32> tail;
+
+		//! Count of profiles begun but not ended by the thread, their ends are reserved in the buffer
+		uint32 pending;
+
+		//! Outermost profile of the thread
+		ProfileZone task;
+
+		//! Count of profiles dropped, because the buffer was full
+		boost::atomic<uint32> dropped;
+
+		//! Set when the thread has exited, so the profiles can be reused by another thread
+		boost::atomic<bool> exited;
+
+		//! Count of the captured profiles which are not ended yet
+		uint32 captureDepth;
+
+		ThreadProfile() : id(0), kernel(false), depth(0), head(0), tail(0), pending(0), task(NR_PROFILE_NO_ZONE), dropped(0), exited(false), captureDepth(0)
+		{
+			stack.resize(32);
+		}
+	};
+
+	//--------------------------------------------------------------------
+	// State of the spike detection. The records of the last frames are kept
+	// in a ring, the oldest frame is overwritten by the current one.
+	//--------------------------------------------------------------------
+	struct Profiler::SpikeDetector {
+
+		//! Records and the real interval of a kept frame
+		struct Frame {
+			ProfileRecordList records;
+			float32 interval;
+		};
+
+		//! Ring of the kept frames
+		std::vector<Frame> frames;
+
+		//! Next frame to overwrite and count of frames kept so far
+		uint32 next;
+		uint32 count;
+
+		//! Directory for the timelines
+		std::string directory;
+
+		//! Interval always regarded as spike and count of standard deviations
+		float32 threshold;
+		float32 deviations;
+
+		//! Count of frames to wait until the timeline of the detected spike is written
+		uint32 wait;
+
+		//! Interval and mean interval of the detected spike
+		float32 spikeInterval;
+		float32 spikeMean;
+
+		//! Time of the detected spike
+		uint64 spikeTime;
+
+		//! Count of the written timelines
+		uint32 written;
+
+		SpikeDetector() : next(0), count(0), threshold(0), deviations(0), wait(0), spikeInterval(0), spikeMean(0), spikeTime(0), written(0) {}
+	};
+
+	//--------------------------------------------------------------------
+	Profiler::Profiler(SharedPtr<TimeSource> timeSource) : mThreadProfile(threadExit)
 	{
 		mTimeSource = timeSource;
 		mTotalFrameTime = 0;
 		mEnabled = mNewEnableState = true; // the profiler starts out as enabled
 		mEnableStateChangePending = false;
 		mEngineProfileEnabled = false;
+		mCaptureState = CAPTURE_NONE;
+		mCaptureFrames = 0;
+		mCapturedFrames = 0;
+		mRecording = false;
+		mSampler = new SampleProfiler();
+
+		// the creating thread is the kernel thread
+		SharedPtr<ThreadProfile> tp(new ThreadProfile());
+		tp->kernel = true;
+		mThreads.push_back(tp);
+		mKernelThread = boost::this_thread::get_id();
 	}
 	
 	//--------------------------------------------------------------------
 	Profiler::~Profiler()
 	{
-		// clear all our lists
-		mProfiles.clear();
-		mProfileFrame.clear();
-		mProfileHistoryMap.clear();
-		mProfileHistory.clear();
+		delete mSampler;
+		mThreads.clear();
 	}	
-	
-	//--------------------------------------------------------------------
-	void Profiler::beginProfile(const std::string& profileName, bool isSystemProfile) {
-	
-		// if the profiler is enabled
-		if (!mEnabled || (isSystemProfile && !mEngineProfileEnabled))
-			return;
-	
-		// need a timer to profile!
-		NR_ASSERT (mTimeSource && "Time Source is not set!");
 
+	//--------------------------------------------------------------------
+	ProfileZone Profiler::registerZone(const std::string& name, bool isSystemProfile)
+	{
 		// empty string is reserved for the root
-		NR_ASSERT ((profileName != "") && ("Profile name can't be an empty string"));
-	
-		// make sure this profile isn't being used more than once
-		/*ProfileStack::iterator iter;
-		for (iter = mProfiles.begin(); iter != mProfiles.end(); iter++)
-			if ((*iter).name == profileName)	
+		NR_ASSERT ((name != "") && ("Profile name can't be an empty string"));
+
+		_ZoneRegistry& registry = _zoneRegistry();
+		boost::mutex::scoped_lock lock(registry.mutex);
+
+		std::map<std::string, ProfileZone>::const_iterator it = registry.zones.find(name);
+		if (it != registry.zones.end()) return it->second;
+
+		ProfileZone zone = (ProfileZone)registry.names.size();
+		registry.names.push_back(name);
+		registry.system.push_back(isSystemProfile);
+		registry.zones[name] = zone;
+
+		return zone;
+	}
+
+	//--------------------------------------------------------------------
+	std::string Profiler::getZoneName(ProfileZone zone)
+	{
+		_ZoneRegistry& registry = _zoneRegistry();
+		boost::mutex::scoped_lock lock(registry.mutex);
+
+		if (zone >= registry.names.size()) return std::string();
+		return registry.names[zone];
+	}
+
+	//--------------------------------------------------------------------
+	Profiler::ThreadProfile* Profiler::getThreadProfile()
+	{
+		// the kernel thread is checked first, the thread specific lookup is slower
+		if (boost::this_thread::get_id() == mKernelThread) return mThreads[0].get();
+
+		ThreadProfile* tp = mThreadProfile.get();
+		if (tp) return tp;
+
+		boost::mutex::scoped_lock lock(mThreadMutex);
+
+		// reuse the profiles of an exited thread, if all its records are merged
+		std::vector< SharedPtr<ThreadProfile> >::iterator it;
+		for (it = mThreads.begin(); it != mThreads.end(); it++){
+			ThreadProfile* t = it->get();
+			if (t->exited && t->head == t->tail && t->depth == 0){
+				tp = t;
+				tp->pending = 0;
+				tp->exited = false;
 				break;
-		*/
-				
-		//NR_ASSERT ((iter == mProfiles.end()) && ("This profile name is already being used"));
+			}
+		}
 
-		// profile instance
-		ProfileInstance p;
-	
-		// this is the root, it has no parent
-		if (mProfiles.empty()) {
-	
-			p.parent = "";
-	
-		// otherwise peek at the stack and use the top as the parent
-		} else {
-	
-			ProfileInstance parent = mProfiles.back();
-			p.parent = parent.name;
-	
+		if (tp == NULL){
+			SharedPtr<ThreadProfile> t(new ThreadProfile());
+			t->id = mThreads.size();
+			t->records.resize(NR_PROFILE_THREAD_RECORDS);
+			mThreads.push_back(t);
+			tp = t.get();
 		}
-		
-		// some iterator variables
-		ProfileFrameList::iterator fIter;
-		ProfileHistoryList::iterator hIter;
-	
-		// we check to see if this profile has been called in the frame before
-		for (fIter = mProfileFrame.begin(); fIter != mProfileFrame.end(); fIter++)
-			if ((*fIter).name == profileName)
-				break;
-		
-		// if it hasn't been called before, set its position in the stack
-		if (fIter == mProfileFrame.end()) {
+
+		mThreadProfile.reset(tp);
+		return tp;
+	}
+
+	//--------------------------------------------------------------------
+	Profiler::ProfileInstance& Profiler::pushZone(ThreadProfile& tp, ProfileZone zone)
+	{
+		// first call of the zone in this thread
+		if (zone >= tp.frame.size()){
 			ProfileFrame f;
-			f.name = profileName;
 			f.frameTime = 0;
 			f.frameTotalTime = 0;
 			f.calls = 0;
-			f.hierarchicalLvl = (uint32) mProfiles.size();
-			mProfileFrame.push_back(f);
+			f.hierarchicalLvl = 0;
+			f.used = false;
+			tp.frame.resize(zone + 1, f);
 		}
-	
-		// we check to see if this profile has been called in the app before
-		ProfileHistoryMap::iterator histMapIter;
-		histMapIter = mProfileHistoryMap.find(profileName);
-	
-		// if not we add a profile with just the name into the history
-		if (histMapIter == mProfileHistoryMap.end()) {
-			ProfileHistory h;
-			h.name = profileName;
-			h.numCallsThisFrame = 0;
-			h.totalTime = 0;
-			h.totalCalls = 0;
-			h.maxTime = 0;
-			h.minTime = 1;
-			h.hierarchicalLvl = p.hierarchicalLvl;
-			h.currentTime = 0;
-			h.realTotalTime = 0;
-			h.realTime = 0;
-			h.isSystemProfile = isSystemProfile;
-			
-			// we add this to the history
-			hIter = mProfileHistory.insert(mProfileHistory.end(), h);
-	
-			// for quick look-ups, we'll add it to the history map as well
-			mProfileHistoryMap.insert(std::pair< std::string, ProfileHistoryList::iterator>(profileName, hIter));
+
+		// remember the hierarchical level of the first call in this frame
+		ProfileFrame& f = tp.frame[zone];
+		if (!f.used){
+			f.used = true;
+			f.hierarchicalLvl = tp.depth;
+			tp.frameZones.push_back(zone);
 		}
-	
-		// add the stats to this profile and push it on the stack
-		// we do this at the very end of the function to get the most
-		// accurate timing results
-		p.name = profileName;
-		p.isSystemProfile = isSystemProfile;
-		p.currTime = mTimeSource->getTime();
+
+		if (tp.depth == tp.stack.size())
+			tp.stack.resize(tp.stack.size() * 2);
+
+		ProfileInstance& p = tp.stack[tp.depth++];
+		p.zone = zone;
 		p.accum = 0;
-		p.hierarchicalLvl = (uint32) mProfiles.size();
-		mProfiles.push_back(p);
+		return p;
 	}
-	
 
 	//--------------------------------------------------------------------
-	void Profiler::endProfile(const std::string& profileName, bool isSystemProfile) {
-	
+	bool Profiler::popZone(ThreadProfile& tp, ProfileZone zone, uint64 endTime, uint64& elapsed)
+	{
+		// profiles ended out of order are skipped
+		uint32 depth = tp.depth;
+		while (depth > 0 && tp.stack[depth - 1].zone != zone) depth--;
+		if (depth == 0) return false;
+		tp.depth = depth - 1;
+
+		// get the start of this profile
+		const ProfileInstance& bProfile = tp.stack[tp.depth];
+
+		// calculate the elapsed time of this profile
+		elapsed = endTime - bProfile.currTime;
+
+		// add this profile's time to the parent's accumulator if it isn't the root
+		if (tp.depth > 0)
+			tp.stack[tp.depth - 1].accum += elapsed;
+
+		// we subtract the time the children profiles took from this profile
+		ProfileFrame& f = tp.frame[bProfile.zone];
+		f.frameTime += elapsed - bProfile.accum;
+		f.frameTotalTime += elapsed;
+		f.calls++;
+
+		return tp.depth == 0;
+	}
+
+	//--------------------------------------------------------------------
+	bool Profiler::beginZone(ProfileZone zone, bool isSystemProfile)
+	{
 		// if the profiler is enabled
 		if (!mEnabled || (isSystemProfile && !mEngineProfileEnabled))
-			return;
-		
-		// need a timer to profile!
-		NR_ASSERT (mTimeSource && "Timer not set!");
-	
+			return false;
+
+		ThreadProfile* tp = getThreadProfile();
+
+		// push the profile on the stack. we take the time at the very end
+		// of the function to get the most accurate timing results
+		if (tp->kernel){
+			ProfileInstance& p = pushZone(*tp, zone);
+			p.currTime = getMonotonicTime();
+			if (mRecording) captureRecord(*tp, zone, p.currTime, true);
+			return true;
+		}
+
+		// other threads write a record. the ends of all running profiles
+		// must fit into the buffer, otherwise the profile is dropped
+		uint32 head = tp->head.load(boost::memory_order_relaxed);
+		uint32 used = head - tp->tail.load(boost::memory_order_acquire);
+		if (used + tp->pending + 2 > NR_PROFILE_THREAD_RECORDS){
+			tp->dropped.fetch_add(1, boost::memory_order_relaxed);
+			return false;
+		}
+
+		if (tp->pending == 0) tp->task = zone;
+		tp->pending++;
+
+		ProfileRecord& r = tp->records[head & (NR_PROFILE_THREAD_RECORDS - 1)];
+		r.zone = zone;
+		r.task = tp->task;
+		r.thread = (uint16)tp->id;
+		r.begin = true;
+		r.time = getMonotonicTime();
+		tp->head.store(head + 1, boost::memory_order_release);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::endZone(ProfileZone zone)
+	{
 		// get the end time of this profile
 		// we do this as close the beginning of this function as possible
 		// to get more accurate timing results
-		float64 endTime = mTimeSource->getTime();
-	
-		// empty string is reserved for designating an empty parent
-		NR_ASSERT ((profileName != "") && ("Profile name can't be an empty string"));
-		
-		// stack shouldnt be empty
-		NR_ASSERT (!mProfiles.empty() && ("You have to begin any profile before stop it"));
-	
-		// get the start of this profile
-		ProfileInstance bProfile;
-		bProfile = mProfiles.back();
-		mProfiles.pop_back();
-	
-		// calculate the elapsed time of this profile
-		float64 timeElapsed = endTime - bProfile.currTime;
-	
-		// update parent's accumalator if it isn't the root
-		if (bProfile.parent != "") {
-			// find the parent
-			ProfileStack::iterator iter;
-			for(iter = mProfiles.begin(); iter != mProfiles.end(); iter++)	
-				if ((*iter).name == bProfile.parent)
-					break;
-	
-			// the parent should be found 
-			NR_ASSERT(iter != mProfiles.end());
-	
-			// add this profile's time to the parent's accumulator
-			(*iter).accum += timeElapsed;	
+		uint64 endTime = getMonotonicTime();
+
+		ThreadProfile* tp = getThreadProfile();
+
+		// other threads write a record, the place for it is reserved
+		if (!tp->kernel){
+			if (tp->pending == 0) return;
+			tp->pending--;
+
+			uint32 head = tp->head.load(boost::memory_order_relaxed);
+			ProfileRecord& r = tp->records[head & (NR_PROFILE_THREAD_RECORDS - 1)];
+			r.zone = zone;
+			r.task = tp->task;
+			r.thread = (uint16)tp->id;
+			r.begin = false;
+			r.time = endTime;
+			tp->head.store(head + 1, boost::memory_order_release);
+			return;
 		}
-	
-		// we find the profile in this frame
-		ProfileFrameList::iterator iter;
-		for (iter = mProfileFrame.begin(); iter != mProfileFrame.end(); iter++)
-			if ((*iter).name == bProfile.name)
-				break;
-	
-		// we subtract the time the children profiles took from this profile
-		(*iter).frameTime += timeElapsed - bProfile.accum;
-		(*iter).frameTotalTime += timeElapsed;
-		(*iter).calls++;
-	
+
+		// stack shouldnt be empty
+		NR_ASSERT (tp->depth > 0 && ("You have to begin any profile before stop it"));
+		NR_ASSERT (tp->stack[tp->depth - 1].zone == zone && ("Profiles have to be ended in reverse order"));
+
+		if (mRecording) captureRecord(*tp, zone, endTime, false);
+
 		// the stack is empty and all the profiles have been completed
 		// we have reached the end of the frame so process the frame statistics
-		if (mProfiles.empty()) {
-	
+		uint64 timeElapsed = 0;
+		if (popZone(*tp, zone, endTime, timeElapsed)) {
+
 			// we know that the time elapsed of the main loop is the total time the frame took
-			mTotalFrameTime = timeElapsed;
-	
+			mTotalFrameTime = (float64)timeElapsed * 1e-9;
+
 			// we got all the information we need, so process the profiles
 			// for this frame
-			processFrameStats();
-	
-			// clear the frame stats for next frame
-			mProfileFrame.clear();
-		
+			processFrameStats(*tp);
+			mergeThreads();
+
+			// the recording starts and ends at the frame boundary
+			if (mRecording || mCaptureState != CAPTURE_NONE || mSpikes) recordFrame();
+
 			// if the profiler received a request to be enabled or disabled
 			// we reached the end of the frame so we can safely do this
 			if (mEnableStateChangePending) {
 				changeEnableState();
 			}
-	
+
+		}
+
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::mergeThreads()
+	{
+		boost::mutex::scoped_lock lock(mThreadMutex);
+
+		std::vector< SharedPtr<ThreadProfile> >::iterator it;
+		for (it = mThreads.begin(); it != mThreads.end(); it++){
+			ThreadProfile& tp = **it;
+			if (tp.kernel) continue;
+
+			// replay the records on the stack of the thread
+			uint32 tail = tp.tail.load(boost::memory_order_relaxed);
+			uint32 head = tp.head.load(boost::memory_order_acquire);
+			for (; tail != head; tail++){
+				const ProfileRecord& r = tp.records[tail & (NR_PROFILE_THREAD_RECORDS - 1)];
+				if (r.begin){
+					pushZone(tp, r.zone).currTime = r.time;
+				}else{
+					uint64 elapsed = 0;
+					popZone(tp, r.zone, r.time, elapsed);
+				}
+
+				// ends of profiles begun before the recording are not recorded
+				if (mRecording && (r.begin || tp.captureDepth > 0)){
+					tp.captureDepth += r.begin ? 1 : -1;
+					mFrameRecords.push_back(r);
+				}
+			}
+			tp.tail.store(tail, boost::memory_order_release);
+
+			// the profiles of the thread are measured relative to the kernel frame
+			processFrameStats(tp);
 		}
-	
 	}
 	
 	//--------------------------------------------------------------------
-	void Profiler::processFrameStats() {
+	Result Profiler::startCapture(const std::string& fileName, uint32 frames)
+	{
+		if (frames == 0) return BAD_PARAMETERS;
+		if (mCaptureState != CAPTURE_NONE) return PROFILE_CAPTURE_RUNNING;
+
+		NR_Log(Log::LOG_ENGINE, "Profiler: Capture %d frames into %s", frames, fileName.c_str());
+
+		// the capture starts with the next frame
+		mCaptureFile = fileName;
+		mCaptureFrames = frames;
+		mCaptureState = CAPTURE_PENDING;
+
+		return OK;
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::stopCapture()
+	{
+		if (mCaptureState == CAPTURE_PENDING)
+			mCaptureState = CAPTURE_NONE;
+		else if (mCaptureState == CAPTURE_RUNNING)
+			mCaptureFrames = mCapturedFrames + 1;
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::captureRecord(ThreadProfile& tp, ProfileZone zone, uint64 time, bool begin)
+	{
+		ProfileRecord r;
+		r.time = time;
+		r.zone = zone;
+		r.task = tp.stack[0].zone;
+		r.thread = (uint16)tp.id;
+		r.begin = begin;
+		mFrameRecords.push_back(r);
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::recordFrame()
+	{
+		// pass the frame to the capture
+		if (mCaptureState == CAPTURE_PENDING){
+			mCapture.clear();
+			mCapturedFrames = 0;
+			mCaptureState = CAPTURE_RUNNING;
+		}else if (mCaptureState == CAPTURE_RUNNING && mRecording){
+			mCapture.insert(mCapture.end(), mFrameRecords.begin(), mFrameRecords.end());
+
+			if (++mCapturedFrames >= mCaptureFrames){
+				NR_Log(Log::LOG_ENGINE, "Profiler: Write %d captured frames into %s", mCapturedFrames, mCaptureFile.c_str());
+				writeTrace(mCaptureFile, mCapture);
+
+				ProfileRecordList().swap(mCapture);
+				mCaptureState = CAPTURE_NONE;
+			}
+		}
+
+		// and to the spike detection
+		if (mSpikes && mRecording) detectSpike();
+		mFrameRecords.clear();
+
+		// the records of the threads are counted anew, if the recording starts
+		bool recording = mCaptureState == CAPTURE_RUNNING || mSpikes;
+		if (recording && !mRecording){
+			boost::mutex::scoped_lock lock(mThreadMutex);
+
+			std::vector< SharedPtr<ThreadProfile> >::iterator it;
+			for (it = mThreads.begin(); it != mThreads.end(); it++)
+				(*it)->captureDepth = 0;
+		}
+		mRecording = recording;
+	}
+
+	//--------------------------------------------------------------------
+	Result Profiler::enableSpikeDetection(const std::string& directory, uint32 frames, float32 threshold, float32 deviations)
+	{
+		if (frames < 2 || (threshold <= 0.0f && deviations <= 0.0f)) return BAD_PARAMETERS;
+
+		NR_Log(Log::LOG_ENGINE, "Profiler: Detect frame spikes above %f sec or %f deviations, write %d frames into %s", threshold, deviations, frames, directory.c_str());
+
+		// the frames are recorded from the next frame on
+		SharedPtr<SpikeDetector> spikes(new SpikeDetector());
+		spikes->frames.resize(frames);
+		spikes->directory = directory;
+		spikes->threshold = threshold;
+		spikes->deviations = deviations;
+		if (mSpikes) spikes->written = mSpikes->written;
+		mSpikes = spikes;
+
+		return OK;
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::disableSpikeDetection()
+	{
+		mSpikes.reset();
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::detectSpike()
+	{
+		SpikeDetector& sd = *mSpikes;
+		uint32 size = sd.frames.size();
+		float32 interval = Engine::sClock()->getRealFrameInterval();
+
+		// mean and standard deviation of the kept frames
+		float64 mean = 0, variance = 0;
+		for (uint32 i = 0; i < sd.count; i++) mean += sd.frames[i].interval;
+		if (sd.count) mean /= (float64)sd.count;
+		for (uint32 i = 0; i < sd.count; i++){
+			float64 d = sd.frames[i].interval - mean;
+			variance += d * d;
+		}
+		if (sd.count) variance /= (float64)sd.count;
+
+		// the deviations are used as soon as the ring is full. a very steady frame
+		// rate would report each small variation, so the deviation is at least 5%
+		float64 deviation = sqrt(variance);
+		if (deviation < mean * 0.05) deviation = mean * 0.05;
+
+		bool spike = (sd.threshold > 0.0f && interval > sd.threshold)
+				|| (sd.deviations > 0.0f && sd.count == size && interval > mean + sd.deviations * deviation);
+
+		// the interval of the clock was measured since its update in the previous frame
+		const ProfileRecordList& previous = sd.frames[(sd.next + size - 1) % size].records;
+		uint64 intervalStart = (sd.count && previous.size()) ? previous.front().time : 0;
+
+		// keep the frame, the records of the oldest frame are reused
+		SpikeDetector::Frame& frame = sd.frames[sd.next];
+		frame.records.swap(mFrameRecords);
+		frame.interval = interval;
+		sd.next = (sd.next + 1) % size;
+		if (sd.count < size) sd.count++;
+
+		// wait for the frames after the spike, further spikes are written with it
+		if (sd.wait == 0 && spike){
+			sd.wait = size / 2 + 1;
+			sd.spikeInterval = interval;
+			sd.spikeMean = (float32)mean;
+			sd.spikeTime = intervalStart ? intervalStart : (frame.records.size() ? frame.records.front().time : getMonotonicTime());
+		}
+		if (sd.wait == 0 || --sd.wait > 0) return;
+
+		// collect the kept frames starting with the oldest one
+		ProfileRecordList records;
+		for (uint32 i = 0; i < sd.count; i++){
+			const ProfileRecordList& r = sd.frames[(sd.next + size - sd.count + i) % size].records;
+			records.insert(records.end(), r.begin(), r.end());
+		}
+
+		char name[32];
+		sprintf(name, "spike%04d.json", sd.written++);
+		std::string fileName = sd.directory + "/" + name;
+
+		char marker[64];
+		sprintf(marker, "Spike %.3f ms", sd.spikeInterval * 1000.0f);
+
+		NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "Profiler: Frame spike of %.3f ms (mean %.3f ms), write %d frames into %s",
+			sd.spikeInterval * 1000.0f, sd.spikeMean * 1000.0f, sd.count, fileName.c_str());
+		writeTrace(fileName, records, marker, sd.spikeTime);
+	}
+
+	//--------------------------------------------------------------------
+	// Quote a string for JSON
+	//--------------------------------------------------------------------
+	static std::string _jsonString(const std::string& str)
+	{
+		std::string res = "\"";
+		for (std::string::const_iterator it = str.begin(); it != str.end(); it++){
+			if (*it == '"' || *it == '\\'){
+				res += '\\';
+				res += *it;
+			}else if ((unsigned char)*it < 0x20){
+				char hex[8];
+				sprintf(hex, "\\u%04x", (unsigned char)*it);
+				res += hex;
+			}else{
+				res += *it;
+			}
+		}
+		return res + "\"";
+	}
+
+	//--------------------------------------------------------------------
+	Result Profiler::writeTrace(const std::string& fileName, const ProfileRecordList& records, const std::string& marker, uint64 markerTime)
+	{
+		std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+		if (!file.is_open()){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "Profiler: Can not write the capture into %s", fileName.c_str());
+			return FILE_ERROR;
+		}
+
+		// names of the zones, quoted once
+		std::vector<std::string> names;
+		std::vector<bool> system;
+		{
+			_ZoneRegistry& registry = _zoneRegistry();
+			boost::mutex::scoped_lock lock(registry.mutex);
+			for (uint32 i = 0; i < registry.names.size(); i++)
+				names.push_back(_jsonString(registry.names[i]));
+			system = registry.system;
+		}
+
+		// times are written in microseconds since the first record
+		uint64 start = records.size() ? records[0].time : 0;
+		ProfileRecordList::const_iterator it;
+		for (it = records.begin(); it != records.end(); it++)
+			if (it->time < start) start = it->time;
+
+		file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+		// name the threads by the task they run
+		{
+			boost::mutex::scoped_lock lock(mThreadMutex);
+
+			std::vector< SharedPtr<ThreadProfile> >::const_iterator tit;
+			for (tit = mThreads.begin(); tit != mThreads.end(); tit++){
+				const ThreadProfile& tp = **tit;
+
+				std::string name = "Kernel";
+				if (!tp.kernel){
+					name = "Thread " + boost::lexical_cast<std::string>(tp.id);
+					if (tp.task != NR_PROFILE_NO_ZONE) name += " (" + getZoneName(tp.task) + ")";
+				}
+
+				if (tit != mThreads.begin()) file << ",";
+				file << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tp.id
+					<< ",\"args\":{\"name\":" << _jsonString(name) << "}}";
+			}
+		}
+
+		char line[128];
+		for (it = records.begin(); it != records.end(); it++){
+			const ProfileRecord& r = *it;
+			if (r.zone >= names.size()) continue;
+
+			sprintf(line, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", r.begin ? 'B' : 'E', (float64)(r.time - start) * 1e-3, r.thread);
+			file << ",\n{\"name\":" << names[r.zone] << ",\"cat\":\"" << (system[r.zone] ? "engine" : "app") << line;
+		}
+
+		// the marker is shown over all threads
+		if (marker.length()){
+			sprintf(line, ",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}", (float64)(markerTime - start) * 1e-3);
+			file << ",\n{\"name\":" << _jsonString(marker) << line;
+		}
+
+		file << "\n]}\n";
+
+		return OK;
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::beginProfile(const std::string& profileName, bool isSystemProfile) {
 	
 		// if the profiler is enabled
-		if (!mEnabled)
+		if (!mEnabled || (isSystemProfile && !mEngineProfileEnabled))
 			return;
 
-		ProfileFrameList::iterator frameIter;
-		ProfileHistoryList::iterator historyIter;
-	
-		// we set the number of times each profile was called per frame to 0
-		// because not all profiles are called every frame
-		for (historyIter = mProfileHistory.begin(); historyIter != mProfileHistory.end(); historyIter++)
-			(*historyIter).numCallsThisFrame = 0;
-	
-		// iterate through each of the profiles processed during this frame
-		for (frameIter = mProfileFrame.begin(); frameIter != mProfileFrame.end(); frameIter++) {
-	
-			std::string s = (*frameIter).name;
+		beginZone(registerZone(profileName, isSystemProfile), isSystemProfile);
+	}
 	
-			// use our map to find the appropriate profile in the history
-			historyIter = (*mProfileHistoryMap.find(s)).second;
+
+	//--------------------------------------------------------------------
+	void Profiler::endProfile(const std::string& profileName, bool isSystemProfile) {
 	
-			// extract the frame stats
-			float64 frameTime = (*frameIter).frameTime;
-			uint32 calls = (*frameIter).calls;
-			uint32 lvl = (*frameIter).hierarchicalLvl;
+		// if the profiler is enabled
+		if (!mEnabled || (isSystemProfile && !mEngineProfileEnabled))
+			return;
+
+		endZone(registerZone(profileName, isSystemProfile));
+	}
 	
-			// calculate what percentage of frame time this profile took
-			float32 framePercentage = static_cast<float32>(frameTime) / static_cast<float32>(mTotalFrameTime);
+	//--------------------------------------------------------------------
+	void Profiler::processFrameStats(ThreadProfile& tp) {
 	
-			// update the profile stats
-			(*historyIter).currentTime = framePercentage;
-			(*historyIter).totalTime += framePercentage;
-			(*historyIter).totalCalls++;
-			(*historyIter).numCallsThisFrame = calls;
-			(*historyIter).hierarchicalLvl = lvl;
-			(*historyIter).realTime += frameTime;
-			(*historyIter).realTotalTime += (*frameIter).frameTotalTime;
-			
-			// if we find a new minimum for this profile, update it
-			if ((framePercentage) < ((*historyIter).minTime)) {	
-				(*historyIter).minTime = framePercentage;
+		// if the profiler is enabled
+		if (mEnabled){
+
+			// we set the number of times each profile was called per frame to 0
+			// because not all profiles are called every frame
+			ProfileHistoryList::iterator historyIter;
+			for (historyIter = tp.history.begin(); historyIter != tp.history.end(); historyIter++)
+				(*historyIter).numCallsThisFrame = 0;
+
+			// iterate through each of the profiles processed during this frame
+			std::vector<ProfileZone>::const_iterator it;
+			for (it = tp.frameZones.begin(); it != tp.frameZones.end(); it++) {
+
+				// only completed calls are counted
+				const ProfileFrame& frame = tp.frame[*it];
+				if (frame.calls == 0) continue;
+
+				// the history of the zone is created on its first frame
+				if (*it >= tp.history.size()){
+					ProfileHistory h;
+					h.isSystemProfile = false;
+					h.numCallsThisFrame = 0;
+					h.totalTime = 0;
+					h.totalCalls = 0;
+					h.maxTime = 0;
+					h.minTime = 1;
+					h.hierarchicalLvl = 0;
+					h.currentTime = 0;
+					h.realTotalTime = 0;
+					h.realTime = 0;
+					tp.history.resize(*it + 1, h);
+				}
+
+				ProfileHistory& history = tp.history[*it];
+				if (history.name.length() == 0){
+					_ZoneRegistry& registry = _zoneRegistry();
+					boost::mutex::scoped_lock lock(registry.mutex);
+					history.name = registry.names[*it];
+					history.isSystemProfile = registry.system[*it];
+				}
+
+				// extract the frame stats
+				float64 frameTime = (float64)frame.frameTime * 1e-9;
+
+				// calculate what percentage of frame time this profile took
+				float32 framePercentage = static_cast<float32>(frameTime) / static_cast<float32>(mTotalFrameTime);
+
+				// update the profile stats
+				history.currentTime = framePercentage;
+				history.totalTime += framePercentage;
+				history.totalCalls++;
+				history.numCallsThisFrame = frame.calls;
+				history.hierarchicalLvl = frame.hierarchicalLvl;
+				history.realTime += frameTime;
+				history.realTotalTime += (float64)frame.frameTotalTime * 1e-9;
+
+				// if we find a new minimum for this profile, update it
+				if (framePercentage < history.minTime) {
+					history.minTime = framePercentage;
+				}
+
+				// if we find a new maximum for this profile, update it
+				if (framePercentage > history.maxTime) {
+					history.maxTime = framePercentage;
+				}
+
 			}
-	
-			// if we find a new maximum for this profile, update it
-			if ((framePercentage) > ((*historyIter).maxTime)) {	
-				(*historyIter).maxTime = framePercentage;
+		}
+
+		// clear the frame stats for next frame, profiles still running
+		// in another thread stay in the frame
+		std::vector<ProfileZone>::const_iterator it;
+		for (it = tp.frameZones.begin(); it != tp.frameZones.end(); it++){
+			ProfileFrame& f = tp.frame[*it];
+			f.frameTime = 0;
+			f.frameTotalTime = 0;
+			f.calls = 0;
+			f.used = false;
+		}
+		tp.frameZones.clear();
+		for (uint32 i = 0; i < tp.depth; i++){
+			ProfileFrame& f = tp.frame[tp.stack[i].zone];
+			if (!f.used){
+				f.used = true;
+				f.hierarchicalLvl = i;
+				tp.frameZones.push_back(tp.stack[i].zone);
 			}
-	
 		}
-	
 	}
 
 	//-----------------------------------------------------------------------
@@ -299,34 +835,37 @@ namespace nrEngine{
 	//-----------------------------------------------------------------------
 	void Profiler::reset() {
 	
-		ProfileHistoryList::iterator iter;
-		for (iter = mProfileHistory.begin(); iter != mProfileHistory.end(); iter++) {
-			(*iter).currentTime = (*iter).maxTime = (*iter).totalTime = 0;
-			(*iter).numCallsThisFrame = (*iter).totalCalls = 0;
-			(*iter).minTime = 1;	
+		boost::mutex::scoped_lock lock(mThreadMutex);
+
+		std::vector< SharedPtr<ThreadProfile> >::iterator it;
+		for (it = mThreads.begin(); it != mThreads.end(); it++){
+			ProfileHistoryList::iterator iter;
+			for (iter = (*it)->history.begin(); iter != (*it)->history.end(); iter++) {
+				(*iter).currentTime = (*iter).maxTime = (*iter).totalTime = 0;
+				(*iter).numCallsThisFrame = (*iter).totalCalls = 0;
+				(*iter).minTime = 1;	
+			}
+			(*it)->dropped = 0;
 		}
 	
 	}
 
 	//--------------------------------------------------------------------
-	void Profiler::logResults(Log::LogTarget lt){
-
-		// if the profiler is enabled
-		if (!mEnabled)
-			return;
-		
-		// sort the history so we get profiles that need more time on the top
-		mProfileHistory.sort();
+	void Profiler::logHistory(const ProfileHistoryList& list, Log::LogTarget lt)
+	{
+		// sort the history so we get profiles that need more time on the top,
+		// the history itself stays indexed by the zones
+		std::vector<ProfileHistory> history;
+		ProfileHistoryList::const_iterator hIter;
+		for (hIter = list.begin(); hIter != list.end(); hIter++)
+			if (hIter->totalCalls > 0) history.push_back(*hIter);
+		std::sort(history.begin(), history.end());
 				
-		ProfileHistoryList::iterator iter;
-	
-		NR_Log(lt,  "--------------------------------------Profiler Results------------------------------");
-		NR_Log(lt,  "| Name                        | Avg(\%) | Max(\%) | Min(\%) | Time sec     |  Calls   |");
-		NR_Log(lt,  "------------------------------------------------------------------------------------");
+		std::vector<ProfileHistory>::iterator iter;
 
 		// log system results
 		NR_Log(lt,  "| System Profiles                                                                  |");
-		for (iter = mProfileHistory.begin(); iter != mProfileHistory.end(); iter++)
+		for (iter = history.begin(); iter != history.end(); iter++)
 		{
 			// only for system profiles
 			if (iter->isSystemProfile){
@@ -344,7 +883,7 @@ namespace nrEngine{
 		// log application results
 		NR_Log(lt,  "|----------------------------------------------------------------------------------|");
 		NR_Log(lt,  "| Application Profiles                                                             |");
-		for (iter = mProfileHistory.begin(); iter != mProfileHistory.end(); iter++)
+		for (iter = history.begin(); iter != history.end(); iter++)
 		{
 			// only for application profiles
 			if (!iter->isSystemProfile){
@@ -358,6 +897,41 @@ namespace nrEngine{
 				logLine(indent.c_str(), iter->minTime, iter->maxTime, iter->realTime, iter->totalTime, iter->totalCalls);
 			}
 		}
+	}
+
+	//--------------------------------------------------------------------
+	void Profiler::logResults(Log::LogTarget lt){
+
+		// if the profiler is enabled
+		if (!mEnabled)
+			return;
+		
+		boost::mutex::scoped_lock lock(mThreadMutex);
+
+		NR_Log(lt,  "--------------------------------------Profiler Results------------------------------");
+		NR_Log(lt,  "| Name                        | Avg(\%) | Max(\%) | Min(\%) | Time sec     |  Calls   |");
+		NR_Log(lt,  "------------------------------------------------------------------------------------");
+
+		std::vector< SharedPtr<ThreadProfile> >::const_iterator it;
+		for (it = mThreads.begin(); it != mThreads.end(); it++){
+			const ThreadProfile& tp = **it;
+
+			// other threads are logged with the task they run
+			if (!tp.kernel){
+				if (tp.history.size() == 0) continue;
+
+				std::string title = "Thread " + boost::lexical_cast<std::string>(tp.id);
+				if (tp.task < tp.history.size()) title += " (" + tp.history[tp.task].name + ")";
+				if (tp.dropped) title += ", " + boost::lexical_cast<std::string>((uint32)tp.dropped) + " profiles dropped";
+				title.resize(80, ' ');
+
+				NR_Log(lt,  "|==================================================================================|");
+				NR_Log(lt,  "| %s |", title.c_str());
+				NR_Log(lt,  "|----------------------------------------------------------------------------------|");
+			}
+
+			logHistory(tp.history, lt);
+		}
 	
 		NR_Log(lt,  "|                                                                                  |");
 		NR_Log(lt,  "------------------------------------------------------------------------------------");
@@ -398,12 +972,18 @@ namespace nrEngine{
 
 	
 	//-----------------------------------------------------------------------
-	bool Profiler::ProfileHistory::operator <(const Profiler::ProfileHistory& p)
+	bool Profiler::ProfileHistory::operator <(const Profiler::ProfileHistory& p) const
 	{
 		float my_avg = totalTime / totalCalls;
 		float it_avg = p.totalTime / p.totalCalls;
 		return (it_avg < my_avg);
 	}
 
+	//-----------------------------------------------------------------------
+	void Profiler::threadExit(ThreadProfile* tp)
+	{
+		tp->exited = true;
+	}
+
 }; // end namespace
 
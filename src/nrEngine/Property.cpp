@@ -107,7 +107,7 @@ namespace nrEngine {
 		push_back(p);
 
 		// some debug info
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Property: Initialize new property '%s'", name.c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "Property: Initialize new property '%s'", name.c_str());
 
 		return back();
 	}
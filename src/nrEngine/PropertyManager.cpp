@@ -60,7 +60,7 @@ namespace nrEngine {
         p.mFullname = group + std::string(".") + name;
 
         // some debug info
-        NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "Property: Initialize new property '%s.%s'", group.c_str(), name.c_str());
+        NR_LogDebug(Log::LOG_ENGINE, "Property: Initialize new property '%s.%s'", group.c_str(), name.c_str());
 
         // add property into the list and return the reference
         list.push_back(p);
@@ -17,6 +17,7 @@
 #include <nrEngine/Resource.h>
 #include <nrEngine/Exception.h>
 #include <nrEngine/Log.h>
+#include <nrEngine/GetTime.h>
 
 namespace nrEngine {
 
@@ -29,6 +30,8 @@ namespace nrEngine {
 		mResIsEmpty = false;
 		mResDataSize = sizeof(*this);
 		mResIsDirty = false;
+		mResGeneration = 0;
+		mResArena = NULL;
 		setResourceType(resType);
 	}
 
@@ -59,25 +62,33 @@ namespace nrEngine {
 	//----------------------------------------------------------------------------------
 	Result IResource::reload(PropertyList* params)
 	{
-		// if resource is loaded, then unload it first
+		// if resource is loaded, then unload it first. The manager is not notified,
+		// so the resources we depend on stay loaded while we are reloading
 		if (isResourceLoaded())
 		{
-			Result ret = unload();
+			Result ret = unloadResource();
 			if (ret != OK) return ret;
 		}
 			
 		// check if resource is loaded
 		if (!isResourceLoaded())
 		{
+			// resources we depend on must be loaded before
+			Engine::sResourceManager()->acquireDependencies(this);
+
 			// unload resource
+			uint64 start = getMonotonicTime();
 			Result ret = reloadResource(params);
+			Engine::sResourceManager()->getStatistics().recordReload(this, (getMonotonicTime() - start) * 0.000000001, ret == OK);
 
 			// if ok, then inform resource manager, that we are reloaded now
 			if (ret == OK){
 				Engine::sResourceManager()->notifyLoaded(this);
-				mResIsDirty = false;
-			}else
+				setResourceDirty(false);
+			}else{
+				Engine::sResourceManager()->releaseDependencies(this);
 				return ret;
+			}
 		}
 		return OK;
 	}
@@ -92,6 +103,30 @@ namespace nrEngine {
 		return mResLoader->remove(getSharedPtrFromThis());
 	}
 
+	//----------------------------------------------------------------------------------
+	void* IResource::allocateResourceData(std::size_t size)
+	{
+		// the arena is remembered, the group could change while the data is used
+		ResourceArena* arena = Engine::sResourceManager()->getGroupArena(mResGroup);
+		if (arena){
+			mResArena = arena;
+			return arena->allocate(size);
+		}
+
+		return malloc(size);
+	}
+
+	//----------------------------------------------------------------------------------
+	void IResource::freeResourceData(void* data)
+	{
+		if (data == NULL) return;
+
+		// memory of the arena is released with the whole group
+		if (mResArena && mResArena->contains(data)) return;
+
+		free(data);
+	}
+
 	//----------------------------------------------------------------------------------
 	void IResource::addResourceFilename(const std::string& filename)
 	{
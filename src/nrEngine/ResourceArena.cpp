@@ -0,0 +1,112 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/ResourceArena.h>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	ResourceArena::ResourceArena(std::size_t chunkSize) : mChunkSize(chunkSize), mUsed(0), mReserved(0)
+	{
+		if (mChunkSize == 0) mChunkSize = NR_RESOURCE_ARENA_CHUNK_SIZE;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceArena::~ResourceArena()
+	{
+		release();
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceArena::Chunk* ResourceArena::reserve(std::size_t size, bool dedicated)
+	{
+		Chunk chunk;
+		chunk.data = (byte*)malloc(size);
+		chunk.size = size;
+		chunk.used = 0;
+		if (chunk.data == NULL) return NULL;
+
+		mReserved += size;
+
+		// the last chunk has to stay the one for the small allocations
+		if (dedicated && mChunks.size()){
+			mChunks.insert(mChunks.end() - 1, chunk);
+			return &mChunks[mChunks.size() - 2];
+		}
+
+		mChunks.push_back(chunk);
+		return &mChunks.back();
+	}
+
+	//----------------------------------------------------------------------------------
+	void* ResourceArena::allocate(std::size_t size, std::size_t alignment)
+	{
+		if (alignment == 0) alignment = 1;
+
+		boost::mutex::scoped_lock lock(mMutex);
+
+		// try the current chunk first
+		if (mChunks.size()){
+			Chunk& c = mChunks.back();
+			std::size_t addr = ((std::size_t)(c.data + c.used) + alignment - 1) & ~(alignment - 1);
+			std::size_t offset = addr - (std::size_t)c.data;
+			if (offset + size <= c.size){
+				mUsed += offset + size - c.used;
+				c.used = offset + size;
+				return c.data + offset;
+			}
+		}
+
+		// big allocations do not waste the rest of the current chunk
+		bool dedicated = size > mChunkSize / 2;
+		Chunk* c = reserve(dedicated ? size + alignment : mChunkSize, dedicated);
+		if (c == NULL) return NULL;
+
+		std::size_t addr = ((std::size_t)c->data + alignment - 1) & ~(alignment - 1);
+		std::size_t offset = addr - (std::size_t)c->data;
+		c->used = offset + size;
+		mUsed += c->used;
+
+		return c->data + offset;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceArena::contains(const void* ptr)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+
+		const byte* p = (const byte*)ptr;
+		for (std::vector<Chunk>::const_iterator it = mChunks.begin(); it != mChunks.end(); it++)
+			if (p >= it->data && p < it->data + it->size) return true;
+
+		return false;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceArena::release()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+
+		for (std::vector<Chunk>::iterator it = mChunks.begin(); it != mChunks.end(); it++)
+			free(it->data);
+
+		mChunks.clear();
+		mUsed = 0;
+		mReserved = 0;
+	}
+
+};
+
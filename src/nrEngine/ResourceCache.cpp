@@ -0,0 +1,188 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/ResourceCache.h>
+#include <nrEngine/MappedFileStream.h>
+#include <nrEngine/LocalFileSystem.h>
+#include <nrEngine/StdHelpers.h>
+#include <nrEngine/Log.h>
+#include <sys/stat.h>
+#include <boost/thread/thread.hpp>
+
+#if NR_PLATFORM != NR_PLATFORM_WIN32
+#	include <unistd.h>
+#	define nrGetProcessId ::getpid
+#else
+#	include <direct.h>
+#	include <process.h>
+#	define nrGetProcessId ::_getpid
+#endif
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	// Alignment of the cached data inside the file
+	//----------------------------------------------------------------------------------
+	static const uint64 NR_RESOURCE_CACHE_ALIGNMENT = 16;
+
+	//----------------------------------------------------------------------------------
+	// Modification time of a file in the best available resolution
+	//----------------------------------------------------------------------------------
+	static uint64 _modificationTime(const struct stat& st)
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		return (uint64)st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+	#else
+		return (uint64)st.st_mtime;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCache::ResourceCache(const std::string& directory) : mDirectory(directory)
+	{
+		// use always slash at the end of the directory
+		if (mDirectory.length() == 0) mDirectory = "./";
+		if (mDirectory[mDirectory.length() - 1] != '/') mDirectory += "/";
+
+		// create the directory, if it does not exists
+		struct stat st;
+		if (stat(mDirectory.c_str(), &st) != 0){
+		#if NR_PLATFORM != NR_PLATFORM_WIN32
+			mkdir(mDirectory.c_str(), 0755);
+		#else
+			_mkdir(mDirectory.c_str());
+		#endif
+		}
+
+		NR_Log(Log::LOG_ENGINE, "ResourceCache: Store decoded resources in %s", mDirectory.c_str());
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCache::~ResourceCache()
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string ResourceCache::getEntryName(const std::string& loader, const std::string& fileName) const
+	{
+		std::string key = loader + ":" + fileName;
+		uint64 hash = hashData(key.c_str(), key.length());
+
+		char name[32];
+		sprintf(name, "%08x%08x.nrc", (uint32)(hash >> 32), (uint32)hash);
+		return mDirectory + name;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceCache::lookup(const std::string& loader, uint32 loaderVersion, const std::string& fileName,
+			SharedPtr<byte>& data, size_t& size)
+	{
+		// only files on the disk are cached
+		struct stat st;
+		if (stat(fileName.c_str(), &st) != 0) return false;
+
+		size_t fileSize = 0;
+		SharedPtr<byte> file = MappedFileStream::map(getEntryName(loader, fileName), fileSize);
+		if (!file || fileSize < sizeof(ResourceCacheHeader)) return false;
+
+		// check if the entry is still valid
+		const ResourceCacheHeader* header = (const ResourceCacheHeader*)file.get();
+		if (header->magic != NR_RESOURCE_CACHE_MAGIC || header->version != NR_RESOURCE_CACHE_VERSION) return false;
+		if (header->loaderVersion != loaderVersion) return false;
+		if (header->sourceTime != _modificationTime(st) || header->sourceSize != (uint64)st.st_size) return false;
+		if (sizeof(ResourceCacheHeader) + header->pathLength > fileSize) return false;
+		if (header->dataOffset > fileSize || header->dataSize > fileSize - header->dataOffset) return false;
+
+		// different files could have the same entry name
+		const char* path = (const char*)(file.get() + sizeof(ResourceCacheHeader));
+		if (fileName.compare(0, std::string::npos, path, header->pathLength) != 0) return false;
+
+		// data pointer keeps the whole mapping alive
+		data = SharedPtr<byte>(file, file.get() + header->dataOffset);
+		size = header->dataSize;
+
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceCache::store(const std::string& loader, uint32 loaderVersion, const std::string& fileName,
+			const void* data, size_t size)
+	{
+		struct stat st;
+		if (stat(fileName.c_str(), &st) != 0) return FILE_NOT_FOUND;
+
+		ResourceCacheHeader header;
+		header.magic = NR_RESOURCE_CACHE_MAGIC;
+		header.version = NR_RESOURCE_CACHE_VERSION;
+		header.loaderVersion = loaderVersion;
+		header.pathLength = fileName.length();
+		header.sourceTime = _modificationTime(st);
+		header.sourceSize = st.st_size;
+		header.dataOffset = sizeof(ResourceCacheHeader) + header.pathLength;
+		header.dataOffset = (header.dataOffset + NR_RESOURCE_CACHE_ALIGNMENT - 1) & ~(NR_RESOURCE_CACHE_ALIGNMENT - 1);
+		header.dataSize = size;
+
+		// write into a temporary file first, so readers never see half written entries.
+		// nothing is logged here, because the method is called from the loading threads.
+		// the temporary name is unique per process and thread, since other writers
+		// could store the same entry at the same time
+		std::string entryName = getEntryName(loader, fileName);
+		std::stringstream tmpStream;
+		tmpStream << entryName << "." << nrGetProcessId() << "." << boost::this_thread::get_id() << ".tmp";
+		std::string tmpName = tmpStream.str();
+		{
+			std::ofstream file(tmpName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file.good()) return FILE_NOT_FOUND;
+
+			static const char padding[NR_RESOURCE_CACHE_ALIGNMENT] = {0};
+			file.write((const char*)&header, sizeof(header));
+			file.write(fileName.c_str(), header.pathLength);
+			file.write(padding, header.dataOffset - sizeof(header) - header.pathLength);
+			if (size) file.write((const char*)data, size);
+
+			if (!file.good()){
+				file.close();
+				::remove(tmpName.c_str());
+				return FILE_NOT_FOUND;
+			}
+		}
+
+	#if NR_PLATFORM == NR_PLATFORM_WIN32
+		// rename does not replace existing files on windows
+		::remove(entryName.c_str());
+	#endif
+		if (::rename(tmpName.c_str(), entryName.c_str()) != 0){
+			::remove(tmpName.c_str());
+			return FILE_NOT_FOUND;
+		}
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceCache::clear()
+	{
+		LocalFileSystem dir(mDirectory);
+		IFileSystem::FileInfoListPtr files = dir.findFiles("*.nrc", false);
+
+		for (IFileSystem::FileInfoList::iterator it = files->begin(); it != files->end(); it++)
+			::remove(it->realPath.c_str());
+
+		NR_Log(Log::LOG_ENGINE, "ResourceCache: %d cached resources removed", (int32)files->size());
+	}
+
+};
+
@@ -29,7 +29,7 @@ namespace nrEngine{
 		
 	//----------------------------------------------------------------------------------
 	ResourceHolder::ResourceHolder(IResource* res, IResource* empty):
-			mResource(res), mEmptyResource(empty), countAccess(0)
+			mResource(res), mEmptyResource(empty), countAccess(0), countEmptyAccess(0), mGeneration(0)
 	{
 		NR_ASSERT(res != NULL && empty != NULL);
 			
@@ -54,10 +54,10 @@ namespace nrEngine{
 		// check whenever we've got the maximum, so do not lock
 		if (mLockStackTop >= NR_RESOURCE_LOCK_STACK){
 			if (mResource){
-				NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, 
+				NR_LogDebug(Log::LOG_ENGINE, 
 					"Can not lock %s anymore. Lock state stack is full!", mResource->getResourceName().c_str());
 			}else{
-				NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, 
+				NR_LogDebug(Log::LOG_ENGINE, 
 					"Can not lock anymore. Lock state stack is full!");
 			}
 			
@@ -65,6 +65,7 @@ namespace nrEngine{
 		}else{		
 			// lock it
 			mLockStack[mLockStackTop++] = true;
+			mGeneration++;
 		}
 		
 		return true;
@@ -77,6 +78,7 @@ namespace nrEngine{
 		if (mLockStackTop > 0){
 			// unlock it
 			mLockStack[--mLockStackTop] = false;
+			mGeneration++;
 		}
 	}
 
@@ -94,16 +96,17 @@ namespace nrEngine{
 		{
 			if (mResource)
 			{
-				NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, 
+				NR_LogDebug(Log::LOG_ENGINE, 
 					"Can not lock %s anymore. Lock state stack is full!", mResource->getResourceName().c_str());
 			}else{
-				NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, 
+				NR_LogDebug(Log::LOG_ENGINE, 
 					"Can not lock anymore. Lock state stack is full!");
 			}
 			return false;
 		}else{
 			// lock it
 			mEmptyLockStack[mEmptyLockStackTop++] = true;
+			mGeneration++;
 		}
 		
 		return true;
@@ -116,6 +119,7 @@ namespace nrEngine{
 		if (mEmptyLockStackTop > 0){
 			// unlock it
 			mEmptyLockStack[--mEmptyLockStackTop] = false;
+			mGeneration++;
 		}
 	}
 
@@ -123,6 +127,7 @@ namespace nrEngine{
 	void ResourceHolder::resetResource(IResource* res)
 	{
 		mResource = (res);
+		mGeneration++;
 	}
 	
 	
@@ -130,6 +135,7 @@ namespace nrEngine{
 	void ResourceHolder::setEmptyResource(IResource* res)
 	{
 		mEmptyResource = (res);
+		mGeneration++;
 	}
 		
 	//----------------------------------------------------------------------------------
@@ -145,7 +151,10 @@ namespace nrEngine{
 		NR_ASSERT(getEmpty() != NULL && "Empty resource must be defined");
 		
 		// check if empty is locked, then return empty resource
-		if (isEmptyLocked()) return getEmpty();
+		if (isEmptyLocked()){
+			countEmptyAccess ++;
+			return getEmpty();
+		}
 		
 		// get resource only if it is exists and loaded or if it exists and locked
 		if (mResource!=NULL)
@@ -158,6 +167,7 @@ namespace nrEngine{
 			}
 		}
 
+		countEmptyAccess ++;
 		return getEmpty();
 	}
 
@@ -19,6 +19,10 @@
 #include <nrEngine/Exception.h>
 #include <nrEngine/Engine.h>
 #include <nrEngine/ResourceManager.h>
+#include <nrEngine/FileSystemManager.h>
+#include <nrEngine/ResourceCache.h>
+#include <nrEngine/Profiler.h>
+#include <nrEngine/GetTime.h>
 
 namespace nrEngine{
 
@@ -33,8 +37,11 @@ namespace nrEngine{
 	{
 		// copy the list in another list, so we can iterate and remove them
 		std::vector<SharedPtr<IResource> > lst;
-		for (ResourceList::iterator it = mHandledResources.begin(); it != mHandledResources.end(); it ++)
-			lst.push_back(*it);
+		{
+			boost::mutex::scoped_lock lock(mHandledMutex);
+			for (ResourceList::iterator it = mHandledResources.begin(); it != mHandledResources.end(); it ++)
+				lst.push_back(*it);
+		}
 
 		// now go through the vector and remove elements
 		for (uint32 i=0; i < lst.size(); i++)
@@ -43,6 +50,81 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	SharedPtr<IResource> IResourceLoader::load(const std::string& name, const std::string& group, const std::string& fileName, const std::string& resourceType, PropertyList* param)
+	{
+		// create the resource instance and register it, so no other thread
+		// can load a resource with the same name meanwhile
+		std::string newFileName;
+		SharedPtr<IResource> res;
+		{
+			ResourceManager::DatabaseMutex::scoped_lock lock(Engine::sResourceManager()->mMutex);
+			res = prepareLoad(name, group, fileName, resourceType, param, newFileName);
+			if (res.get() == NULL) return res;
+			Engine::sResourceManager()->notifyCreated(res.get());
+		}
+
+		// now call the implemented loading function
+		if (loadResourceCached(res.get(), newFileName, param) != OK)
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceLoader %s can not load resource from file %s", mName.c_str(), newFileName.c_str());
+			remove(res);
+			return SharedPtr<IResource>();
+		}
+		res->setResourceLoaded(true);
+
+		// now notify the resource manager, that a new resource was loaded
+		Engine::sResourceManager()->notifyLoaded(res.get());
+
+		return res;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result IResourceLoader::loadResourceCached(IResource* res, const std::string& fileName, PropertyList* param, bool reload)
+	{
+		_nrEngineProfile("IResourceLoader::loadResource");
+
+		// loads are serialized, if the loader is not reentrant
+		boost::recursive_mutex::scoped_lock loadLock(mLoadMutex, boost::defer_lock);
+		if (!supportParallelLoading()) loadLock.lock();
+
+		ResourceStatistics& stats = Engine::sResourceManager()->getStatistics();
+		uint64 start = getMonotonicTime();
+
+		Result ret = OK;
+		SharedPtr<ResourceCache> cache = Engine::sResourceManager()->getResourceCache();
+		uint32 version = getCacheVersion();
+		if (!cache || version == 0 || param != NULL)
+		{
+			ret = loadResource(res, fileName, param);
+		}else{
+			// use the decoded data if the file was not changed since it was stored
+			SharedPtr<byte> data;
+			size_t size = 0;
+			bool hit = cache->lookup(mName, version, fileName, data, size) && loadCachedResource(res, fileName, data, size) == OK;
+			stats.recordCacheLookup(res, hit);
+
+			// load from the source file and store the result for the next time
+			if (!hit)
+			{
+				ret = loadResource(res, fileName, param);
+				if (ret == OK)
+				{
+					std::vector<byte> buffer;
+					if (saveCachedResource(res, buffer) == OK)
+						cache->store(mName, version, fileName, buffer.size() ? &buffer[0] : NULL, buffer.size());
+				}
+			}
+		}
+
+		if (reload)
+			stats.recordReload(res, (getMonotonicTime() - start) * 0.000000001, ret == OK);
+		else
+			stats.recordLoad(res, (getMonotonicTime() - start) * 0.000000001, ret == OK);
+
+		return ret;
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<IResource> IResourceLoader::prepareLoad(const std::string& name, const std::string& group, const std::string& fileName, const std::string& resourceType, PropertyList* param, std::string& newFileName)
 	{
 		// check if a such resource already registered by the manager
 		if (Engine::sResourceManager()->isResourceRegistered(name))
@@ -53,12 +135,13 @@ namespace nrEngine{
 
 		bool typeFound = false;
 		std::string type;
-		std::string newFileName = fileName;
+		// resolve the file through the virtual file system
+		newFileName = Engine::sFileSystemManager()->resolve(fileName);
 		
 		// we search for the type if no type is specified
 		if (resourceType.length() == 0)
 		{
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceLoader \"%s\" try to find according resource type by filename \"%s\"", mName.c_str(), fileName.c_str(), fileName.c_str());
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceLoader \"%s\" try to find according resource type by filename \"%s\"", mName.c_str(), fileName.c_str(), fileName.c_str());
 
 			// detect the file type by reading out it's last characters
 			for (int32 i = fileName.length()-1; i >= 0 && !typeFound; i--){
@@ -111,25 +194,16 @@ namespace nrEngine{
 		res->mResName = name;
 		res->mResGroup = group;
 
-		// now call the implemented loading function
-		if (loadResource(res.get(), newFileName, param) != OK)
-		{
-			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceLoader %s can not load resource from file %s", mName.c_str(), newFileName.c_str());
-			remove(res);
-			return SharedPtr<IResource>();
-		}
-		res->mResIsLoaded = true;
-
-		// now notify the resource manager, that a new resource was loaded
-		Engine::sResourceManager()->notifyLoaded(res.get());
-
 		return res;
 	}
 
 	//----------------------------------------------------------------------------------
 	SharedPtr<IResource> IResourceLoader::create(const std::string& resourceType, PropertyList* params)
 	{
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceLoader: Create resource of type %s", resourceType.c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "ResourceLoader: Create resource of type %s", resourceType.c_str());
+
+		// the empty resource is created only once, even if several threads create resources
+		ResourceManager::DatabaseMutex::scoped_lock lock(Engine::sResourceManager()->mMutex);
 
 		// first check if this type of resource is supported
 		if (!supportResourceType(resourceType))
@@ -170,7 +244,7 @@ namespace nrEngine{
 		res->mResLoader = getSharedPtrFromThis();
 		
 		// now set this resource in the list of handled resource objects
-		mHandledResources.push_back(res);
+		addHandled(res);
 
 		// ok now return the instance
 		return res;
@@ -186,6 +260,9 @@ namespace nrEngine{
 			return SharedPtr<IResource>();
 		}
 
+		// the check and the registration must not be interrupted by other threads
+		ResourceManager::DatabaseMutex::scoped_lock lock(Engine::sResourceManager()->mMutex);
+
 		// now check if such a resource is already in the database
 		IResourcePtr res = Engine::sResourceManager()->getByName(name);
 		if (!res.isNull()){
@@ -220,7 +297,7 @@ namespace nrEngine{
 			if (ret != OK) return ret;
 
 			// now mark the resource that it has been unloaded
-			resource->mResIsLoaded = false;
+			resource->setResourceLoaded(false);
 
 			// notify the resource manager about unloading the resource
 			Engine::sResourceManager()->notifyUnloaded(resource.get());
@@ -233,7 +310,7 @@ namespace nrEngine{
 	Result IResourceLoader::reload(SharedPtr<IResource> resource)
 	{
 		// check if we are the handler for this resource
-		if (std::find(mHandledResources.begin(), mHandledResources.end(), resource) == mHandledResources.end()){
+		if (!isHandled(resource)){
 			NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "ResourceLoader: You are trying to reload resource %s not handled by this loader %s", resource->getResName().c_str(), mName.c_str());
 			return OK;
 		}
@@ -249,7 +326,7 @@ namespace nrEngine{
 			if (ret != OK) return ret;
 
 			// now mark the resource that it has been unloaded
-			resource->mResIsLoaded = true;
+			resource->setResourceLoaded(true);
 
 			// notify the resource manager about unloading the resource
 			Engine::sResourceManager()->notifyLoaded(resource.get());
@@ -265,7 +342,7 @@ namespace nrEngine{
 		if (resource.get() == NULL) return OK;
 
 		// emove only handled resources
-		if (std::find(mHandledResources.begin(), mHandledResources.end(), resource) == mHandledResources.end())
+		if (!isHandled(resource))
 		{
 			NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "ResourceLoader: You are trying to remove resource %s not handled by this loader %s!", resource->getResourceName().c_str(), mName.c_str());
 			return OK;
@@ -286,19 +363,39 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	void IResourceLoader::notifyRemoveResource(SharedPtr<IResource> res)
 	{
-		ResourceList::iterator resit = std::find(mHandledResources.begin(), mHandledResources.end(), res);
-
-		// check if such resource is loaded
-		if (resit != mHandledResources.end() )
+		// remove the resource from the handled resources, if it is handled
+		if (removeHandled(res))
 		{
-			// ok remove the resource from the handled resources
-			mHandledResources.erase(resit);
-
 			// notify the manager about removing the resource
 			Engine::sResourceManager()->notifyRemove(res.get());
 		}
 	}
 
+	//----------------------------------------------------------------------------------
+	void IResourceLoader::addHandled(SharedPtr<IResource> res)
+	{
+		boost::mutex::scoped_lock lock(mHandledMutex);
+		mHandledResources.push_back(res);
+	}
+
+	//----------------------------------------------------------------------------------
+	bool IResourceLoader::removeHandled(SharedPtr<IResource> res)
+	{
+		boost::mutex::scoped_lock lock(mHandledMutex);
+		ResourceList::iterator it = std::find(mHandledResources.begin(), mHandledResources.end(), res);
+		if (it == mHandledResources.end()) return false;
+
+		mHandledResources.erase(it);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool IResourceLoader::isHandled(SharedPtr<IResource> res)
+	{
+		boost::mutex::scoped_lock lock(mHandledMutex);
+		return std::find(mHandledResources.begin(), mHandledResources.end(), res) != mHandledResources.end();
+	}
+
 #if 0
 
 	//----------------------------------------------------------------------------------
@@ -328,7 +425,7 @@ namespace nrEngine{
 			return ret;
 		}*/
 		if (res->mResIsLoaded == false) res->reloadRes();
-		//res->mResIsLoaded = true;
+		//res->setResourceLoaded(true);
 
 		// now notify the resource manager, that a new resource was loaded
 		//Engine::sResourceManager()->notifyLoaded(res);
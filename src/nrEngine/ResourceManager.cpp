@@ -17,9 +17,118 @@
 #include <nrEngine/Log.h>
 #include <nrEngine/Exception.h>
 #include <nrEngine/Engine.h>
+#include <nrEngine/FileSystemManager.h>
+#include <nrEngine/MemoryStream.h>
+#include <nrEngine/StdHelpers.h>
+#include <nrEngine/ResourceCache.h>
+#include <nrEngine/ResourceStatistics.h>
+#include <nrEngine/ResourceArena.h>
+#include <nrEngine/PropertyManager.h>
+#include <nrEngine/Clock.h>
+#include <nrEngine/Profiler.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/bind.hpp>
 
 namespace nrEngine{
 
+	//----------------------------------------------------------------------------------
+	struct ResourceManager::LoadGraph
+	{
+		//! Node of the graph, one for each resource which has to be loaded
+		struct Node
+		{
+			//! Resource instance, created before loading
+			SharedPtr<IResource> res;
+
+			//! Loader used to load the resource
+			ResourceLoader loader;
+
+			//! Resolved name of the file
+			std::string fileName;
+
+			//! Parameters passed to the loader
+			PropertyList* params;
+
+			//! Nodes depending on this one
+			std::vector<int32> parents;
+
+			//! Count of dependencies which are not loaded yet
+			int32 pending;
+
+			//! True while the dependencies of the node are added (cycle detection)
+			bool visiting;
+
+			//! Result of the loading
+			Result result;
+
+			//! Hash of the file content, valid if content sharing is enabled
+			uint64 contentKey;
+			bool hasContentKey;
+		};
+
+		//! All nodes, the first one is the requested resource
+		std::vector<Node> nodes;
+
+		//! Map of resource names to the nodes
+		std::map<std::string, int32> index;
+
+		//! Nodes ready to be loaded by any thread
+		std::deque<int32> parallel;
+
+		//! Nodes ready to be loaded by the main thread
+		std::deque<int32> serial;
+
+		//! Count of nodes not completed yet
+		int32 remaining;
+
+		//! Count of pool threads working on the graph
+		int32 workers;
+
+		//! Resource loaded by another thread, the graph has to wait for it
+		ResourceHandle loading;
+
+		boost::mutex mutex;
+		boost::condition_variable cond;
+
+		LoadGraph() : remaining(0), workers(0), loading(0) {}
+
+		//! Remove all nodes, so the graph can be build again
+		void clear()
+		{
+			nodes.clear();
+			index.clear();
+			parallel.clear();
+			serial.clear();
+			loading = 0;
+		}
+	};
+
+	//----------------------------------------------------------------------------------
+	struct ResourceManager::LoaderPool
+	{
+		//! Threads of the pool, started when they are needed first
+		boost::thread_group threads;
+		uint32 count;
+
+		//! Graphs to be loaded, each entry requests one thread
+		std::deque<LoadGraph*> queue;
+
+		//! True if the threads should exit
+		bool stop;
+
+		boost::mutex mutex;
+		boost::condition_variable cond;
+
+		//! Registered resources, which are not loaded yet, mapped to the thread loading them
+		std::map<ResourceHandle, boost::thread::id> loading;
+		boost::mutex loadingMutex;
+		boost::condition_variable loadingDone;
+
+		LoaderPool() : count(0), stop(false) {}
+	};
+
 	//----------------------------------------------------------------------------------
 	ScriptFunctionDec(scriptLoadResource, ResourceManager)
 	{
@@ -61,13 +170,49 @@ namespace nrEngine{
 		return ScriptResult();
 	}
 
+	//----------------------------------------------------------------------------------
+	ScriptFunctionDec(scriptResourceStatistics, ResourceManager)
+	{
+		ResourceManager* mgr = Engine::sResourceManager();
+
+		// reset the statistics if requested
+		if (args.size() > 1 && args[1] == "reset"){
+			mgr->resetStatistics();
+			return ScriptResult();
+		}
+
+		// print the statistics of the given loader or group, or of all of them
+		std::string text;
+		if (args.size() > 1){
+			text = ResourceStatistics::format(std::string(ResourceStatistics::LOADER_GROUP) + args[1], mgr->getLoaderStatistics(args[1])) + "\n";
+			text += ResourceStatistics::format(std::string(ResourceStatistics::GROUP_GROUP) + args[1], mgr->getGroupStatistics(args[1]));
+			mgr->publishStatistics();
+		}else{
+			mgr->dumpStatistics();
+			text = "Resource statistics written to the log";
+		}
+
+		return ScriptResult(text);
+	}
+
 	//----------------------------------------------------------------------------------
 	ResourceManager::ResourceManager(){
 		mLastHandle = 1;
+		mResourceMapGeneration = 0;
+		mContentSharing = false;
+		mStatistics.reset(new ResourceStatistics());
+		mStatisticsInterval = 0;
+		mLastStatisticsDump = 0;
+
+		// the calling thread loads resources too
+		mLoaderThreadCount = boost::thread::hardware_concurrency();
+		if (mLoaderThreadCount > 0) mLoaderThreadCount--;
+		mLoaderPool.reset(new LoaderPool());
 
 		// register functions by scripting engine
 		Engine::sScriptEngine()->add("loadResource", scriptLoadResource);
 		Engine::sScriptEngine()->add("unloadResource", scriptUnloadResource);
+		Engine::sScriptEngine()->add("resourceStatistics", scriptResourceStatistics);
 
 	}
 
@@ -78,6 +223,15 @@ namespace nrEngine{
 		// remove registered functions
 		Engine::sScriptEngine()->del("loadResource");
 		Engine::sScriptEngine()->del("unloadResource");
+		Engine::sScriptEngine()->del("resourceStatistics");
+
+		// stop the loader threads
+		{
+			boost::mutex::scoped_lock lock(mLoaderPool->mutex);
+			mLoaderPool->stop = true;
+			mLoaderPool->cond.notify_all();
+		}
+		mLoaderPool->threads.join_all();
 
 		// unload all resources
 		removeAllRes();
@@ -107,9 +261,8 @@ namespace nrEngine{
 		for (jt = mEmptyResource.begin(); jt != mEmptyResource.end(); jt++){
 			SharedPtr<IResource>& res = jt->second;
 
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceManager: Remove empty resource of type %s", res->getResourceType().c_str());
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Remove empty resource of type %s", res->getResourceType().c_str());
 			res.reset();
-			mEmptyResource.erase(jt);
 		}
 		mEmptyResource.clear();
 
@@ -118,11 +271,10 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	void ResourceManager::removeAllLoaders(){
 
-		// iterate through all loaders
-		loader_map::const_iterator it;
-
-		for (it = mLoader.begin(); it != mLoader.end(); it++){
-			removeLoader(it->first);
+		// remove the loaders one by one, removing invalidates the iterators
+		while (mLoader.begin() != mLoader.end()){
+			std::string name = mLoader.begin()->first;
+			removeLoader(name);
 		}
 
 	}
@@ -146,6 +298,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::registerLoader(const std::string& name, ResourceLoader loader){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// check whenver such a loader already exists
 		if (mLoader.find(name) != mLoader.end()){
@@ -189,6 +342,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::removeLoader(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// get id of the loader
 		loader_map::iterator jt = mLoader.find(name);
@@ -205,6 +359,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	ResourceLoader ResourceManager::getLoaderByFile(const std::string& fileType){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		if (fileType.length() == 0) return ResourceLoader();
 
@@ -225,6 +380,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	ResourceLoader ResourceManager::getLoader(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		loader_map::iterator it = mLoader.find(name);
 
@@ -237,6 +393,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	ResourceLoader ResourceManager::getLoaderByResource(const std::string& resType){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// scan through all loaders and ask them if they do support this kind of file type
 		loader_map::const_iterator it;
@@ -251,6 +408,129 @@ namespace nrEngine{
 
 	}
 
+	//----------------------------------------------------------------------------------
+	void ResourceManager::setCacheDirectory(const std::string& directory)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		if (directory.length() == 0)
+			mCache.reset();
+		else
+			mCache.reset(new ResourceCache(directory));
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::addResidentStatistics(ResourceCounters& c, const std::string* loaderName, const std::string* group)
+	{
+		// shared instances are counted only once
+		std::set<IResource*> counted;
+
+		for (res_hdl_map::const_iterator it = mResource.begin(); it != mResource.end(); it++)
+		{
+			IResource* res = it->second->mResource;
+			if (res == NULL) continue;
+
+			if (loaderName && (res->mResLoader == NULL || res->mResLoader->getName() != *loaderName)) continue;
+			if (group && res->getResourceGroup() != *group) continue;
+
+			c.emptyHits += it->second->getEmptyAccessCount();
+			if (res->isResourceLoaded() && counted.insert(res).second){
+				c.residentCount++;
+				c.residentBytes += res->getResourceDataSize();
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCounters ResourceManager::getLoaderStatistics(const std::string& loaderName)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		ResourceCounters c = mStatistics->getLoader(loaderName);
+		addResidentStatistics(c, &loaderName, NULL);
+		return c;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCounters ResourceManager::getGroupStatistics(const std::string& group)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		ResourceCounters c = mStatistics->getGroup(group);
+		addResidentStatistics(c, NULL, &group);
+		return c;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::resetStatistics()
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		mStatistics->reset();
+		for (res_hdl_map::iterator it = mResource.begin(); it != mResource.end(); it++)
+			it->second->countEmptyAccess = 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	static void _publishCounters(const std::string& group, const ResourceCounters& c)
+	{
+		PropertyManager* pm = Engine::sPropertyManager();
+
+		pm->set(c.loads, "loads", group);
+		pm->set(c.reloads, "reloads", group);
+		pm->set(c.unloads, "unloads", group);
+		pm->set(c.evictions, "evictions", group);
+		pm->set(c.failures, "failures", group);
+		pm->set(c.cacheHits, "cacheHits", group);
+		pm->set(c.cacheMisses, "cacheMisses", group);
+		pm->set(c.bytesLoaded, "bytesLoaded", group);
+		pm->set(c.residentCount, "residentCount", group);
+		pm->set(c.residentBytes, "residentBytes", group);
+		pm->set(c.emptyHits, "emptyHits", group);
+		pm->set(c.loadTime.getMean(), "loadTimeMean", group);
+		pm->set(c.loadTime.getPercentile(0.95f), "loadTimeP95", group);
+		pm->set(c.loadTime.max, "loadTimeMax", group);
+		pm->set(c.reloadTime.getMean(), "reloadTimeMean", group);
+		pm->set(c.reloadTime.getPercentile(0.95f), "reloadTimeP95", group);
+		pm->set(c.reloadTime.max, "reloadTimeMax", group);
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::publishStatistics()
+	{
+		std::vector<std::string> names = mStatistics->getLoaderNames();
+		for (uint32 i=0; i < names.size(); i++)
+			_publishCounters(ResourceStatistics::LOADER_GROUP + names[i], getLoaderStatistics(names[i]));
+
+		names = mStatistics->getGroupNames();
+		for (uint32 i=0; i < names.size(); i++)
+			_publishCounters(ResourceStatistics::GROUP_GROUP + names[i], getGroupStatistics(names[i]));
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::dumpStatistics()
+	{
+		NR_Log(Log::LOG_ENGINE, "ResourceManager: Statistics (cache=hits/lookups, latency=mean/p95/max)");
+
+		std::vector<std::string> names = mStatistics->getLoaderNames();
+		for (uint32 i=0; i < names.size(); i++)
+			NR_Log(Log::LOG_ENGINE, "  %s", ResourceStatistics::format(ResourceStatistics::LOADER_GROUP + names[i], getLoaderStatistics(names[i])).c_str());
+
+		names = mStatistics->getGroupNames();
+		for (uint32 i=0; i < names.size(); i++)
+			NR_Log(Log::LOG_ENGINE, "  %s", ResourceStatistics::format(ResourceStatistics::GROUP_GROUP + names[i], getGroupStatistics(names[i])).c_str());
+
+		publishStatistics();
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::updateStatistics()
+	{
+		if (mStatisticsInterval <= 0) return;
+
+		float64 now = Engine::sClock()->getTime();
+		if (now - mLastStatisticsDump < mStatisticsInterval) return;
+		mLastStatisticsDump = now;
+
+		dumpStatistics();
+	}
+
 	//----------------------------------------------------------------------------------
 	IResourcePtr ResourceManager::createResource (const std::string& name, const std::string& group, const std::string& resourceType, PropertyList* params)
 	{
@@ -276,7 +556,7 @@ namespace nrEngine{
 			return IResourcePtr();
 		}
 
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceManager: Create resource %s of type %s in group %s", name.c_str(), resourceType.c_str(), group.c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Create resource %s of type %s in group %s", name.c_str(), resourceType.c_str(), group.c_str());
 
 		// get the holder for this resource, it must be there
 		SharedPtr<ResourceHolder>& holder = *getHolderByName(name);
@@ -291,6 +571,9 @@ namespace nrEngine{
 			const std::string& name,const std::string& group,const std::string& fileName,
 			const std::string& resourceType,PropertyList* params,ResourceLoader loader)
 	{
+		_nrEngineProfile("ResourceManager::loadResource");
+
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		NR_Log(Log::LOG_ENGINE, "ResourceManager: Load resource %s of type %s from file %s", name.c_str(), resourceType.c_str(), fileName.c_str());
 
@@ -301,10 +584,170 @@ namespace nrEngine{
 		// check whenever such a resource already exists
 		IResourcePtr pRes = getByName(name);
 		if (!pRes.isNull()){
+			// the resource is not returned before another thread has loaded it
+			bool own = false;
+			if (isResourceLoading(mResourceName[name], &own) && !own){
+				waitLoading(mResourceName[name]);
+				pRes = getByName(name);
+				if (pRes.isNull()) return pRes;
+			}
+
 			NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "ResourceManager: Resource %s already loaded. Do nothing.", name.c_str());
+
+			// resource is now requested explicitly, so it is not unloaded with its dependents
+			res_dep_map::iterator it = mDependencyRef.find(mResourceName[name]);
+			if (it != mDependencyRef.end()) it->second.implicit = false;
+
 			return pRes;
 		}
 
+		// if the loader is manually specified, so do nothing
+		if (loader == NULL)
+		{
+			loader = findLoader(fileName, resourceType);
+
+			if (loader == NULL){
+				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: valid loader for resource %s was not found or no manual loader was specified, give up!", name.c_str());
+				return IResourcePtr();
+			}
+		}
+
+		// create the resource and all resources it depends on
+		LoadGraph graph;
+		Result ret = OK;
+		int32 root = addGraphNode(graph, name, group, fileName, resourceType, params, loader, ret);
+
+		// a resource of the graph is loaded by another thread, so the created resources
+		// are released, and the graph is build again as soon as the resource is loaded
+		while (ret == OK && graph.loading != 0)
+		{
+			for (uint32 i=0; i < graph.nodes.size(); i++)
+				graph.nodes[i].loader->remove(graph.nodes[i].res);
+
+			ResourceHandle handle = graph.loading;
+			graph.clear();
+			waitLoading(handle);
+
+			root = addGraphNode(graph, name, group, fileName, resourceType, params, loader, ret);
+		}
+
+		// the resource could be shared with an already loaded one
+		if (ret == OK && root == -1 && graph.nodes.size() == 0)
+			return getByName(name);
+
+		// on error, release all created resources
+		if (ret != OK || root < 0)
+		{
+			for (uint32 i=0; i < graph.nodes.size(); i++)
+				graph.nodes[i].loader->remove(graph.nodes[i].res);
+			return IResourcePtr();
+		}
+
+		// register the resources, so they can be found while loading
+		uint32 parallel = 0;
+		for (uint32 i=0; i < graph.nodes.size(); i++)
+		{
+			LoadGraph::Node& node = graph.nodes[i];
+			notifyCreated(node.res.get());
+			if (i != (uint32)root) mDependencyRef[node.res->getResourceHandle()].implicit = true;
+			if (node.loader->supportParallelLoading()) parallel++;
+		}
+
+		// other threads wait for the registered resources until they are completed
+		{
+			boost::mutex::scoped_lock loadingLock(mLoaderPool->loadingMutex);
+			for (uint32 i=0; i < graph.nodes.size(); i++)
+				mLoaderPool->loading[graph.nodes[i].res->getResourceHandle()] = boost::this_thread::get_id();
+		}
+
+		if (graph.nodes.size() > 1)
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Resource %s requires %d other resources", name.c_str(), (int32)graph.nodes.size() - 1);
+
+		// schedule all resources without dependencies
+		graph.remaining = graph.nodes.size();
+		graph.workers = 0;
+		for (uint32 i=0; i < graph.nodes.size(); i++)
+		{
+			LoadGraph::Node& node = graph.nodes[i];
+			if (node.pending > 0) continue;
+			if (node.result == OK && node.loader->supportParallelLoading())
+				graph.parallel.push_back(i);
+			else
+				graph.serial.push_back(i);
+		}
+
+		// the resources are registered now, so other threads can use the manager
+		// while they are decoded. Loading the same resource again finds it registered.
+		// The caller could hold the lock already (e.g. a loader running under reload()),
+		// so all its levels are released, otherwise the loader threads would wait for it.
+		// The level of the scoped lock is released and locked again together with them.
+		uint32 depth = mMutex.unlockAll();
+
+		// load the graph, use the pool threads only if there is something to do for them
+		uint32 threads = parallel > 1 ? std::min(mLoaderThreadCount, parallel - 1) : 0;
+		if (threads > 0)
+		{
+			boost::mutex::scoped_lock poolLock(mLoaderPool->mutex);
+			for (; mLoaderPool->count < threads; mLoaderPool->count++)
+				mLoaderPool->threads.create_thread(boost::bind(&ResourceManager::loaderThread, this));
+			for (uint32 i=0; i < threads; i++)
+				mLoaderPool->queue.push_back(&graph);
+			mLoaderPool->cond.notify_all();
+		}
+
+		processGraph(&graph, true);
+
+		// threads which have not started on the graph are not needed anymore,
+		// the others have to leave it before it is released
+		if (threads > 0)
+		{
+			{
+				boost::mutex::scoped_lock poolLock(mLoaderPool->mutex);
+				mLoaderPool->queue.erase(std::remove(mLoaderPool->queue.begin(), mLoaderPool->queue.end(), &graph), mLoaderPool->queue.end());
+			}
+			boost::mutex::scoped_lock graphLock(graph.mutex);
+			while (graph.workers > 0) graph.cond.wait(graphLock);
+		}
+
+		mMutex.lockAll(depth);
+
+		// loaded resources hold now the references on their dependencies,
+		// resources which could not be loaded are removed
+		for (uint32 i=0; i < graph.nodes.size(); i++)
+		{
+			LoadGraph::Node& node = graph.nodes[i];
+			if (node.result != OK)
+			{
+				ResourceHandle handle = node.res->getResourceHandle();
+				node.loader->remove(node.res);
+
+				boost::mutex::scoped_lock loadingLock(mLoaderPool->loadingMutex);
+				mLoaderPool->loading.erase(handle);
+				mLoaderPool->loadingDone.notify_all();
+				continue;
+			}
+			acquireDependencies(node.res.get());
+
+			// remember the content, so resources loaded later can share the instance
+			if (node.hasContentKey && mContent.find(node.contentKey) == mContent.end())
+			{
+				mContent[node.contentKey] = node.res->getResourceHandle();
+				mContentKey[node.res->getResourceHandle()] = node.contentKey;
+			}
+		}
+
+		if (graph.nodes[root].result != OK) return IResourcePtr();
+
+		// get the holder for this resource, it must be there
+		SharedPtr<ResourceHolder>& holder = *getHolderByName(name);
+		NR_ASSERT(holder.get() != NULL && "Holder must be valid here!");
+
+		return IResourcePtr(holder);
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceLoader ResourceManager::findLoader(const std::string& fileName, const std::string& resourceType)
+	{
 		// detect the file type by reading out it's last characters
 		std::string type;
 		for (int32 i = fileName.length()-1; i >= 0; i--){
@@ -313,34 +756,617 @@ namespace nrEngine{
 			}
 			type = fileName[i] + type;
 		}
-		bool isManualSpecified = (loader != NULL);
 
-		// if the loader is manually specified, so do nothing
-		if (!isManualSpecified)
+		ResourceLoader loader = getLoaderByResource(resourceType);
+		if (loader == NULL) loader = getLoaderByFile(type);
+
+		return loader;
+	}
+
+	//----------------------------------------------------------------------------------
+	int32 ResourceManager::addGraphNode(LoadGraph& graph, const std::string& name, const std::string& group,
+			const std::string& fileName, const std::string& resourceType,
+			PropertyList* params, ResourceLoader loader, Result& ret)
+	{
+		// -1 is returned for resources which are loaded, -2 if the resource can not be loaded
+
+		// check if the resource is already in the graph
+		std::map<std::string, int32>::const_iterator it = graph.index.find(name);
+		if (it != graph.index.end())
 		{
-			loader = getLoaderByResource(resourceType);
-			if (loader == NULL) loader = getLoaderByFile(type);
+			if (graph.nodes[it->second].visiting)
+			{
+				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Cyclic dependency found at resource %s", name.c_str());
+				ret = RES_DEPENDENCY_CYCLE;
+			}
+			return it->second;
+		}
 
-			if (loader == NULL){
-				NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: valid loader for resource %s was not found or no manual loader was specified, give up!", name.c_str());
-				return IResourcePtr();
+		// resources known by the manager are not loaded again, but reloaded if unloaded
+		SharedPtr<ResourceHolder>* holder = getHolderByName(name);
+		if (holder != NULL)
+		{
+			// resources loaded by another thread are waited for, not loaded twice
+			bool own = false;
+			if (isResourceLoading(mResourceName[name], &own))
+			{
+				if (own){
+					NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Resource %s is required while it is loaded by the same thread", name.c_str());
+					ret = RES_DEPENDENCY_CYCLE;
+				}else
+					graph.loading = mResourceName[name];
+				return -2;
 			}
+
+			IResource* res = (*holder)->mResource;
+			if (res && !res->isResourceLoaded() && res->reload() != OK) return -2;
+			return -1;
 		}
 
-		// now call the loader to create a resource
-		// loader will notify the manager, manager will add it into database
-		SharedPtr<IResource> res = loader->load(name, group, fileName, resourceType, params);
-		if (res == NULL) return IResourcePtr();
+		// find appropriate loader
+		if (loader == NULL) loader = findLoader(fileName, resourceType);
+		if (loader == NULL)
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: No loader found for resource %s", name.c_str());
+			return -2;
+		}
 
-		// get the holder for this resource, it must be there
-		SharedPtr<ResourceHolder>& holder = *getHolderByName(name);
-		NR_ASSERT(holder.get() != NULL && "Holder must be valid here!");
+		// create the resource instance, it will be loaded later
+		std::string newFileName;
+		SharedPtr<IResource> res = loader->prepareLoad(name, group, fileName, resourceType, params, newFileName);
+		if (res.get() == NULL) return -2;
 
-		return IResourcePtr(holder);
+		// resources with the same content as an already loaded one share its instance
+		uint64 contentKey = 0;
+		bool hasContentKey = mContentSharing && params == NULL
+			&& computeContentKey(loader, fileName, res->getResourceType(), contentKey);
+		if (hasContentKey)
+		{
+			std::map<uint64, ResourceHandle>::const_iterator ct = mContent.find(contentKey);
+			SharedPtr<ResourceHolder>* owner = ct != mContent.end() ? getHolderByHandle(ct->second) : NULL;
+			if (owner != NULL && (*owner)->mResource && (*owner)->mResource->isResourceLoaded())
+			{
+				loader->remove(res);
+				addSharedAlias(ct->second, name, group, newFileName);
+				return -1;
+			}
+		}
+
+		// ask the loader for the dependencies
+		ResourceDependencyList deps;
+		Result depRet = loader->declareDependencies(newFileName, params, deps);
+		if (depRet != OK)
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Can not get dependencies of resource %s", name.c_str());
+
+		int32 index = graph.nodes.size();
+		graph.nodes.push_back(LoadGraph::Node());
+		graph.index[name] = index;
+
+		LoadGraph::Node& node = graph.nodes[index];
+		node.res = res;
+		node.loader = loader;
+		node.fileName = newFileName;
+		node.params = params;
+		node.pending = 0;
+		node.visiting = true;
+		node.result = depRet;
+		node.contentKey = contentKey;
+		node.hasContentKey = hasContentKey;
+
+		// add the dependencies, the node reference is not valid after adding other nodes
+		ResourceDependencyList::const_iterator jt = deps.begin();
+		for (; jt != deps.end() && ret == OK && graph.loading == 0; jt++)
+		{
+			std::string depName = jt->name.length() ? jt->name : jt->fileName;
+			std::string depGroup = jt->group.length() ? jt->group : group;
+			res->mResDependencies.push_back(depName);
+
+			int32 child = addGraphNode(graph, depName, depGroup, jt->fileName, jt->resourceType, NULL, ResourceLoader(), ret);
+			if (child == -2){
+				graph.nodes[index].result = RES_DEPENDENCY_FAILED;
+			}else if (child >= 0){
+				graph.nodes[child].parents.push_back(index);
+				graph.nodes[index].pending++;
+			}
+		}
+
+		graph.nodes[index].visiting = false;
+		return index;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::processGraph(LoadGraph* graph, bool mainThread)
+	{
+		boost::mutex::scoped_lock lock(graph->mutex);
+
+		while (graph->remaining > 0)
+		{
+			// get next resource ready to be loaded
+			int32 index = -1;
+			if (mainThread && graph->serial.size()){
+				index = graph->serial.front();
+				graph->serial.pop_front();
+			}else if (graph->parallel.size()){
+				index = graph->parallel.front();
+				graph->parallel.pop_front();
+			}
+
+			// wait until any other resource is completed
+			if (index < 0){
+				graph->cond.wait(lock);
+				continue;
+			}
+
+			// load the resource, if none of its dependencies failed
+			LoadGraph::Node& node = graph->nodes[index];
+			Result ret = node.result;
+			if (ret == OK)
+			{
+				lock.unlock();
+				ret = node.loader->loadResourceCached(node.res.get(), node.fileName, node.params);
+				lock.lock();
+			}
+
+			completeGraphNode(graph, index, ret);
+		}
+
+		// the thread which has build the graph waits until all pool threads leave it
+		if (!mainThread)
+		{
+			graph->workers--;
+			graph->cond.notify_all();
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceManager::isResourceLoading(ResourceHandle handle, bool* own)
+	{
+		boost::mutex::scoped_lock lock(mLoaderPool->loadingMutex);
+
+		std::map<ResourceHandle, boost::thread::id>::const_iterator it = mLoaderPool->loading.find(handle);
+		if (it == mLoaderPool->loading.end()) return false;
+
+		if (own) *own = (it->second == boost::this_thread::get_id());
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::waitLoading(ResourceHandle handle)
+	{
+		// the loading thread needs the database to complete the resource
+		uint32 depth = mMutex.unlockAll();
+		{
+			boost::mutex::scoped_lock lock(mLoaderPool->loadingMutex);
+			while (mLoaderPool->loading.find(handle) != mLoaderPool->loading.end())
+				mLoaderPool->loadingDone.wait(lock);
+		}
+		mMutex.lockAll(depth);
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::loaderThread()
+	{
+		boost::mutex::scoped_lock lock(mLoaderPool->mutex);
+
+		while (!mLoaderPool->stop)
+		{
+			if (mLoaderPool->queue.empty())
+			{
+				mLoaderPool->cond.wait(lock);
+				continue;
+			}
+
+			// the graph is not released while the thread works on it
+			LoadGraph* graph = mLoaderPool->queue.front();
+			mLoaderPool->queue.pop_front();
+			{
+				boost::mutex::scoped_lock graphLock(graph->mutex);
+				graph->workers++;
+			}
+
+			lock.unlock();
+			processGraph(graph, false);
+			lock.lock();
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::completeGraphNode(LoadGraph* graph, int32 index, Result ret)
+	{
+		LoadGraph::Node& node = graph->nodes[index];
+
+		node.result = ret;
+		if (ret == OK)
+		{
+			node.res->setResourceLoaded(true);
+
+			// failed resources are loading until they are removed
+			boost::mutex::scoped_lock loadingLock(mLoaderPool->loadingMutex);
+			mLoaderPool->loading.erase(node.res->getResourceHandle());
+			mLoaderPool->loadingDone.notify_all();
+		}
+		else if (ret == RES_DEPENDENCY_FAILED)
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Resource %s is not loaded, because a resource it depends on failed", node.res->getResourceName().c_str());
+		else
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Can not load resource %s from file %s", node.res->getResourceName().c_str(), node.fileName.c_str());
+
+		// resources depending on this one can be loaded now
+		for (uint32 i=0; i < node.parents.size(); i++)
+		{
+			LoadGraph::Node& parent = graph->nodes[node.parents[i]];
+			if (ret != OK) parent.result = RES_DEPENDENCY_FAILED;
+			if (--parent.pending > 0) continue;
+
+			if (parent.result == OK && parent.loader->supportParallelLoading())
+				graph->parallel.push_back(node.parents[i]);
+			else
+				graph->serial.push_back(node.parents[i]);
+		}
+
+		graph->remaining--;
+		graph->cond.notify_all();
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::acquireDependencies(IResource* res)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		if (res == NULL || res->mResDependencies.size() == 0) return;
+
+		// each resource holds only one reference on its dependencies
+		if (!mDependencyHolder.insert(res->getResourceHandle()).second) return;
+
+		std::list<std::string>::const_iterator it = res->mResDependencies.begin();
+		for (; it != res->mResDependencies.end(); it++)
+		{
+			SharedPtr<ResourceHolder>* holder = getHolderByName(*it);
+			if (holder == NULL || (*holder)->mResource == NULL) continue;
+
+			IResource* dep = (*holder)->mResource;
+			if (!dep->isResourceLoaded()) dep->reload();
+
+			mDependencyRef[dep->getResourceHandle()].refCount++;
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::releaseDependencies(IResource* res)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		if (res == NULL) return;
+
+		std::set<ResourceHandle>::iterator hit = mDependencyHolder.find(res->getResourceHandle());
+		if (hit == mDependencyHolder.end()) return;
+		mDependencyHolder.erase(hit);
+
+		std::list<std::string>::const_iterator it = res->mResDependencies.begin();
+		for (; it != res->mResDependencies.end(); it++)
+		{
+			SharedPtr<ResourceHolder>* holder = getHolderByName(*it);
+			if (holder == NULL || (*holder)->mResource == NULL) continue;
+
+			IResource* dep = (*holder)->mResource;
+			res_dep_map::iterator jt = mDependencyRef.find(dep->getResourceHandle());
+			if (jt == mDependencyRef.end()) continue;
+
+			// unload dependencies not required anymore
+			if (--jt->second.refCount > 0) continue;
+			jt->second.refCount = 0;
+			if (jt->second.implicit && dep->isResourceLoaded())
+			{
+				NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Unload resource %s, it is not required anymore", dep->getResourceName().c_str());
+				dep->unload();
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceManager::computeContentKey(ResourceLoader loader, const std::string& fileName,
+			const std::string& resourceType, uint64& key)
+	{
+		SharedPtr<FileStream> fStream = Engine::sFileSystemManager()->open(fileName);
+		if (!fStream) return false;
+
+		// the same content loaded by another loader or to another type is different
+		std::string kind = loader->mName + ":" + resourceType;
+		uint64 seed = hashData(kind.c_str(), kind.length());
+
+		// hash directly the memory if possible
+		MemoryStream* mem = dynamic_cast<MemoryStream*>(fStream.get());
+		if (mem){
+			size_t size = 0;
+			const byte* data = mem->getData(size);
+			key = hashData(data, data ? size : 0, seed);
+		}else{
+			std::string str = fStream->getAsString();
+			key = hashData(str.c_str(), str.length(), seed);
+		}
+
+		return true;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::addSharedAlias(ResourceHandle owner, const std::string& name,
+			const std::string& group, const std::string& fileName)
+	{
+		IResource* res = mResource[owner]->mResource;
+		ResourceHandle handle = getNewHandle();
+
+		NR_Log(Log::LOG_ENGINE, "ResourceManager: Resource %s has the same content as %s, share the instance", name.c_str(), res->getResourceName().c_str());
+
+		// new holder pointing to the same instance
+		SharedPtr<ResourceHolder> holder(new ResourceHolder(res, getEmpty(res->getResourceType()).get()));
+		mResourceGroup[group].push_back(handle);
+		mResourceMapGeneration++;
+		mResource[handle] = holder;
+		mResourceName[name] = handle;
+
+		SharedAlias& alias = mSharedAlias[handle];
+		alias.owner = owner;
+		alias.name = name;
+		alias.group = group;
+		alias.fileNames.push_back(fileName);
+		mSharedOwner[owner].push_back(handle);
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceManager::isShared(ResourceHandle handle)
+	{
+		return mSharedAlias.find(handle) != mSharedAlias.end() || mSharedOwner.find(handle) != mSharedOwner.end();
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceHandle ResourceManager::getSharedHandle(ResourceHolder* holder)
+	{
+		if (holder == NULL || holder->mResource == NULL) return 0;
+
+		// the instance knows only the handle of its owner
+		ResourceHandle owner = holder->mResource->getResourceHandle();
+		res_owner_map::const_iterator it = mSharedOwner.find(owner);
+		if (it == mSharedOwner.end()) return 0;
+
+		SharedPtr<ResourceHolder>* ownerHolder = getHolderByHandle(owner);
+		if (ownerHolder && ownerHolder->get() == holder) return owner;
+
+		std::list<ResourceHandle>::const_iterator jt = it->second.begin();
+		for (; jt != it->second.end(); jt++)
+			if (mResource[*jt].get() == holder) return *jt;
+
+		return 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::detachShared(ResourceHandle handle, std::string& name, std::string& group,
+			std::list<std::string>& fileNames)
+	{
+		// alias is just removed from the list of its owner
+		res_alias_map::iterator it = mSharedAlias.find(handle);
+		if (it != mSharedAlias.end())
+		{
+			name = it->second.name;
+			group = it->second.group;
+			fileNames = it->second.fileNames;
+
+			res_owner_map::iterator jt = mSharedOwner.find(it->second.owner);
+			jt->second.remove(handle);
+			if (jt->second.size() == 0) mSharedOwner.erase(jt);
+
+			mSharedAlias.erase(it);
+			return;
+		}
+
+		res_owner_map::iterator jt = mSharedOwner.find(handle);
+		if (jt == mSharedOwner.end()) return;
+
+		// owner gives the instance to the first alias
+		IResource* res = mResource[handle]->mResource;
+		name = res->mResName;
+		group = res->mResGroup;
+		fileNames = res->mResFileNames;
+
+		std::list<ResourceHandle> aliases = jt->second;
+		mSharedOwner.erase(jt);
+
+		ResourceHandle newOwner = aliases.front();
+		aliases.pop_front();
+
+		SharedAlias& alias = mSharedAlias[newOwner];
+		res->mResName = alias.name;
+		res->mResGroup = alias.group;
+		res->mResFileNames = alias.fileNames;
+		res->mResHandle = newOwner;
+		mSharedAlias.erase(newOwner);
+
+		// references on the dependencies are held by the instance
+		if (mDependencyHolder.erase(handle)) mDependencyHolder.insert(newOwner);
+
+		// the instance keeps its content
+		std::map<ResourceHandle, uint64>::iterator kt = mContentKey.find(handle);
+		if (kt != mContentKey.end())
+		{
+			mContent[kt->second] = newOwner;
+			mContentKey[newOwner] = kt->second;
+			mContentKey.erase(kt);
+		}
+
+		// other aliases belong now to the new owner
+		if (aliases.size() == 0) return;
+		for (std::list<ResourceHandle>::iterator at = aliases.begin(); at != aliases.end(); at++)
+			mSharedAlias[*at].owner = newOwner;
+		mSharedOwner[newOwner] = aliases;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceManager::copyShared(ResourceHandle handle, bool load)
+	{
+		std::string name, group;
+		std::list<std::string> fileNames;
+		detachShared(handle, name, group, fileNames);
+
+		SharedPtr<ResourceHolder>& holder = mResource[handle];
+		IResource* old = holder->mResource;
+
+		NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Resource %s does not share its instance anymore", name.c_str());
+
+		// create own instance, the loader handles it from now on
+		SharedPtr<IResource> res = old->mResLoader->create(old->getResourceType(), NULL);
+		if (res.get() == NULL) return RES_ERROR;
+
+		res->mResName = name;
+		res->mResGroup = group;
+		res->mResHandle = handle;
+		res->mResFileNames = fileNames;
+		res->mResDependencies = old->mResDependencies;
+		holder->resetResource(res.get());
+
+		if (!load) return OK;
+
+		Result ret = loadReloadInstance(res);
+		if (ret == OK) acquireDependencies(res.get());
+		return ret;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceManager::removeShared(ResourceHandle handle)
+	{
+		std::string name, group;
+		std::list<std::string> fileNames;
+		detachShared(handle, name, group, fileNames);
+
+		NR_Log(Log::LOG_ENGINE, "ResourceManager: Remove resource %s (%s)", name.c_str(), group.c_str());
+
+		// remove the handle from the group list
+		ResourceGroupMap::iterator jt = mResourceGroup.find(group);
+		if (jt != mResourceGroup.end()){
+			jt->second.remove(handle);
+			mResourceMapGeneration++;
+			if (jt->second.size() == 0) mResourceGroup.erase(jt);
+		}
+
+		// the instance stays in use by the other holders
+		mResource[handle]->resetResource(NULL);
+		mDependencyRef.erase(handle);
+		mResourceName.erase(name);
+		mResource.erase(handle);
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::forgetContent(ResourceHandle handle)
+	{
+		std::map<ResourceHandle, uint64>::iterator it = mContentKey.find(handle);
+		if (it == mContentKey.end()) return;
+
+		mContent.erase(it->second);
+		mContentKey.erase(it);
+	}
+
+	//----------------------------------------------------------------------------------
+	SharedPtr<IResource> ResourceManager::createReloadInstance(const std::string& name)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		SharedPtr<ResourceHolder>* holder = getHolderByName(name);
+		if (holder == NULL || (*holder)->mResource == NULL) return SharedPtr<IResource>();
+
+		IResource* old = (*holder)->mResource;
+		ResourceLoader loader = old->mResLoader;
+		if (loader == NULL) return SharedPtr<IResource>();
+
+		// create new instance, it will be handled by the loader only after swapping
+		SharedPtr<IResource> res = loader->create(old->getResourceType(), NULL);
+		if (res.get() == NULL) return res;
+		loader->removeHandled(res);
+
+		// copy the description of the resource
+		res->mResName = old->mResName;
+		res->mResGroup = old->mResGroup;
+		res->mResFileNames = old->mResFileNames;
+		res->mResDependencies = old->mResDependencies;
+
+		// shared instance is described by its owner
+		res_alias_map::const_iterator it = mSharedAlias.find(mResourceName[name]);
+		if (it != mSharedAlias.end())
+		{
+			res->mResName = it->second.name;
+			res->mResGroup = it->second.group;
+			res->mResFileNames = it->second.fileNames;
+		}
+
+		return res;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceManager::loadReloadInstance(SharedPtr<IResource> res)
+	{
+		if (res.get() == NULL || res->mResLoader == NULL) return RES_PTR_IS_NULL;
+		if (res->mResFileNames.size() == 0) return RES_NOT_FOUND;
+
+		// load the instance from its file
+		const std::string& fileName = res->mResFileNames.front();
+		Result ret = res->mResLoader->loadResourceCached(res.get(), fileName, NULL, true);
+		if (ret != OK)
+		{
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "ResourceManager: Can not reload resource %s from file %s", res->getResourceName().c_str(), fileName.c_str());
+			return ret;
+		}
+
+		res->setResourceLoaded(true);
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	bool ResourceManager::supportParallelLoading(SharedPtr<IResource> res)
+	{
+		if (res.get() == NULL || res->mResLoader == NULL) return false;
+		return res->mResLoader->supportParallelLoading();
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceManager::swapReloadInstance(SharedPtr<IResource> res)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+		if (res.get() == NULL) return RES_PTR_IS_NULL;
+		if (!res->isResourceLoaded()) return RES_ERROR;
+
+		// the resource could be removed while the instance was loaded
+		SharedPtr<ResourceHolder>* holder = getHolderByName(res->getResourceName());
+		if (holder == NULL || (*holder)->mResource == NULL) return RES_NOT_FOUND;
+
+		SharedPtr<IResource> old = (*holder)->mResource->getSharedPtrFromThis();
+		ResourceHandle handle = mResourceName[res->getResourceName()];
+
+		// other holders sharing the old instance keep it
+		bool shared = isShared(handle);
+		if (shared)
+		{
+			std::string name, group;
+			std::list<std::string> fileNames;
+			detachShared(handle, name, group, fileNames);
+		}
+		forgetContent(handle);
+
+		// new instance takes the place of the old one
+		res->mResHandle = handle;
+		res->setResourceDirty(false);
+		res->mResLoader->addHandled(res);
+		(*holder)->resetResource(res.get());
+
+		// the old instance is not handled anymore
+		if (!shared) old->mResLoader->removeHandled(old);
+
+		NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Resource %s replaced by reloaded instance", res->getResourceName().c_str());
+
+		return OK;
 	}
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unload(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		res_str_map::const_iterator it = mResourceName.find(name);
+		if (it != mResourceName.end() && isShared(it->second)) return copyShared(it->second, false);
 
 		ResourcePtr<IResource> res = getByName(name);
 
@@ -358,6 +1384,11 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unload(IResourcePtr& res){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		ResourceHandle shared = res.isNull() ? 0 : getSharedHandle(res.getResourceHolder().get());
+		if (shared) return copyShared(shared, false);
 
 		if (res.isNull()){
 			return RES_NOT_FOUND;
@@ -374,6 +1405,10 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unload(ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		if (isShared(handle)) return copyShared(handle, false);
 
 		ResourcePtr<IResource> res = getByHandle(handle);
 
@@ -392,6 +1427,11 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::reload(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		res_str_map::const_iterator it = mResourceName.find(name);
+		if (it != mResourceName.end() && isShared(it->second)) return copyShared(it->second, true);
 
 		ResourcePtr<IResource> res = getByName(name);
 
@@ -400,7 +1440,7 @@ namespace nrEngine{
 		}
 
 		lockResource(res);
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceManager: Reload resource %s",
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Reload resource %s",
 				res->getResourceName().c_str(), res->getResourceHandle());
 			Result ret = res->reload();
 		unlockResource(res);
@@ -410,6 +1450,10 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::reload(ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		if (isShared(handle)) return copyShared(handle, true);
 
 		ResourcePtr<IResource> res = getByHandle(handle);
 
@@ -418,7 +1462,7 @@ namespace nrEngine{
 		}
 
 		lockResource(res);
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceManager: Reload resource %s",
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Reload resource %s",
 				res->getResourceName().c_str(), res->getResourceHandle());
 			Result ret = res->reload();
 		unlockResource(res);
@@ -428,13 +1472,18 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::reload(IResourcePtr& res){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// resources sharing their instance get their own one
+		ResourceHandle shared = res.isNull() ? 0 : getSharedHandle(res.getResourceHolder().get());
+		if (shared) return copyShared(shared, true);
 
 		if (res.isNull()){
 			return RES_NOT_FOUND;
 		}
 
 		lockResource(res);
-			NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ResourceManager: Reload resource %s",
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceManager: Reload resource %s",
 				res.getBase()->getResourceName().c_str(), res.getBase()->getResourceHandle());
 			Result ret = res.getBase()->reload();
 		unlockResource(res);
@@ -470,6 +1519,7 @@ namespace nrEngine{
 				res_grp_map::iterator jt = mResourceGroup.find(grp);
 				if (jt != mResourceGroup.end()){
 					jt->second.remove(hdl);
+					mResourceMapGeneration++;
 
 					// check whenever group contains nomore elements, and delete it
 					if (jt->second.size() == 0){
@@ -493,6 +1543,11 @@ namespace nrEngine{
 */
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::remove(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// shared instance stays in use by the other holders
+		res_str_map::const_iterator it = mResourceName.find(name);
+		if (it != mResourceName.end() && isShared(it->second)) return removeShared(it->second);
 
 		// check whenever such a resource exists
 		IResourcePtr ptr = getByName(name);
@@ -511,6 +1566,10 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::remove(ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// shared instance stays in use by the other holders
+		if (isShared(handle)) return removeShared(handle);
 
 		// check whenever such a resource exists
 		IResourcePtr ptr = getByHandle(handle);
@@ -529,6 +1588,11 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::remove(IResourcePtr& ptr){
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		// shared instance stays in use by the other holders
+		ResourceHandle shared = ptr.isNull() ? 0 : getSharedHandle(ptr.getResourceHolder().get());
+		if (shared) return removeShared(shared);
 
 		// check whenever such a resource exists
 		if (!ptr.isNull()){
@@ -544,6 +1608,7 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	SharedPtr<ResourceHolder>* ResourceManager::getHolderByName(const std::string& name)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		// find the handle
 		res_str_map::iterator it = mResourceName.find(name);
 		if (it == mResourceName.end()){
@@ -559,6 +1624,7 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	SharedPtr<ResourceHolder>* ResourceManager::getHolderByHandle(const ResourceHandle& handle)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		// find through the handle
 		res_hdl_map::iterator it = mResource.find(handle);
 		if (it == mResource.end())
@@ -570,6 +1636,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	IResourcePtr ResourceManager::getByName(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
 		SharedPtr<ResourceHolder>* holder = getHolderByName(name);
 		if (holder == NULL){
 			return IResourcePtr();
@@ -580,6 +1647,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	IResourcePtr ResourceManager::getByHandle(const ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
 		SharedPtr<ResourceHolder>* holder = getHolderByHandle(handle);
 		if (holder == NULL){
 			return IResourcePtr();
@@ -616,6 +1684,7 @@ namespace nrEngine{
 
 		// store the resource in database
 		mResourceGroup[group].push_back(handle);
+		mResourceMapGeneration++;
 		mResource[handle] = holder;
 		mResourceName[name] = handle;
 
@@ -640,6 +1709,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::lockResource(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// get appropriate pointer
 		IResourcePtr ptr = getByName(name);
@@ -652,6 +1722,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::lockResource(ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// get appropriate pointer
 		IResourcePtr ptr = getByHandle(handle);
@@ -665,6 +1736,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::lockResource(IResourcePtr& res){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// lock through the pointer
 		return res.lockResource();
@@ -673,6 +1745,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unlockResource(const std::string& name){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// get appropriate holder
 		SharedPtr<ResourceHolder>* holder = getHolderByName(name);
@@ -690,6 +1763,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unlockResource(ResourceHandle& handle){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// get appropriate holder
 		SharedPtr<ResourceHolder>* holder = getHolderByHandle(handle);
@@ -707,6 +1781,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unlockResource(IResourcePtr& res){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// if pointer does not pointing anywhere
 		if (res.isNull()){
@@ -721,6 +1796,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::unloadGroup(const std::string& group){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// check whenever such a group exists
 		ResourceGroupMap::const_iterator it = mResourceGroup.find(group);
@@ -738,12 +1814,16 @@ namespace nrEngine{
 			if (ret != OK) return ret;
 		}
 
+		// free the memory of the whole group at once
+		releaseGroupArena(group);
+
 		// OK
 		return OK;
 	}
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::reloadGroup(const std::string& group){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// check whenever such a group exists
 		ResourceGroupMap::const_iterator it = mResourceGroup.find(group);
@@ -768,6 +1848,7 @@ namespace nrEngine{
 
 	//----------------------------------------------------------------------------------
 	Result ResourceManager::removeGroup(const std::string& group){
+		DatabaseMutex::scoped_lock lock(mMutex);
 
 		// check whenever such a group exists
 		ResourceGroupMap::const_iterator it = mResourceGroup.find(group);
@@ -778,15 +1859,20 @@ namespace nrEngine{
 
 		NR_Log(Log::LOG_ENGINE, "ResourceManager: Remove all elements from the group \"%s\"", group.c_str());
 
-		// scan through all elements
-		std::list<ResourceHandle>::iterator jt = mResourceGroup[group].begin();
-		for (; jt != mResourceGroup[group].end(); jt++){
+		// scan through all elements, removing changes the group, so work on a copy
+		std::list<ResourceHandle> handles = mResourceGroup[group];
+		std::list<ResourceHandle>::iterator jt = handles.begin();
+		for (; jt != handles.end(); jt++){
 			Result ret = remove(*jt);
 			if (ret != OK) return ret;
 		}
 
 		// remove the group
 		mResourceGroup.erase(group);
+		mResourceMapGeneration++;
+
+		// free the memory of the whole group at once
+		releaseGroupArena(group);
 
 		// OK
 		return OK;
@@ -796,6 +1882,7 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	const std::list<ResourceHandle>& ResourceManager::getGroupHandles(const std::string& name)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		// check if such a group exists
 		ResourceGroupMap::const_iterator it = mResourceGroup.find(name);
 
@@ -807,9 +1894,58 @@ namespace nrEngine{
 		return it->second;
 	}
 
+	//----------------------------------------------------------------------------------
+	Result ResourceManager::enableGroupArena(const std::string& group, std::size_t chunkSize)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		if (mGroupArena.find(group) != mGroupArena.end()) return OK;
+
+		mGroupArena[group] = SharedPtr<ResourceArena>(new ResourceArena(chunkSize));
+		NR_Log(Log::LOG_ENGINE, "ResourceManager: Group \"%s\" allocates resource data from an arena", group.c_str());
+
+		return OK;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceArena* ResourceManager::getGroupArena(const std::string& group)
+	{
+		DatabaseMutex::scoped_lock lock(mMutex);
+
+		std::map<std::string, SharedPtr<ResourceArena> >::const_iterator it = mGroupArena.find(group);
+		if (it == mGroupArena.end()) return NULL;
+
+		return it->second.get();
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceManager::releaseGroupArena(const std::string& group)
+	{
+		std::map<std::string, SharedPtr<ResourceArena> >::const_iterator it = mGroupArena.find(group);
+		if (it == mGroupArena.end() || it->second->getReservedSize() == 0) return;
+
+		// loaded resources could still use the memory (e.g. locked ones or shared
+		// instances moved to another group) and resources being loaded allocate from it
+		ResourceArena* arena = it->second.get();
+		res_hdl_map::const_iterator ht = mResource.begin();
+		for (; ht != mResource.end(); ht++){
+			IResource* res = ht->second->mResource;
+			if (res == NULL || (res->mResArena != arena && res->getResourceGroup() != group)) continue;
+
+			if (res->isResourceLoaded() || isResourceLoading(ht->first)){
+				NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "ResourceManager: Arena of group \"%s\" is not released, because %s is still using it", group.c_str(), res->getResourceName().c_str());
+				return;
+			}
+		}
+
+		NR_Log(Log::LOG_ENGINE, "ResourceManager: Release arena of group \"%s\" (%d KB)", group.c_str(), (int32)(it->second->getReservedSize() / 1024));
+		it->second->release();
+	}
+
 	//----------------------------------------------------------------------------------
 	SharedPtr<IResource> ResourceManager::getEmpty(const std::string& type)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		res_empty_map::iterator it = mEmptyResource.find(type);
 		if (it == mEmptyResource.end())
 		{
@@ -822,6 +1958,7 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	void ResourceManager::setEmpty(const std::string& type, SharedPtr<IResource> empty)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		// check if empty is valid
 		if (empty == NULL) return;
 
@@ -832,6 +1969,7 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	bool ResourceManager::isResourceRegistered(const std::string& name)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		IResourcePtr res = getByName(name);
 		return res.isNull() == false;
 	}
@@ -839,10 +1977,14 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	void ResourceManager::notifyLoaded(IResource* res)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		if (res == NULL) return;
 
-		// check if such a resource is already in the database
-		if (isResourceRegistered(res->getResourceName())) return;
+		// check if such a resource is already in the database, reloaded content could differ
+		if (isResourceRegistered(res->getResourceName())){
+			forgetContent(res->getResourceHandle());
+			return;
+		}
 
 		// get some data from the resource
 		const std::string& group = res->getResourceGroup();
@@ -864,6 +2006,7 @@ namespace nrEngine{
 
 		// store the resource in database
 		mResourceGroup[group].push_back(handle);
+		mResourceMapGeneration++;
 		mResource[handle] = holder;
 		mResourceName[name] = handle;
 
@@ -873,18 +2016,23 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	void ResourceManager::notifyCreated(IResource* res)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		notifyLoaded(res);
 	}
 
 	//----------------------------------------------------------------------------------
-	void ResourceManager::notifyUnloaded(IResource*)
+	void ResourceManager::notifyUnloaded(IResource* res)
 	{
-
+		DatabaseMutex::scoped_lock lock(mMutex);
+		mStatistics->recordUnload(res);
+		releaseDependencies(res);
+		if (res) forgetContent(res->getResourceHandle());
 	}
 
 	//----------------------------------------------------------------------------------
 	void ResourceManager::notifyRemove(IResource* res)
 	{
+		DatabaseMutex::scoped_lock lock(mMutex);
 		if (res == NULL) return;
 
 		// check if such a resource is already in the database
@@ -907,6 +2055,7 @@ namespace nrEngine{
 			ResourceGroupMap::iterator jt = mResourceGroup.find(group);
 			if (jt != mResourceGroup.end()){
 				jt->second.remove(handle);
+				mResourceMapGeneration++;
 
 				// check whenever group contains no more elements, and delete it
 				if (jt->second.size() == 0){
@@ -925,6 +2074,20 @@ namespace nrEngine{
 		}
 		holder->resetResource(NULL);
 
+		// holders sharing the instance are removed too
+		res_owner_map::iterator ot = mSharedOwner.find(handle);
+		if (ot != mSharedOwner.end())
+		{
+			std::list<ResourceHandle> aliases = ot->second;
+			for (std::list<ResourceHandle>::iterator at = aliases.begin(); at != aliases.end(); at++)
+				removeShared(*at);
+		}
+		forgetContent(handle);
+
+		// forget the dependency references
+		mDependencyRef.erase(handle);
+		mDependencyHolder.erase(handle);
+
 		// clear the database
 		mResourceName.erase(name);
 		mResource.erase(handle);
@@ -0,0 +1,261 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/ResourceStatistics.h>
+#include <nrEngine/Resource.h>
+#include <nrEngine/ResourceLoader.h>
+#include <nrEngine/ResourceManager.h>
+#include <nrEngine/Engine.h>
+#include <nrEngine/Metrics.h>
+
+namespace nrEngine {
+
+	const char* ResourceStatistics::LOADER_GROUP = "ResourceLoader:";
+	const char* ResourceStatistics::GROUP_GROUP = "ResourceGroup:";
+
+	//----------------------------------------------------------------------------------
+	LatencyHistogram::LatencyHistogram() : count(0), total(0), min(0), max(0)
+	{
+		for (int32 i=0; i < NR_RESOURCE_HISTOGRAM_BUCKETS; i++) buckets[i] = 0;
+	}
+
+	//----------------------------------------------------------------------------------
+	void LatencyHistogram::add(float64 seconds)
+	{
+		if (seconds < 0) seconds = 0;
+
+		// find the bucket, each one is twice as wide as the previous one
+		int32 b = 0;
+		float64 bound = 0.000001;
+		while (b < NR_RESOURCE_HISTOGRAM_BUCKETS - 1 && seconds >= bound){
+			bound *= 2.0;
+			b++;
+		}
+		buckets[b]++;
+
+		if (count == 0 || seconds < min) min = seconds;
+		if (count == 0 || seconds > max) max = seconds;
+		total += seconds;
+		count++;
+	}
+
+	//----------------------------------------------------------------------------------
+	void LatencyHistogram::add(const LatencyHistogram& h)
+	{
+		if (h.count == 0) return;
+
+		for (int32 i=0; i < NR_RESOURCE_HISTOGRAM_BUCKETS; i++) buckets[i] += h.buckets[i];
+
+		if (count == 0 || h.min < min) min = h.min;
+		if (count == 0 || h.max > max) max = h.max;
+		total += h.total;
+		count += h.count;
+	}
+
+	//----------------------------------------------------------------------------------
+	float64 LatencyHistogram::getPercentile(float32 part) const
+	{
+		if (count == 0) return 0;
+
+		uint32 limit = (uint32)ceil(part * (float32)count);
+		uint32 sum = 0;
+		float64 bound = 0.000001;
+		for (int32 i=0; i < NR_RESOURCE_HISTOGRAM_BUCKETS - 1; i++, bound *= 2.0){
+			sum += buckets[i];
+			if (sum >= limit) return bound < max ? bound : max;
+		}
+
+		return max;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCounters::ResourceCounters() : loads(0), reloads(0), unloads(0), evictions(0),
+		failures(0), cacheHits(0), cacheMisses(0), bytesLoaded(0), residentCount(0),
+		residentBytes(0), emptyHits(0)
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceStatistics::ResourceStatistics() : ITask()
+	{
+		setTaskName("ResourceStatistics");
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceStatistics::~ResourceStatistics()
+	{
+	}
+
+	//----------------------------------------------------------------------------------
+	const std::string& ResourceStatistics::getLoaderName(IResource* res)
+	{
+		static const std::string none("none");
+		if (res->mResLoader == NULL) return none;
+		return res->mResLoader->getName();
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::recordLoad(IResource* res, float64 seconds, bool success)
+	{
+		if (res == NULL) return;
+
+		// loads are rare, so the metrics of the loader are looked up each time
+		std::string label = Metrics::label("loader", getLoaderName(res));
+		Metrics* metrics = Engine::sMetrics();
+		if (success){
+			MetricCounter* loads = metrics->getCounter("nrengine_resource_loads_total", "Count of loaded resources", label);
+			MetricHistogram* time = metrics->getHistogram("nrengine_resource_load_seconds", "Duration of resource loads", label);
+			if (loads) loads->inc();
+			if (time) time->add(seconds);
+		}else{
+			MetricCounter* failures = metrics->getCounter("nrengine_resource_load_failures_total", "Count of failed resource loads", label);
+			if (failures) failures->inc();
+		}
+
+		boost::mutex::scoped_lock lock(mMutex);
+
+		ResourceCounters* c[2] = {&mLoader[getLoaderName(res)], &mGroup[res->getResourceGroup()]};
+		for (int32 i=0; i < 2; i++){
+			if (success){
+				c[i]->loads++;
+				c[i]->bytesLoaded += res->getResourceDataSize();
+				c[i]->loadTime.add(seconds);
+			}else
+				c[i]->failures++;
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::recordReload(IResource* res, float64 seconds, bool success)
+	{
+		if (res == NULL) return;
+		boost::mutex::scoped_lock lock(mMutex);
+
+		ResourceCounters* c[2] = {&mLoader[getLoaderName(res)], &mGroup[res->getResourceGroup()]};
+		for (int32 i=0; i < 2; i++){
+			if (success){
+				c[i]->reloads++;
+				c[i]->bytesLoaded += res->getResourceDataSize();
+				c[i]->reloadTime.add(seconds);
+			}else
+				c[i]->failures++;
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::recordUnload(IResource* res)
+	{
+		if (res == NULL) return;
+		boost::mutex::scoped_lock lock(mMutex);
+
+		mLoader[getLoaderName(res)].unloads++;
+		mGroup[res->getResourceGroup()].unloads++;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::recordEviction(IResource* res)
+	{
+		if (res == NULL) return;
+		boost::mutex::scoped_lock lock(mMutex);
+
+		mLoader[getLoaderName(res)].evictions++;
+		mGroup[res->getResourceGroup()].evictions++;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::recordCacheLookup(IResource* res, bool hit)
+	{
+		if (res == NULL) return;
+		boost::mutex::scoped_lock lock(mMutex);
+
+		ResourceCounters* c[2] = {&mLoader[getLoaderName(res)], &mGroup[res->getResourceGroup()]};
+		for (int32 i=0; i < 2; i++){
+			if (hit)
+				c[i]->cacheHits++;
+			else
+				c[i]->cacheMisses++;
+		}
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCounters ResourceStatistics::getLoader(const std::string& name)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		CounterMap::const_iterator it = mLoader.find(name);
+		if (it == mLoader.end()) return ResourceCounters();
+		return it->second;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceCounters ResourceStatistics::getGroup(const std::string& name)
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		CounterMap::const_iterator it = mGroup.find(name);
+		if (it == mGroup.end()) return ResourceCounters();
+		return it->second;
+	}
+
+	//----------------------------------------------------------------------------------
+	std::vector<std::string> ResourceStatistics::getLoaderNames()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		std::vector<std::string> names;
+		for (CounterMap::const_iterator it = mLoader.begin(); it != mLoader.end(); it++)
+			names.push_back(it->first);
+		return names;
+	}
+
+	//----------------------------------------------------------------------------------
+	std::vector<std::string> ResourceStatistics::getGroupNames()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		std::vector<std::string> names;
+		for (CounterMap::const_iterator it = mGroup.begin(); it != mGroup.end(); it++)
+			names.push_back(it->first);
+		return names;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStatistics::reset()
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		mLoader.clear();
+		mGroup.clear();
+	}
+
+	//----------------------------------------------------------------------------------
+	std::string ResourceStatistics::format(const std::string& name, const ResourceCounters& c)
+	{
+		char line[512];
+		sprintf(line, "%s: loads=%d reloads=%d unloads=%d evictions=%d failures=%d "
+			"cache=%d/%d resident=%d (%lu KB) loaded=%lu KB empty=%d "
+			"load=%.3f/%.3f/%.3f ms reload=%.3f/%.3f/%.3f ms",
+			name.c_str(), c.loads, c.reloads, c.unloads, c.evictions, c.failures,
+			c.cacheHits, c.cacheHits + c.cacheMisses, c.residentCount,
+			(unsigned long)(c.residentBytes / 1024), (unsigned long)(c.bytesLoaded / 1024), c.emptyHits,
+			c.loadTime.getMean() * 1000.0, c.loadTime.getPercentile(0.95f) * 1000.0, c.loadTime.max * 1000.0,
+			c.reloadTime.getMean() * 1000.0, c.reloadTime.getPercentile(0.95f) * 1000.0, c.reloadTime.max * 1000.0);
+		return std::string(line);
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceStatistics::updateTask()
+	{
+		Engine::sResourceManager()->updateStatistics();
+		return OK;
+	}
+
+};
@@ -0,0 +1,314 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/ResourceStreamer.h>
+#include <nrEngine/Engine.h>
+#include <nrEngine/Clock.h>
+#include <nrEngine/Log.h>
+
+namespace nrEngine {
+
+	//----------------------------------------------------------------------------------
+	bool ResourceStreamer::Candidate::operator < (const Candidate& c) const
+	{
+		// better priority is executed first
+		if (priority != c.priority) return priority < c.priority;
+
+		// loads are executed before unloads of the same priority
+		if (load != c.load) return load;
+
+		// hot resources are loaded first and unloaded last
+		if (load) return heat > c.heat;
+		return heat < c.heat;
+	}
+
+	//----------------------------------------------------------------------------------
+	// Order in which resources are unloaded to stay in the memory budget
+	//----------------------------------------------------------------------------------
+	static bool _evictOrder(const ResourceStreamer::Candidate& a, const ResourceStreamer::Candidate& b)
+	{
+		// worst priority and coldest resources first
+		if (a.priority != b.priority) return a.priority > b.priority;
+		return a.heat < b.heat;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceStreamer::ResourceStreamer() : ITask("ResourceStreamer")
+	{
+		mOpsPerTick = 4;
+		mMemoryBudget = 0;
+		mMemoryUsage = 0;
+		mSampleInterval = 0.5f;
+		mDecay = 0.5f;
+		mLastSample = -1.0;
+	}
+
+	//----------------------------------------------------------------------------------
+	ResourceStreamer::~ResourceStreamer()
+	{
+		if (mRequests.size())
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceStreamer: %d pending requests dropped", (int32)mRequests.size());
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::requestLoad(const std::string& name, const std::string& group,
+			const std::string& fileName, const std::string& resourceType)
+	{
+		Request& req = mRequests[name];
+		req.group = group;
+		req.fileName = fileName;
+		req.resourceType = resourceType;
+		req.load = true;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::requestUnload(const std::string& name)
+	{
+		Request& req = mRequests[name];
+		req.group.clear();
+		req.fileName.clear();
+		req.resourceType.clear();
+		req.load = false;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::cancelRequest(const std::string& name)
+	{
+		mRequests.erase(name);
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::setPriority(const std::string& name, const CPriority& priority)
+	{
+		mPriority[name] = (uint32)priority;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::setGroupPriority(const std::string& group, const CPriority& priority)
+	{
+		mGroupPriority[group] = (uint32)priority;
+	}
+
+	//----------------------------------------------------------------------------------
+	CPriority ResourceStreamer::getPriority(const std::string& name, const std::string& group) const
+	{
+		PriorityMap::const_iterator it = mPriority.find(name);
+		if (it != mPriority.end()) return CPriority(it->second);
+
+		it = mGroupPriority.find(group);
+		if (it != mGroupPriority.end()) return CPriority(it->second);
+
+		return CPriority(CPriority::NORMAL);
+	}
+
+	//----------------------------------------------------------------------------------
+	float32 ResourceStreamer::getHeat(const ResourceHandle& handle) const
+	{
+		StatMap::const_iterator it = mStats.find(handle);
+		if (it == mStats.end()) return 0;
+		return it->second.heat;
+	}
+
+	//----------------------------------------------------------------------------------
+	void ResourceStreamer::sample()
+	{
+		float64 now = Engine::sClock()->getTime();
+		if (mLastSample >= 0 && now - mLastSample < mSampleInterval) return;
+		mLastSample = now;
+
+		ResourceManager* mgr = Engine::sResourceManager();
+
+		// the loader threads change the database while it is walked
+		ResourceManager::DatabaseMutex::scoped_lock lock(mgr->mMutex);
+		const ResourceManager::ResourceGroupMap& groups = mgr->getResourceMap();
+
+		// statistics of removed resources are dropped
+		StatMap stats;
+		std::set<IResource*> counted;
+		mMemoryUsage = 0;
+
+		ResourceManager::ResourceGroupMap::const_iterator it = groups.begin();
+		for (; it != groups.end(); it++)
+		{
+			std::list<ResourceHandle>::const_iterator jt = it->second.begin();
+			for (; jt != it->second.end(); jt++)
+			{
+				SharedPtr<ResourceHolder>* holder = mgr->getHolderByHandle(*jt);
+				if (holder == NULL) continue;
+
+				// decay the old accesses and add the new ones
+				uint32 count = (*holder)->getAccessCount();
+				Stat& stat = stats[*jt];
+				StatMap::const_iterator st = mStats.find(*jt);
+				if (st != mStats.end())
+					stat.heat = st->second.heat * mDecay + (float32)(count - st->second.lastCount);
+				else
+					stat.heat = (float32)count;
+				stat.lastCount = count;
+
+				// shared instances are counted only once
+				IResource* res = (*holder)->mResource;
+				if (res && res->isResourceLoaded() && counted.insert(res).second)
+					mMemoryUsage += res->getResourceDataSize();
+			}
+		}
+
+		mStats.swap(stats);
+	}
+
+	//----------------------------------------------------------------------------------
+	uint32 ResourceStreamer::evict(uint32 maxOps)
+	{
+		if (mMemoryBudget == 0 || mMemoryUsage <= mMemoryBudget || maxOps == 0) return 0;
+
+		ResourceManager* mgr = Engine::sResourceManager();
+		ResourceManager::DatabaseMutex::scoped_lock lock(mgr->mMutex);
+
+		// all loaded resources which can be unloaded to free the memory
+		std::vector<Candidate> candidates;
+		for (StatMap::const_iterator it = mStats.begin(); it != mStats.end(); it++)
+		{
+			SharedPtr<ResourceHolder>* holder = mgr->getHolderByHandle(it->first);
+			if (holder == NULL || (*holder)->isLocked()) continue;
+
+			IResource* res = (*holder)->mResource;
+			if (res == NULL || !res->isResourceLoaded() || res->getResourceDataSize() == 0) continue;
+
+			// unloading a shared instance through one of its names does not free any memory
+			if (mgr->isShared(it->first)) continue;
+
+			// resources requested to be loaded stay in the memory
+			RequestMap::const_iterator rt = mRequests.find(res->getResourceName());
+			if (rt != mRequests.end() && rt->second.load) continue;
+
+			Candidate c;
+			c.name = res->getResourceName();
+			c.priority = (uint32)getPriority(c.name, res->getResourceGroup());
+			c.heat = it->second.heat;
+			c.load = false;
+			candidates.push_back(c);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), _evictOrder);
+
+		uint32 ops = 0;
+		std::vector<Candidate>::const_iterator ct = candidates.begin();
+		for (; ct != candidates.end() && ops < maxOps && mMemoryUsage > mMemoryBudget; ct++)
+		{
+			SharedPtr<ResourceHolder>* holder = mgr->getHolderByName(ct->name);
+			if (holder == NULL || (*holder)->mResource == NULL) continue;
+
+			size_t size = (*holder)->mResource->getResourceDataSize();
+			NR_LogDebug(Log::LOG_ENGINE, "ResourceStreamer: Memory budget exceeded, unload %s (%d bytes)", ct->name.c_str(), (int32)size);
+
+			IResource* res = (*holder)->mResource;
+			if (mgr->unload(ct->name) == OK){
+				mgr->getStatistics().recordEviction(res);
+				mMemoryUsage = mMemoryUsage > size ? mMemoryUsage - size : 0;
+			}
+			ops++;
+		}
+
+		return ops;
+	}
+
+	//----------------------------------------------------------------------------------
+	uint32 ResourceStreamer::processRequests(uint32 maxOps)
+	{
+		if (mRequests.size() == 0 || maxOps == 0) return 0;
+
+		ResourceManager* mgr = Engine::sResourceManager();
+
+		// rank all pending requests, the lock is released before they are
+		// executed, so the manager can load the resources in parallel
+		std::vector<Candidate> candidates;
+		candidates.reserve(mRequests.size());
+		{
+			ResourceManager::DatabaseMutex::scoped_lock lock(mgr->mMutex);
+			for (RequestMap::const_iterator it = mRequests.begin(); it != mRequests.end(); it++)
+			{
+				Candidate c;
+				c.name = it->first;
+				c.load = it->second.load;
+				c.heat = 0;
+
+				std::string group = it->second.group;
+				SharedPtr<ResourceHolder>* holder = mgr->getHolderByName(c.name);
+				if (holder && (*holder)->mResource)
+				{
+					c.heat = getHeat((*holder)->mResource->getResourceHandle());
+					group = (*holder)->mResource->getResourceGroup();
+				}
+				c.priority = (uint32)getPriority(c.name, group);
+
+				candidates.push_back(c);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+
+		// execute the best ranked requests, requests which need nothing to be
+		// done are dropped without counting them
+		uint32 ops = 0;
+		for (uint32 i = 0; i < candidates.size() && ops < maxOps; i++)
+		{
+			const Candidate& c = candidates[i];
+			RequestMap::iterator rt = mRequests.find(c.name);
+			Request req = rt->second;
+			mRequests.erase(rt);
+
+			// resident resources and resources decoded by the loader threads are not loaded again
+			bool registered = false, loaded = false;
+			if (req.load)
+			{
+				ResourceManager::DatabaseMutex::scoped_lock lock(mgr->mMutex);
+				SharedPtr<ResourceHolder>* holder = mgr->getHolderByName(c.name);
+				IResource* res = holder ? (*holder)->mResource : NULL;
+				registered = holder != NULL;
+				loaded = res && (res->isResourceLoaded() || mgr->isResourceLoading(res->getResourceHandle()));
+			}
+			if (loaded) continue;
+
+			Result ret = OK;
+			if (!req.load)
+				ret = mgr->unload(c.name);
+			else if (registered)
+				ret = mgr->reload(c.name);
+			else if (mgr->loadResource(c.name, req.group, req.fileName, req.resourceType).isNull())
+				ret = RES_NOT_FOUND;
+			ops++;
+
+			if (ret != OK)
+				NR_Log(Log::LOG_ENGINE, Log::LL_WARNING, "ResourceStreamer: Can not %s resource %s", req.load ? "load" : "unload", c.name.c_str());
+		}
+
+		return ops;
+	}
+
+	//----------------------------------------------------------------------------------
+	Result ResourceStreamer::updateTask()
+	{
+		sample();
+
+		// free the memory before new resources are loaded
+		uint32 ops = evict(mOpsPerTick);
+		processRequests(mOpsPerTick - ops);
+
+		return OK;
+	}
+
+};
+
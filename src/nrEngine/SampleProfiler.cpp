@@ -0,0 +1,264 @@
+/***************************************************************************
+ *                                                                         *
+ *   (c) Art Tevs, MPI Informatik Saarbruecken                             *
+ *       mailto: <tevs@mpi-sb.mpg.de>                                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+//----------------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------------
+#include <nrEngine/SampleProfiler.h>
+#include <nrEngine/Log.h>
+#include <fstream>
+
+#if NR_PLATFORM == NR_PLATFORM_LINUX
+#	include <signal.h>
+#	include <errno.h>
+#	include <sys/time.h>
+#	include <execinfo.h>
+#	include <dlfcn.h>
+#	include <cxxabi.h>
+#endif
+
+namespace nrEngine{
+
+#if NR_PLATFORM == NR_PLATFORM_LINUX
+	//----------------------------------------------------------------------------------
+	// Task updated by the thread, read by the signal handler. Only the thread local
+	// storage of the compiler can be read safely in a signal handler.
+	//----------------------------------------------------------------------------------
+	static __thread ProfileZone _currentTask = NR_PROFILE_NO_ZONE;
+#endif
+
+	//----------------------------------------------------------------------------------
+	// The running sample profiler, signals are delivered to the whole process
+	//----------------------------------------------------------------------------------
+	static boost::atomic<SampleProfiler*> _runningProfiler(NULL);
+
+	//----------------------------------------------------------------------------------
+	// Frames of the signal handler and of the signal trampoline on top of a sample
+	//----------------------------------------------------------------------------------
+	static const int32 NR_SAMPLE_SKIP_FRAMES = 2;
+
+#if NR_PLATFORM == NR_PLATFORM_LINUX
+	//----------------------------------------------------------------------------------
+	// Signal action replaced by the sampling
+	//----------------------------------------------------------------------------------
+	static struct sigaction _oldAction;
+#endif
+
+	//----------------------------------------------------------------------------------
+	SampleProfiler::SampleProfiler() : mNext(0), mDropped(0), mRunning(false)
+	{
+
+	}
+
+	//----------------------------------------------------------------------------------
+	SampleProfiler::~SampleProfiler()
+	{
+		stop();
+	}
+
+	//----------------------------------------------------------------------------------
+	ProfileZone SampleProfiler::enterTask(ProfileZone task)
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		ProfileZone previous = _currentTask;
+		_currentTask = task;
+		return previous;
+	#else
+		// sampling is not supported, so the task is not needed
+		return NR_PROFILE_NO_ZONE;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	void SampleProfiler::leaveTask(ProfileZone previous)
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		_currentTask = previous;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	Result SampleProfiler::start(uint32 frequency, uint32 maxSamples)
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		if (frequency == 0 || maxSamples == 0) return BAD_PARAMETERS;
+
+		// only one profiler can get the signals
+		SampleProfiler* expected = NULL;
+		if (!_runningProfiler.compare_exchange_strong(expected, this)){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "SampleProfiler: Sampling is already running");
+			return PROFILE_CAPTURE_RUNNING;
+		}
+
+		// the buffer is allocated here, the signal handler must not allocate memory
+		mSamples.resize(maxSamples);
+		mNext = 0;
+		mDropped = 0;
+
+		// the first backtrace loads the unwinder, so it has not to be done in the handler
+		void* frames[NR_SAMPLE_STACK_DEPTH];
+		backtrace(frames, NR_SAMPLE_STACK_DEPTH);
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = signalHandler;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGPROF, &action, &_oldAction);
+
+		uint32 usec = 1000000 / frequency;
+		if (usec == 0) usec = 1;
+
+		struct itimerval timer;
+		timer.it_interval.tv_sec = usec / 1000000;
+		timer.it_interval.tv_usec = usec % 1000000;
+		timer.it_value = timer.it_interval;
+		if (setitimer(ITIMER_PROF, &timer, NULL) != 0){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "SampleProfiler: Can not start the profiling timer");
+			sigaction(SIGPROF, &_oldAction, NULL);
+			_runningProfiler = NULL;
+			return PROFILE_ERROR;
+		}
+
+		NR_Log(Log::LOG_ENGINE, "SampleProfiler: Start sampling with %d Hz, up to %d samples", frequency, maxSamples);
+		mRunning = true;
+		return OK;
+	#else
+		NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "SampleProfiler: Sampling is not supported on this platform");
+		return PROFILE_ERROR;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	void SampleProfiler::stop()
+	{
+		if (!mRunning) return;
+
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		struct itimerval timer;
+		memset(&timer, 0, sizeof(timer));
+		setitimer(ITIMER_PROF, &timer, NULL);
+		sigaction(SIGPROF, &_oldAction, NULL);
+	#endif
+
+		_runningProfiler = NULL;
+		mRunning = false;
+
+		NR_Log(Log::LOG_ENGINE, "SampleProfiler: Sampling stopped, %d samples, %d dropped", getSampleCount(), (uint32)mDropped);
+	}
+
+	//----------------------------------------------------------------------------------
+	uint32 SampleProfiler::getSampleCount() const
+	{
+		uint32 count = mNext;
+		return count < mSamples.size() ? count : mSamples.size();
+	}
+
+	//----------------------------------------------------------------------------------
+	void SampleProfiler::signalHandler(int sig)
+	{
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		// the stack is taken here, so the handler is always the first frame
+		SampleProfiler* profiler = _runningProfiler;
+		if (profiler == NULL) return;
+
+		int err = errno;
+
+		uint32 i = profiler->mNext.fetch_add(1, boost::memory_order_relaxed);
+		if (i >= profiler->mSamples.size()){
+			profiler->mDropped.fetch_add(1, boost::memory_order_relaxed);
+			errno = err;
+			return;
+		}
+
+		Sample& s = profiler->mSamples[i];
+		s.task = _currentTask;
+		s.depth = backtrace(s.frames, NR_SAMPLE_STACK_DEPTH);
+
+		errno = err;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	// Get name of the function containing the address
+	//----------------------------------------------------------------------------------
+	static std::string _frameName(void* address)
+	{
+		char name[64];
+		sprintf(name, "%p", address);
+
+	#if NR_PLATFORM == NR_PLATFORM_LINUX
+		Dl_info info;
+		if (dladdr(address, &info) == 0) return name;
+
+		// functions without a dynamic symbol are named by their module
+		if (info.dli_sname == NULL){
+			std::string module = info.dli_fname ? info.dli_fname : "";
+			std::string::size_type pos = module.rfind('/');
+			if (pos != std::string::npos) module = module.substr(pos + 1);
+			sprintf(name, "+0x%lx", (unsigned long)((char*)address - (char*)info.dli_fbase));
+			return "[" + module + name + "]";
+		}
+
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+		std::string res = (status == 0 && demangled) ? demangled : info.dli_sname;
+		free(demangled);
+
+		// the frames are separated by semicolons in the folded format
+		for (std::string::size_type i = 0; i < res.length(); i++)
+			if (res[i] == ';') res[i] = ':';
+		return res;
+	#else
+		return name;
+	#endif
+	}
+
+	//----------------------------------------------------------------------------------
+	Result SampleProfiler::writeFolded(const std::string& fileName)
+	{
+		if (mRunning) return PROFILE_CAPTURE_RUNNING;
+
+		std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+		if (!file.is_open()){
+			NR_Log(Log::LOG_ENGINE, Log::LL_ERROR, "SampleProfiler: Can not write the samples into %s", fileName.c_str());
+			return FILE_ERROR;
+		}
+
+		// count the samples of each stack, the names are resolved once per address
+		std::map<void*, std::string> names;
+		std::map<std::string, uint32> stacks;
+		uint32 count = getSampleCount();
+		for (uint32 i = 0; i < count; i++){
+			const Sample& s = mSamples[i];
+
+			std::string stack = s.task == NR_PROFILE_NO_ZONE ? "[no task]" : Profiler::getZoneName(s.task);
+			for (int32 j = s.depth - 1; j >= NR_SAMPLE_SKIP_FRAMES; j--){
+				std::map<void*, std::string>::iterator it = names.find(s.frames[j]);
+				if (it == names.end())
+					it = names.insert(std::make_pair(s.frames[j], _frameName(s.frames[j]))).first;
+				stack += ";" + it->second;
+			}
+			stacks[stack]++;
+		}
+
+		std::map<std::string, uint32>::const_iterator it;
+		for (it = stacks.begin(); it != stacks.end(); it++)
+			file << it->first << " " << it->second << "\n";
+
+		NR_Log(Log::LOG_ENGINE, "SampleProfiler: Wrote %d samples in %d stacks into %s", count, (uint32)stacks.size(), fileName.c_str());
+		return OK;
+	}
+
+}; // end namespace
+
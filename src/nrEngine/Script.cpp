@@ -19,6 +19,7 @@
 #include <nrEngine/Clock.h>
 #include <nrEngine/Log.h>
 #include <nrEngine/Kernel.h>
+#include <nrEngine/LineReader.h>
 #include <boost/algorithm/string/trim.hpp>
 
 namespace nrEngine {
@@ -66,39 +67,38 @@ namespace nrEngine {
 	std::string Script::cleanScript(const std::string& script)
 	{
 		// check the lenght of the script
-		std::stringstream str(script);
-		if (script.length() == 0 || !str.good()) return script;
+		if (script.length() == 0) return script;
 		std::string resultScript;
+		resultScript.reserve(script.length());
 
 		// get linewise
-		char buf[2048];
-		std::string buffer;
-		std::string::size_type pos;
-		std::string line;
+		LineReader reader(script.c_str(), script.length());
+		LineReader::Line line;
 
-		// for the whole stream do following
-		while (!str.eof())
+		// for the whole script do following
+		while (reader.readLine(line))
 		{
-			// get line
-			str.getline(buf, 2048);
-			buffer = std::string(buf);
+			const char* begin = line.data;
+			const char* end = line.data + line.length;
 
 			// remove comments
-			pos = buffer.find("//");
-			if (pos == std::string::npos)
-				line = buffer;
-			else
-				line = buffer.substr(0, pos);
+			for (const char* c = begin; c + 1 < end; c++){
+				if (c[0] == '/' && c[1] == '/'){
+					end = c;
+					break;
+				}
+			}
 
 			// trim the line
-			boost::algorithm::trim(line);
+			while (begin < end && isspace((byte)*begin)) begin++;
+			while (end > begin && isspace((byte)*(end-1))) end--;
 
 			// if the line is empty, so get the next one
-			if (line.length() == 0) continue;
+			if (begin == end) continue;
 
 			// if we are here, so we do not have any comments or empty lines
-			resultScript += line;
-			if (!str.eof()) resultScript += std::string("\n");
+			resultScript.append(begin, end - begin);
+			if (!reader.eof()) resultScript += '\n';
 		}
 
 		return resultScript;
@@ -237,20 +237,19 @@ namespace nrEngine {
 	{
 		// remove all non-commands from the script
 		// check for subscripts
-		std::stringstream str(parseSubscripts(cleanScript(script)));
-		if (script.length() == 0 || !str.good()) return OK;
+		std::string content = parseSubscripts(cleanScript(script));
+		if (script.length() == 0) return OK;
 
-		//printf("%s: \n%s\n---\n\n", getResourceName().c_str(),str.str().c_str());
 		// get linewise
-		char buf[1024];
+		LineReader reader(content.c_str(), content.length());
+		LineReader::Line view;
 		std::string::size_type pos;
 		std::string line;
 
-		while (!str.eof())
+		while (reader.readLine(view))
 		{
 			// get line
-			str.getline(buf, 1024);
-			line = std::string(buf);
+			line.assign(view.data, view.length);
 
 			// check for script parameters
 			pos = line.find('^');
@@ -467,7 +466,7 @@ namespace nrEngine {
 				ScriptResult res = Engine::sScriptEngine()->call(mTimedCommand[id].cmd, mTimedCommand[id].args);
                 if (res.size())
                 {
-                    NR_Log(Log::LOG_CONSOLE, Log::LL_DEBUG, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
+                    NR_LogDebug(Log::LOG_CONSOLE, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
                 }
 			}else
 				it ++;
@@ -486,7 +485,7 @@ namespace nrEngine {
 				ScriptResult res = Engine::sScriptEngine()->call(mCommand[id].cmd, mCommand[id].args);
                 if (res.size())
                 {
-                    NR_Log(Log::LOG_CONSOLE, Log::LL_DEBUG, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
+                    NR_LogDebug(Log::LOG_CONSOLE, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
                 }
 			}else{
 				Engine::sKernel()->RemoveTask(this->getTaskID());
@@ -563,7 +562,7 @@ namespace nrEngine {
                 // check for return code
                 if (res.size())
                 {
-                    NR_Log(Log::LOG_CONSOLE, Log::LL_DEBUG, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
+                    NR_LogDebug(Log::LOG_CONSOLE, "%s: %s", getResourceName().c_str(), (res.get<std::string>(0)).c_str());
                 }
 			}
 
@@ -16,10 +16,12 @@
 //----------------------------------------------------------------------------------
 #include <nrEngine/ScriptEngine.h>
 #include <nrEngine/Log.h>
+#include <nrEngine/GetTime.h>
 #include <nrEngine/events/EngineEvent.h>
 #include <nrEngine/EventManager.h>
 #include <nrEngine/VariadicArgument.h>
 #include <nrEngine/IScript.h>
+#include <nrEngine/Metrics.h>
 
 namespace nrEngine{
 
@@ -155,6 +157,9 @@ namespace nrEngine{
 		mDatabase["scriptExecute"].first = scriptRun;
 		mDatabase["scriptCall"].first = scriptCall;
 		mDatabase["scriptLoadAndRun"].first = scriptLoadAndRun;
+
+		mCallCount = Engine::sMetrics()->getCounter("nrengine_script_calls_total", "Count of script function calls");
+		mCallTime = Engine::sMetrics()->getHistogram("nrengine_script_call_seconds", "Duration of script function calls");
 	}
 
 	//----------------------------------------------------------------------------------
@@ -177,7 +182,7 @@ namespace nrEngine{
 		mDatabase[name].second = param;
 
 		// some statistical information
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ScriptEngine: New function \"%s\" registered", name.c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "ScriptEngine: New function \"%s\" registered", name.c_str());
 
 		// emit a new event
 		SharedPtr<Event> msg(new ScriptRegisterFunctionEvent(name, func));
@@ -207,7 +212,7 @@ namespace nrEngine{
 		mDatabase.erase(it);
 
 		// some statistical information
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ScriptEngine: Function \"%s\" was removed", name.c_str());
+		NR_LogDebug(Log::LOG_ENGINE, "ScriptEngine: Function \"%s\" was removed", name.c_str());
 
 		// emit a new event
 		SharedPtr<Event> msg(new ScriptRemoveFunctionEvent(name));
@@ -226,13 +231,21 @@ namespace nrEngine{
 			return ScriptResult();
 		}
 		
-		// debug information 
-		std::string msg;
-		for (unsigned int i=1; i < args.size(); i++) msg += std::string(" ") + args[i];
-		NR_Log(Log::LOG_ENGINE, Log::LL_DEBUG, "ScriptEngine: Call \"%s (%s)\" function!", name.c_str(), msg.c_str());
+		// debug information, the arguments are only joined if they are logged
+		if (Engine::sLog()->isLogged(Log::LOG_ENGINE, Log::LL_DEBUG)){
+			std::string msg;
+			for (unsigned int i=1; i < args.size(); i++) msg += std::string(" ") + args[i];
+			NR_LogDebug(Log::LOG_ENGINE, "ScriptEngine: Call \"%s (%s)\" function!", name.c_str(), msg.c_str());
+		}
 
 		// call the function
-		return ((*f).second).first(args, (*f).second.second);
+		uint64 start = getMonotonicTime();
+		ScriptResult res = ((*f).second).first(args, (*f).second.second);
+
+		if (mCallCount) mCallCount->inc();
+		if (mCallTime) mCallTime->addNanoseconds(getMonotonicTime() - start);
+
+		return res;
 	}
 
 	//----------------------------------------------------------------------------------
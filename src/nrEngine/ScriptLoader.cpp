@@ -16,7 +16,9 @@
 //----------------------------------------------------------------------------------
 #include <nrEngine/ScriptLoader.h>
 #include <nrEngine/Log.h>
-#include <nrEngine/FileStream.h>
+#include <nrEngine/MemoryStream.h>
+#include <nrEngine/FileSystemManager.h>
+#include <nrEngine/Engine.h>
 #include <nrEngine/Kernel.h>
 
 namespace nrEngine{
@@ -58,22 +60,26 @@ namespace nrEngine{
 	//----------------------------------------------------------------------------------
 	Result ScriptLoader::loadResource(IResource* res, const std::string& fileName, PropertyList* param)
 	{
-		// load a file so we use its content as a script
-		FileStream* fStream = new FileStream();
-		Result ret = fStream->open(fileName);
-		if (ret == OK){
-
-			// get the whole file content
-			std::string str = fStream->getAsString();
-
-			// cast the resource to the iscript interface
-			IScript* scr = dynamic_cast<IScript*>(res);
+		// load a file through the virtual file system, so we use its content as a script
+		SharedPtr<FileStream> fStream = Engine::sFileSystemManager()->open(fileName);
+		if (!fStream) return FILE_NOT_FOUND;
+
+		// get the whole file content, directly from the memory if possible
+		std::string str;
+		MemoryStream* mem = dynamic_cast<MemoryStream*>(fStream.get());
+		if (mem){
+			size_t size = 0;
+			const char* data = (const char*)mem->getData(size);
+			if (data) str.assign(data, size);
+		}else{
+			str = fStream->getAsString();
+		}
 
-			// load the script from a string
-			ret = scr->loadFromString(str);
+		// cast the resource to the iscript interface
+		IScript* scr = dynamic_cast<IScript*>(res);
 
-		}
-		delete fStream;
+		// load the script from a string
+		Result ret = scr->loadFromString(str);
 
 		// return the last error
 		return ret;
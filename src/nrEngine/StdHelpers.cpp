@@ -126,5 +126,112 @@ namespace nrEngine{
 		return result;
 	}
 
+	//-------------------------------------------------------------------------
+	// Primes and helpers of the xxHash64 algorithm
+	//-------------------------------------------------------------------------
+	static const uint64 XXH_PRIME1 = 11400714785074694791ULL;
+	static const uint64 XXH_PRIME2 = 14029467366897019727ULL;
+	static const uint64 XXH_PRIME3 =  1609587929392839161ULL;
+	static const uint64 XXH_PRIME4 =  9650029242287828579ULL;
+	static const uint64 XXH_PRIME5 =  2870177450012600261ULL;
+
+	static NR_FORCEINLINE uint64 xxhRotl(uint64 x, int32 r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	static NR_FORCEINLINE uint64 xxhRead64(const byte* p)
+	{
+		uint64 v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static NR_FORCEINLINE uint32 xxhRead32(const byte* p)
+	{
+		uint32 v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static NR_FORCEINLINE uint64 xxhRound(uint64 acc, uint64 input)
+	{
+		acc += input * XXH_PRIME2;
+		acc = xxhRotl(acc, 31);
+		return acc * XXH_PRIME1;
+	}
+
+	static NR_FORCEINLINE uint64 xxhMerge(uint64 acc, uint64 val)
+	{
+		acc ^= xxhRound(0, val);
+		return acc * XXH_PRIME1 + XXH_PRIME4;
+	}
+
+	//-------------------------------------------------------------------------
+	uint64 hashData(const void* data, size_t size, uint64 seed)
+	{
+		const byte* p = (const byte*)data;
+		const byte* end = p + size;
+		uint64 h;
+
+		// process blocks of 32 bytes in four independent lanes
+		if (size >= 32)
+		{
+			const byte* limit = end - 32;
+			uint64 v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+			uint64 v2 = seed + XXH_PRIME2;
+			uint64 v3 = seed;
+			uint64 v4 = seed - XXH_PRIME1;
+
+			do{
+				v1 = xxhRound(v1, xxhRead64(p)); p += 8;
+				v2 = xxhRound(v2, xxhRead64(p)); p += 8;
+				v3 = xxhRound(v3, xxhRead64(p)); p += 8;
+				v4 = xxhRound(v4, xxhRead64(p)); p += 8;
+			}while (p <= limit);
+
+			h = xxhRotl(v1, 1) + xxhRotl(v2, 7) + xxhRotl(v3, 12) + xxhRotl(v4, 18);
+			h = xxhMerge(h, v1);
+			h = xxhMerge(h, v2);
+			h = xxhMerge(h, v3);
+			h = xxhMerge(h, v4);
+		}else{
+			h = seed + XXH_PRIME5;
+		}
+
+		h += (uint64)size;
+
+		// process the remaining bytes
+		while (p + 8 <= end)
+		{
+			h ^= xxhRound(0, xxhRead64(p));
+			h = xxhRotl(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+			p += 8;
+		}
+
+		if (p + 4 <= end)
+		{
+			h ^= (uint64)xxhRead32(p) * XXH_PRIME1;
+			h = xxhRotl(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+			p += 4;
+		}
+
+		while (p < end)
+		{
+			h ^= (*p) * XXH_PRIME5;
+			h = xxhRotl(h, 11) * XXH_PRIME1;
+			p++;
+		}
+
+		// final mixing
+		h ^= h >> 33;
+		h *= XXH_PRIME2;
+		h ^= h >> 29;
+		h *= XXH_PRIME3;
+		h ^= h >> 32;
+
+		return h;
+	}
+
 }; // end namespace
 